@@ -12,6 +12,7 @@
 #define DUET_TEMPS_BED_CURRENT  "current"
 #define DUET_TEMPS_BED_STATE  "state"
 #define DUET_TEMPS_BED_HEATER  "heater"
+#define DUET_TEMPS_CHAMBER  "chamber"
 #define DUET_TOOLS              "tools"
 #define DUET_TEMPS_TOOLS        DUET_TOOLS
 #define DUET_MCU_TEMP   "mcutemp"
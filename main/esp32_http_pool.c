@@ -0,0 +1,271 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#include <string.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp32_http_pool.h"
+#include "rrf_objects.h"
+
+#define TAG "HttpPool"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0)
+#define HTTP_POOL_SET_TIMEOUT   // timeout can be changed per request. Older clients are bound to their timeout
+#endif
+
+static http_pool_conn_t http_pool[HTTP_POOL_SIZE];
+static SemaphoreHandle_t http_pool_mutex = NULL;
+static SemaphoreHandle_t http_pool_free_cnt = NULL;
+static char http_pool_session_key[REPRAP_MAX_SESSION_KEY_LEN];     // protected by http_pool_mutex
+
+/**
+ * Make sure the response buffer can hold at least size bytes. Prefers SPI-RAM
+ * @return false if the buffer can not grow any further
+ */
+bool http_pool_buff_reserve(wifi_response_buff_t *buff, int size) {
+    if (size <= buff->buf_size) return true;
+    if (size > JSON_BUFF_MAX_SIZE) return false;
+    int new_size = buff->buf_size > 0 ? buff->buf_size : JSON_BUFF_SIZE;
+    while (new_size < size) new_size *= 2;
+    if (new_size > JSON_BUFF_MAX_SIZE) new_size = JSON_BUFF_MAX_SIZE;
+    char *new_buffer = NULL;
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+    new_buffer = heap_caps_realloc(buff->buffer, new_size, MALLOC_CAP_SPIRAM);
+#endif
+    if (new_buffer == NULL) new_buffer = realloc(buff->buffer, new_size);
+    if (new_buffer == NULL) return false;
+    if (buff->buffer == NULL) new_buffer[0] = '\0';
+    buff->buffer = new_buffer;
+    buff->buf_size = new_size;
+    return true;
+}
+
+/**
+ * Append data to the response buffer and keep it NULL terminated. Grows the buffer if necessary
+ * @return false if the data does not fit. Buffer stays untouched
+ */
+bool http_pool_buff_append(wifi_response_buff_t *buff, const char *data, int len) {
+    if (!http_pool_buff_reserve(buff, buff->buf_pos + len + 1)) return false;
+    memcpy(&buff->buffer[buff->buf_pos], data, len);
+    buff->buf_pos += len;
+    buff->buffer[buff->buf_pos] = '\0';
+    return true;
+}
+
+/**
+ * Set up an empty response buffer. Memory is allocated with the first request
+ */
+void http_pool_buff_init(wifi_response_buff_t *buff) {
+    buff->buffer = NULL;
+    buff->buf_pos = 0;
+    buff->buf_size = 0;
+}
+
+void http_pool_buff_free(wifi_response_buff_t *buff) {
+    free(buff->buffer);
+    http_pool_buff_init(buff);
+}
+
+static esp_err_t http_pool_event_handle(esp_http_client_event_t *evt) {
+    if (esp_http_client_get_status_code(evt->client) == 401) {
+        ESP_LOGW(TAG, "Need to authorise first. Ignoring data.");
+        return ESP_OK;
+    }
+    http_pool_conn_t *conn = (http_pool_conn_t *) evt->user_data;
+    wifi_response_buff_t *resp_buff = conn->resp_buff;
+    if (resp_buff == NULL) return ESP_OK;
+    switch (evt->event_id) {
+        case HTTP_EVENT_ERROR:
+            ESP_LOGI(TAG, "Event handler detected http error");
+            break;
+        case HTTP_EVENT_ON_CONNECTED:
+            resp_buff->buf_pos = 0;
+            break;
+        case HTTP_EVENT_HEADER_SENT:
+        case HTTP_EVENT_ON_HEADER:
+            break;
+        case HTTP_EVENT_ON_DATA:
+            // esp_http_client hands over the decoded body of chunked responses as well
+            if (conn->consumer != NULL && esp_http_client_get_status_code(evt->client) == 200) {
+                conn->consumer->feed(conn->consumer_ctx, (char *) evt->data, evt->data_len);
+            } else if (!conn->truncated && !http_pool_buff_append(resp_buff, (char *) evt->data, evt->data_len)) {
+                ESP_LOGE(TAG, "Response exceeds %i bytes. Dropping remaining data!", JSON_BUFF_MAX_SIZE);
+                conn->truncated = true;
+            }
+            break;
+        case HTTP_EVENT_ON_FINISH:
+            break;
+        case HTTP_EVENT_DISCONNECTED:
+            // Keep the data. The Duet may close the connection right after sending the response
+            break;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Create the pool. Connections are set up lazily on first use. Call once before any request is made.
+ */
+void http_pool_init() {
+    memset(http_pool, 0, sizeof(http_pool));
+    http_pool_mutex = xSemaphoreCreateMutex();
+    http_pool_free_cnt = xSemaphoreCreateCounting(HTTP_POOL_SIZE, HTTP_POOL_SIZE);
+    configASSERT(http_pool_mutex);
+    configASSERT(http_pool_free_cnt);
+}
+
+/**
+ * Send the session key the Duet handed out with rr_connect or /machine/connect along with all further requests
+ * @param session_key Empty string to stop sending one
+ */
+void http_pool_set_session_key(const char *session_key) {
+    xSemaphoreTake(http_pool_mutex, portMAX_DELAY);
+    strlcpy(http_pool_session_key, session_key, sizeof(http_pool_session_key));
+    xSemaphoreGive(http_pool_mutex);
+}
+
+/**
+ * Get a connection from the pool and point it at the URL. Prefers connections that are already open.
+ * Must be handed back using http_pool_release()
+ * @param url Full URL of the request
+ * @param timeout_ms Request timeout
+ * @param resp_buff Buffer the response body gets written to
+ * @return Connection or NULL if all connections are busy
+ */
+http_pool_conn_t *http_pool_acquire(const char *url, int timeout_ms, wifi_response_buff_t *resp_buff) {
+    if (xSemaphoreTake(http_pool_free_cnt, pdMS_TO_TICKS(HTTP_POOL_ACQUIRE_TIMEOUT)) != pdTRUE) {
+        ESP_LOGE(TAG, "No free HTTP connection available");
+        return NULL;
+    }
+    xSemaphoreTake(http_pool_mutex, portMAX_DELAY);
+    http_pool_conn_t *conn = NULL;
+    for (int i = 0; i < HTTP_POOL_SIZE && conn == NULL; i++) {     // open connection
+#ifdef HTTP_POOL_SET_TIMEOUT
+        if (!http_pool[i].in_use && http_pool[i].client != NULL)
+#else
+        if (!http_pool[i].in_use && http_pool[i].client != NULL && http_pool[i].timeout_ms == timeout_ms)
+#endif
+            conn = &http_pool[i];
+    }
+    for (int i = 0; i < HTTP_POOL_SIZE && conn == NULL; i++) {     // unused slot
+        if (!http_pool[i].in_use && http_pool[i].client == NULL)
+            conn = &http_pool[i];
+    }
+    for (int i = 0; i < HTTP_POOL_SIZE && conn == NULL; i++) {     // slot with different timeout
+        if (!http_pool[i].in_use) {
+            esp_http_client_cleanup(http_pool[i].client);
+            http_pool[i].client = NULL;
+            conn = &http_pool[i];
+        }
+    }
+    conn->in_use = true;
+    xSemaphoreGive(http_pool_mutex);
+
+    conn->resp_buff = resp_buff;
+    conn->consumer = NULL;
+    conn->consumer_ctx = NULL;
+    if (conn->client == NULL) {
+        esp_http_client_config_t config = {
+                .url = url,
+                .timeout_ms = timeout_ms,
+                .event_handler = http_pool_event_handle,
+                .user_data = conn,
+        };
+        conn->client = esp_http_client_init(&config);
+        if (conn->client == NULL) {
+            ESP_LOGE(TAG, "Failed to init HTTP client");
+            http_pool_release(conn, false);
+            return NULL;
+        }
+        esp_http_client_set_header(conn->client, "Connection", "keep-alive");
+        conn->timeout_ms = timeout_ms;
+        conn->used_before = false;
+    } else if (esp_http_client_set_url(conn->client, url) != ESP_OK) {
+        ESP_LOGE(TAG, "Invalid URL %s", url);
+        http_pool_release(conn, false);
+        return NULL;
+    }
+#ifdef HTTP_POOL_SET_TIMEOUT
+    if (conn->timeout_ms != timeout_ms) {
+        esp_http_client_set_timeout_ms(conn->client, timeout_ms);
+        conn->timeout_ms = timeout_ms;
+    }
+#endif
+    xSemaphoreTake(http_pool_mutex, portMAX_DELAY);
+    if (http_pool_session_key[0] != '\0')
+        esp_http_client_set_header(conn->client, "X-Session-Key", http_pool_session_key);
+    else
+        esp_http_client_delete_header(conn->client, "X-Session-Key");
+    xSemaphoreGive(http_pool_mutex);
+    return conn;
+}
+
+static bool http_pool_reset_response(http_pool_conn_t *conn) {
+    conn->truncated = false;
+    if (!http_pool_buff_reserve(conn->resp_buff, JSON_BUFF_SIZE)) {
+        ESP_LOGE(TAG, "Failed to allocate response buffer");
+        return false;
+    }
+    conn->resp_buff->buf_pos = 0;
+    conn->resp_buff->buffer[0] = '\0';
+    if (conn->consumer != NULL) conn->consumer->begin(conn->consumer_ctx);
+    return true;
+}
+
+/**
+ * Stream the response body of the next request into a consumer instead of the response buffer.
+ * Reset on release
+ */
+void http_pool_set_consumer(http_pool_conn_t *conn, const http_pool_consumer_t *consumer, void *ctx) {
+    conn->consumer = consumer;
+    conn->consumer_ctx = ctx;
+}
+
+/**
+ * Perform the request. Reconnects once in case the Duet dropped the kept alive connection in the meantime.
+ * Response body is NULL terminated
+ * @param conn Connection from http_pool_acquire()
+ * @return Result of esp_http_client_perform(). ESP_ERR_NO_MEM if the response did not fit into the buffer
+ */
+esp_err_t http_pool_perform(http_pool_conn_t *conn) {
+    if (!http_pool_reset_response(conn)) return ESP_ERR_NO_MEM;
+    esp_err_t err = esp_http_client_perform(conn->client);
+    if (err != ESP_OK && conn->used_before) {
+        ESP_LOGD(TAG, "Reused connection failed (%s). Reconnecting", esp_err_to_name(err));
+        esp_http_client_close(conn->client);
+        http_pool_reset_response(conn);
+        err = esp_http_client_perform(conn->client);
+    }
+    conn->used_before = (err == ESP_OK);
+    if (err == ESP_OK && conn->truncated) return ESP_ERR_NO_MEM;
+    return err;
+}
+
+/**
+ * Hand connection back to the pool
+ * @param conn Connection from http_pool_acquire()
+ * @param keep_alive false to close the underlying socket e.g. after an error
+ */
+void http_pool_release(http_pool_conn_t *conn, bool keep_alive) {
+    if (conn->client != NULL) {
+        if (!keep_alive) {
+            esp_http_client_close(conn->client);
+            conn->used_before = false;
+        }
+        esp_http_client_set_method(conn->client, HTTP_METHOD_GET);
+        esp_http_client_set_post_field(conn->client, NULL, 0);
+    }
+    conn->resp_buff = NULL;
+    conn->consumer = NULL;
+    conn->consumer_ctx = NULL;
+    xSemaphoreTake(http_pool_mutex, portMAX_DELAY);
+    conn->in_use = false;
+    xSemaphoreGive(http_pool_mutex);
+    xSemaphoreGive(http_pool_free_cnt);
+}
@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_ESP32_HTTP_POOL_H
+#define REPPANEL_ESP32_ESP32_HTTP_POOL_H
+
+#include <stdbool.h>
+#include <esp_http_client.h>
+#include "reppanel_request.h"
+
+#define HTTP_POOL_SIZE              3       // status task, GUI task (G-Codes) & async file list task
+#define HTTP_POOL_ACQUIRE_TIMEOUT   1000    // ms to wait for a free connection
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+#define JSON_BUFF_MAX_SIZE          (1024 * 256)    // upper limit for buffered responses e.g. large file lists
+#else
+#define JSON_BUFF_MAX_SIZE          (1024 * 32)
+#endif
+
+// Receives the response body while it arrives instead of buffering it
+typedef struct {
+    void (*begin)(void *ctx);                                   // called before every attempt
+    bool (*feed)(void *ctx, const char *data, int len);
+} http_pool_consumer_t;
+
+typedef struct {
+    esp_http_client_handle_t client;
+    wifi_response_buff_t *resp_buff;        // response buffer of the current request
+    const http_pool_consumer_t *consumer;   // optional. Response is not buffered if set
+    void *consumer_ctx;
+    int timeout_ms;                         // timeout of the current request
+    bool in_use;
+    bool used_before;                       // connection might be kept alive by the Duet
+    bool truncated;                         // response did not fit into the response buffer
+} http_pool_conn_t;
+
+bool http_pool_buff_reserve(wifi_response_buff_t *buff, int size);
+
+bool http_pool_buff_append(wifi_response_buff_t *buff, const char *data, int len);
+
+void http_pool_buff_init(wifi_response_buff_t *buff);
+
+void http_pool_buff_free(wifi_response_buff_t *buff);
+
+void http_pool_init();
+
+void http_pool_set_session_key(const char *session_key);
+
+http_pool_conn_t *http_pool_acquire(const char *url, int timeout_ms, wifi_response_buff_t *resp_buff);
+
+void http_pool_set_consumer(http_pool_conn_t *conn, const http_pool_consumer_t *consumer, void *ctx);
+
+esp_err_t http_pool_perform(http_pool_conn_t *conn);
+
+void http_pool_release(http_pool_conn_t *conn, bool keep_alive);
+
+#endif //REPPANEL_ESP32_ESP32_HTTP_POOL_H
@@ -5,6 +5,7 @@
 #include <nvs.h>
 #include <string.h>
 #include <esp_log.h>
+#include "sdkconfig.h"
 #include "esp32_settings.h"
 #include "reppanel.h"
 
@@ -17,6 +18,7 @@ char rep_addr[MAX_REP_ADDR_LEN];
 char rep_pass[MAX_REP_PASS_LEN];
 
 int temp_unit = 0;   // 0=Celsius, 1=Fahrenheit
+uint32_t uart_baud_rate = CONFIG_REPPANEL_UART_BAUD_RATE;
 
 char filament_names[MAX_LEN_STR_FILAMENT_LIST] = {"Not set\nNot set"};
 
@@ -33,6 +35,7 @@ void print_settings() {
     ESP_LOGI(TAG, "Wifi password: %s", wifi_pass);
     ESP_LOGI(TAG, "RepRap addr: %s", rep_addr);
     ESP_LOGI(TAG, "RepRap password: %s", rep_pass);
+    ESP_LOGI(TAG, "UART baud rate: %u", uart_baud_rate);
 }
 
 void init_settings() {
@@ -50,6 +53,7 @@ void write_settings_to_nvs() {
     ESP_ERROR_CHECK(nvs_set_str(my_handle, NVS_KEY_WIFI_PASS, wifi_pass));
     ESP_ERROR_CHECK(nvs_set_str(my_handle, NVS_KEY_REPRAP_ADDR, rep_addr));
     ESP_ERROR_CHECK(nvs_set_str(my_handle, NVS_KEY_REPRAP_PASS, rep_pass));
+    ESP_ERROR_CHECK(nvs_set_u32(my_handle, NVS_KEY_UART_BAUD, uart_baud_rate));
     ESP_ERROR_CHECK(nvs_commit(my_handle));
     nvs_close(my_handle);
     print_settings();
@@ -85,6 +89,10 @@ void read_settings_nvs() {
         ESP_ERROR_CHECK(nvs_get_str(my_handle, NVS_KEY_REPRAP_PASS, tmp_rep_pass, &required_size));
         memccpy(rep_pass, tmp_rep_pass, required_size, MAX_REP_PASS_LEN);
 
+        // added later on. Keep Kconfig default if not yet stored
+        if (nvs_get_u32(my_handle, NVS_KEY_UART_BAUD, &uart_baud_rate) != ESP_OK)
+            uart_baud_rate = CONFIG_REPPANEL_UART_BAUD_RATE;
+
         nvs_close(my_handle);
         free(tmp_wifi_pass);
         free(tmp_wifi_ssid);
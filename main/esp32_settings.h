@@ -5,6 +5,8 @@
 #ifndef LVGL_REPPANEL_SETTINGS_H
 #define LVGL_REPPANEL_SETTINGS_H
 
+#include <stdint.h>
+
 #define MAX_NUM_TOOLS   5
 
 #define REPPANEL_NVS            "settings"
@@ -12,6 +14,7 @@
 #define NVS_KEY_WIFI_PASS       "wifi_pass"
 #define NVS_KEY_REPRAP_ADDR     "rep_addr"
 #define NVS_KEY_REPRAP_PASS     "rep_pass"
+#define NVS_KEY_UART_BAUD       "uart_baud"
 
 #define MAX_SSID_LEN        32
 #define MAX_WIFI_PASS_LEN   64
@@ -23,6 +26,7 @@ extern char wifi_pass[MAX_REP_PASS_LEN];
 extern char rep_addr[MAX_REP_ADDR_LEN];
 extern char rep_pass[MAX_REP_PASS_LEN];
 extern int temp_unit;   // 0=Celsius, 1=Fahrenheit
+extern uint32_t uart_baud_rate;
 
 void write_settings_to_nvs();
 
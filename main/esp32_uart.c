@@ -6,26 +6,124 @@
 #include <driver/uart.h>
 #include "driver/gpio.h"
 #include <string.h>
+#include <stdlib.h>
 #include <esp_log.h>
-#include <sys/time.h>
+#include <esp_attr.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "esp32_uart.h"
 #include "reppanel.h"
 
 #define TAG "ESP_UART"
 
-#define UART_READ_TIMEOUT   30 // ms
-#define UART_RESP_TIMEOUT   15000000 // us [1s]
-#define MAX_NUM_TIMEOUTS    1 // max number of timeouts to tolerate till we switch to WiFi
+#define UART_READ_TIMEOUT       30      // ms
+#define UART_RESP_TIMEOUT       15000   // ms
+#define UART_PROBE_TIMEOUT      250     // ms to wait for a response when checking for a connected Duet
+#define MAX_NUM_TIMEOUTS        1       // max number of timeouts to tolerate till we switch to WiFi
+#define UART_EVENT_QUEUE_LEN    20
+#define UART_RX_RING_SIZE       (1024 * 8)  // must be a power of two and hold at least one response
+#define UART_RX_CHUNK_LEN       128
+
+static const uint32_t uart_baud_rates[] = {460800, 230400, 115200, 57600};  // descending. Probing steps down
 
 const int uart_num = UART_NUM_2;
 bool uart_inited = false;
 static int timeout_cnt = 0;
+static QueueHandle_t uart_event_queue = NULL;
+static SemaphoreHandle_t uart_rx_line_sig = NULL;  // wakes the reader once a line was completed
+static SemaphoreHandle_t uart_rx_mutex = NULL;     // serialises the UART event task with uart_rx_discard_pending()
+
+// Single producer (UART event task), single consumer (request task) ring buffer. Indices only ever grow
+EXT_RAM_ATTR static uint8_t uart_rx_ring[UART_RX_RING_SIZE];
+static uint32_t uart_rx_head = 0;  // written by UART event task only
+static uint32_t uart_rx_tail = 0;  // written by reading task only
+static uint32_t uart_rx_num_lines = 0;     // complete lines inside the ring buffer
+static bool uart_rx_discard = false;
+static uint32_t uart_frame_err_cnt = 0;
+static uint32_t uart_baud_rate_requested = 0;  // set by the GUI task, applied by the request task. 0 if none
+
+static bool uart_rx_ring_push(uint8_t c) {
+    uint32_t head = uart_rx_head;
+    if (head - __atomic_load_n(&uart_rx_tail, __ATOMIC_ACQUIRE) >= UART_RX_RING_SIZE) return false;
+    uart_rx_ring[head & (UART_RX_RING_SIZE - 1)] = c;
+    __atomic_store_n(&uart_rx_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool uart_rx_ring_pop(uint8_t *c) {
+    uint32_t tail = uart_rx_tail;
+    if (tail == __atomic_load_n(&uart_rx_head, __ATOMIC_ACQUIRE)) return false;
+    *c = uart_rx_ring[tail & (UART_RX_RING_SIZE - 1)];
+    __atomic_store_n(&uart_rx_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Move everything the driver received to the ring buffer. Lines that do not fit get dropped
+ */
+static void uart_rx_collect() {
+    uint8_t chunk[UART_RX_CHUNK_LEN];
+    size_t length = 0;
+    uart_get_buffered_data_len(uart_num, &length);
+    while (length > 0) {
+        int read = uart_read_bytes(uart_num, chunk, length < sizeof(chunk) ? length : sizeof(chunk), 0);
+        if (read <= 0) break;
+        length -= read;
+        for (int i = 0; i < read; i++) {
+            if (!uart_rx_discard && !uart_rx_ring_push(chunk[i])) {
+                ESP_LOGE(TAG, "UART receive ring buffer overflow. Dropping line");
+                uart_rx_discard = true;
+            }
+            if (chunk[i] == '\n') {
+                // reader gets an empty line instead of waiting. No room yet: terminate the dropped line later
+                if (uart_rx_discard && !uart_rx_ring_push('\n')) continue;
+                uart_rx_discard = false;
+                __atomic_add_fetch(&uart_rx_num_lines, 1, __ATOMIC_RELEASE);
+                xSemaphoreGive(uart_rx_line_sig);
+            }
+        }
+    }
+}
+
+static void uart_event_task(void *params) {
+    uart_event_t event;
+    while (1) {
+        if (xQueueReceive(uart_event_queue, &event, portMAX_DELAY) != pdTRUE) continue;
+        xSemaphoreTake(uart_rx_mutex, portMAX_DELAY);
+        switch (event.type) {
+            case UART_DATA:
+                uart_rx_collect();
+                break;
+            case UART_PATTERN_DET:
+                uart_pattern_pop_pos(uart_num);     // line end is detected while collecting
+                uart_rx_collect();
+                break;
+            case UART_FRAME_ERR:
+            case UART_PARITY_ERR:
+                __atomic_add_fetch(&uart_frame_err_cnt, 1, __ATOMIC_RELAXED);    // likely a baud rate mismatch
+                break;
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                ESP_LOGW(TAG, "UART driver overflow. Flushing input");
+                uart_flush_input(uart_num);
+                uart_pattern_queue_reset(uart_num, UART_EVENT_QUEUE_LEN);
+                xQueueReset(uart_event_queue);
+                uart_rx_discard = true;
+                break;
+            default:
+                break;
+        }
+        xSemaphoreGive(uart_rx_mutex);
+    }
+}
 
 void init_uart() {
-    ESP_LOGI(TAG, "Initing UART%i ...", uart_num);
+    ESP_LOGI(TAG, "Initing UART%i with %u baud ...", uart_num, uart_baud_rate);
     uart_config_t uart_config = {
-            .baud_rate = 57600,
+            .baud_rate = uart_baud_rate,
             .data_bits = UART_DATA_8_BITS,
             .parity = UART_PARITY_DISABLE,
             .stop_bits = UART_STOP_BITS_1,
@@ -36,38 +134,136 @@ void init_uart() {
     // Setup UART buffered IO with event queue
     const int uart_buffer_size = UART_DATA_BUFF_LEN;
     // Install UART driver using an event queue here
-    ESP_ERROR_CHECK(uart_driver_install(uart_num, 1024 * 3, uart_buffer_size, 10, NULL, 0));
+    ESP_ERROR_CHECK(uart_driver_install(uart_num, 1024 * 3, uart_buffer_size, UART_EVENT_QUEUE_LEN, &uart_event_queue,
+                                        0));
+    // Every response of the Duet ends with a new line. Get an event for each of them
+    ESP_ERROR_CHECK(uart_enable_pattern_det_baud_intr(uart_num, '\n', 1, 1, 0, 0));
+    ESP_ERROR_CHECK(uart_pattern_queue_reset(uart_num, UART_EVENT_QUEUE_LEN));
+    uart_rx_line_sig = xSemaphoreCreateBinary();
+    uart_rx_mutex = xSemaphoreCreateMutex();
+    configASSERT(uart_rx_line_sig);
+    configASSERT(uart_rx_mutex);
+    TaskHandle_t uart_event_task_handle = NULL;
+    xTaskCreate(uart_event_task, "uart_event_task", 1024 * 3, NULL, 5, &uart_event_task_handle);
+    configASSERT(uart_event_task_handle);
     ESP_LOGI(TAG, "UART%i init done", uart_num);
     uart_inited = true;
 }
 
+/**
+ * Drop all received and not yet read data. Call from reading task
+ */
+static void uart_rx_discard_pending() {
+    xSemaphoreTake(uart_rx_mutex, portMAX_DELAY);
+    __atomic_store_n(&uart_rx_tail, __atomic_load_n(&uart_rx_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    __atomic_store_n(&uart_rx_num_lines, 0, __ATOMIC_RELEASE);
+    xSemaphoreTake(uart_rx_line_sig, 0);
+    xSemaphoreGive(uart_rx_mutex);
+}
+
+/**
+ * Block till there is a complete line in the ring buffer
+ * @return false on timeout
+ */
+static bool uart_rx_wait_line(int timeout_ms) {
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    while (__atomic_load_n(&uart_rx_num_lines, __ATOMIC_ACQUIRE) == 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout || xSemaphoreTake(uart_rx_line_sig, timeout - elapsed) != pdTRUE) return false;
+    }
+    return true;
+}
+
+/**
+ * Wait for the next complete line and copy it to the buffer. New line char is replaced with the string end char
+ * @return Line length. -1 on timeout, -2 if the line did not fit into the buffer
+ */
+static int uart_rx_read_line(uart_response_buff_t *receive_buff, int timeout_ms) {
+    if (!uart_rx_wait_line(timeout_ms)) return -1;
+    __atomic_sub_fetch(&uart_rx_num_lines, 1, __ATOMIC_ACQ_REL);
+    receive_buff->buf_pos = 0;
+    bool overflow = false;
+    uint8_t c = 0;
+    while (uart_rx_ring_pop(&c) && c != '\n') {
+        if (receive_buff->buf_pos < (UART_RESP_BUFF_SIZE - 1))
+            receive_buff->buffer[receive_buff->buf_pos++] = c;
+        else
+            overflow = true;
+    }
+    receive_buff->buffer[receive_buff->buf_pos] = '\0';
+    return overflow ? -2 : receive_buff->buf_pos;
+}
+
 bool reppanel_is_uart_connected() {
     if (!uart_inited) {
         ESP_LOGW(TAG, "Uart not inited - skipping connection check");
         return false;
     }
-
+    esp32_flush_uart();
     char comm[] = {"M408 S0\r\n"};
     if (uart_write_bytes(uart_num, (const char *) comm, strlen(comm)) != strlen(comm)) {
         ESP_LOGW(TAG, "Duet connection check - Could not push all bytes to write buffer!");
         return false;
     }
-    int length = 0;
-    uart_wait_tx_done(uart_num, UART_READ_TIMEOUT / portTICK_RATE_MS);
-    ESP_ERROR_CHECK(uart_get_buffered_data_len(uart_num, (size_t *) &length));
-    uint8_t data = 0;
-    while (length > 0 && data != '\n') {
-        uart_read_bytes(uart_num, &data, 1, 20 / portTICK_RATE_MS);
-        length++;
+    bool got_response = uart_rx_wait_line(UART_PROBE_TIMEOUT);
+    esp32_flush_uart();
+    ESP_LOGI(TAG, "Checked for connected UART - %s", got_response ? "got response" : "no response");
+    return got_response;
+}
+
+static void uart_switch_baud_rate(uint32_t baud_rate) {   // Call from reading task
+    if (uart_inited) {
+        ESP_LOGI(TAG, "Switching UART%i to %u baud", uart_num, baud_rate);
+        uart_wait_tx_done(uart_num, UART_READ_TIMEOUT / portTICK_RATE_MS);
+        uart_set_baudrate(uart_num, baud_rate);
+        esp32_flush_uart();
+    }
+}
+
+/**
+ * Only records the new rate. The request task switches to it with reppanel_uart_probe_baud_rate() once it sees
+ * reppanel_uart_baud_rate_pending(). Safe to call from any task
+ * @param baud_rate New baud rate. Also becomes the highest rate that gets probed
+ */
+void reppanel_uart_request_baud_rate(uint32_t baud_rate) {
+    __atomic_store_n(&uart_baud_rate_requested, baud_rate, __ATOMIC_RELEASE);
+}
+
+bool reppanel_uart_baud_rate_pending() {
+    return __atomic_load_n(&uart_baud_rate_requested, __ATOMIC_ACQUIRE) != 0;
+}
+
+/**
+ * Find the baud rate the Duet talks at. Starts with the configured rate and steps down whenever there is no
+ * response, a framing error or garbage. The Duet side is set with M575 P1 B... and is never changed by us
+ * @return true if the Duet responded on one of the rates. Configured rate stays set otherwise
+ */
+bool reppanel_uart_probe_baud_rate() {   // Call from reading task
+    if (!uart_inited) return false;
+    __atomic_store_n(&uart_baud_rate_requested, 0, __ATOMIC_RELEASE);
+    uart_response_buff_t *probe_buff = malloc(sizeof(uart_response_buff_t));
+    if (probe_buff == NULL) return false;
+    bool found = false;
+    for (int i = 0; i < sizeof(uart_baud_rates) / sizeof(uart_baud_rates[0]) && !found; i++) {
+        if (uart_baud_rates[i] > uart_baud_rate) continue;
+        uart_switch_baud_rate(uart_baud_rates[i]);
+        __atomic_store_n(&uart_frame_err_cnt, 0, __ATOMIC_RELAXED);
+        reppanel_write_uart("M408 S0", strlen("M408 S0"));
+        int length = uart_rx_read_line(probe_buff, UART_PROBE_TIMEOUT);
+        found = length > 0 && probe_buff->buffer[0] == '{' &&
+                __atomic_load_n(&uart_frame_err_cnt, __ATOMIC_RELAXED) == 0;
+        ESP_LOGI(TAG, "Probing %u baud: %s", uart_baud_rates[i], found ? "OK" : "no valid response");
     }
-    uart_flush(uart_num);
-    ESP_LOGI(TAG, "Checked for connected UART- received %i bytes", length);
-    return (length > 0);
+    if (!found) uart_switch_baud_rate(uart_baud_rate);
+    free(probe_buff);
+    return found;
 }
 
 void esp32_flush_uart() {
     if (uart_inited) {
-        uart_flush(uart_num);
+        uart_flush_input(uart_num);
+        uart_rx_discard_pending();
     }
 }
 
@@ -80,31 +276,6 @@ void reppanel_write_uart(char *buffer, int buffer_len) {
     }
 }
 
-/**
- * Read from UART - Timeout not really working!
- * @param receive_buff
- * @return -1 on error
- */
-int reppanel_read_uart(uart_response_buff_t *receive_buff) {
-    if (uart_inited) {
-        int length = 0;
-        ESP_ERROR_CHECK(uart_get_buffered_data_len(uart_num, (size_t *) &length));
-        if (length <= (UART_RESP_BUFF_SIZE-receive_buff->buf_pos))
-            length = uart_read_bytes(uart_num, &receive_buff->buffer[receive_buff->buf_pos], length,
-                                     UART_READ_TIMEOUT / portTICK_RATE_MS);
-        else {
-            ESP_LOGE(TAG, "UART response too big for buffer %i !", length);
-            return -1;
-        }
-        receive_buff->buf_pos += length;
-        if (length > 0) ESP_LOGD(TAG, "Received %i", length);
-        return length;
-    } else {
-        ESP_LOGW(TAG, "UART not inited - skipping read UART");
-        return -1;
-    }
-}
-
 void read_timeout() {
     timeout_cnt++;
     ESP_LOGW(TAG, "Read timeout");
@@ -116,7 +287,7 @@ void read_timeout() {
 }
 
 /**
- * Read a response from Duet from UART and write it to the provided buffer
+ * Read a response from Duet from UART and write it to the provided buffer. Blocks till a complete line was received
  * @param receive_buff Receiving buffer
  * @return False in case of read timeout or not inited UART or overflow, True in case of valid response
  */
@@ -125,41 +296,17 @@ bool reppanel_read_response(uart_response_buff_t *receive_buff) {
         ESP_LOGW(TAG, "Can not read response - Wait for UART init first");
         return false;
     }
-    memset(receive_buff, 0, sizeof(uart_response_buff_t));
-    receive_buff->buf_pos = 0;
-
-    struct timeval tv_now;
-    gettimeofday(&tv_now, NULL);
-    int64_t start_time_us = (int64_t) tv_now.tv_sec * 1000000L + (int64_t) tv_now.tv_usec;
-
-    // get complete response
-    bool response_incomplete = true;
-    do {
-        if (reppanel_read_uart(receive_buff) == -1) return false;
-        if (receive_buff->buf_pos >= UART_RESP_BUFF_SIZE) {
-            ESP_LOGE(TAG, "UART response buffer with receive_buff->buf_pos/%i bytes overflowed", UART_RESP_BUFF_SIZE);
-        }
-        gettimeofday(&tv_now, NULL);
-        int64_t current_time_us = (int64_t) tv_now.tv_sec * 1000000L + (int64_t) tv_now.tv_usec;
-        if (current_time_us - start_time_us > UART_RESP_TIMEOUT) {
-            read_timeout();
-            ESP_LOGW(TAG, "UART_REPS_TIMEOUT - waited %i milliseconds", (int) (UART_RESP_TIMEOUT/1e3));
-            return false;
-        }
-
-        if (receive_buff->buf_pos > 0) {
-            if (receive_buff->buffer[receive_buff->buf_pos - 1] == '\n') {
-                response_incomplete = false;
-            }
-        }
-    } while(response_incomplete && receive_buff->buf_pos < UART_RESP_BUFF_SIZE);
-
-    if (receive_buff->buffer[receive_buff->buf_pos - 1] == '\n') {
-        ESP_LOGD(TAG, "Found new line char at %i", receive_buff->buf_pos - 1);
+    int length = uart_rx_read_line(receive_buff, UART_RESP_TIMEOUT);
+    if (length == -1) {
+        read_timeout();
+        ESP_LOGW(TAG, "UART_REPS_TIMEOUT - waited %i milliseconds", UART_RESP_TIMEOUT);
+        return false;
+    } else if (length == -2) {
+        ESP_LOGE(TAG, "UART response buffer with %i bytes overflowed", UART_RESP_BUFF_SIZE);
+        return false;
     }
     timeout_cnt = 0;
-    ESP_LOGD(TAG, "---> Response complete with %i bytes", receive_buff->buf_pos);
-    receive_buff->buffer[receive_buff->buf_pos - 1] = '\0';   // replace new line with string end char to parse JSON
+    ESP_LOGD(TAG, "---> Response complete with %i bytes", length);
     ESP_LOGD(TAG, "%s", receive_buff->buffer);
     return true;
 }
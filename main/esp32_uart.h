@@ -11,7 +11,12 @@
 #define UART_MAX_READ_TIMEOUT_CNT   5
 #define UART_DATA_BUFF_LEN  0
 
+extern bool uart_inited;
+
 void init_uart();
+void reppanel_uart_request_baud_rate(uint32_t baud_rate);
+bool reppanel_uart_baud_rate_pending();
+bool reppanel_uart_probe_baud_rate();
 void reppanel_write_uart(char *buffer, int buffer_len);
 void esp32_flush_uart();
 bool reppanel_is_uart_connected();
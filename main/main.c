@@ -22,14 +22,17 @@
 #include "esp32_wifi.h"
 #include "reppanel_request.h"
 #include "esp32_uart.h"
+#include "esp32_http_pool.h"
+#include "reppanel_json_arena.h"
 #include "rrf_objects.h"
+#include "reppanel_snapshot.h"
+#include "reppanel_temp_history.h"
+#include "reppanel_gcode_queue.h"
+#include "reppanel_input_coalesce.h"
 #include "screen_saver.h"
 
-#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
-#define QOI_IMPLEMENTATION
-#define QOI_NO_STDIO
-#include "../externals/qoi/qoi.h"
-#endif
+#include "reppanel_img_decoder.h"
+#include "reppanel_thumbnail_cache.h"
 
 #ifdef CONFIG_LVGL_TFT_DISPLAY_MONOCHROME
 #include "lv_theme_mono.h"
@@ -37,8 +40,6 @@
 #define TAG "Main"
 
 SemaphoreHandle_t xGuiSemaphore;
-double reprap_chamber_temp_buff[NUM_TEMPS_BUFF] = {0};
-int reprap_chamber_temp_curr_pos = 0;
 double reprap_babysteps_amount = 0.05;
 double reprap_move_feedrate = 6000;
 double reprap_mcu_temp = 0;
@@ -53,6 +54,11 @@ _Noreturn void guiTask();
  *   APPLICATION MAIN
  **********************/
 void app_main() {
+    http_pool_init();
+    reppanel_json_arena_init();
+    reppanel_snapshot_init();
+    reppanel_temp_history_init();
+    reppanel_gcode_queue_init();
     //If you want to use a task to create the graphic, you NEED to create a Pinned task
     //Otherwise there can be problem such as memory corruption and so on
     xTaskCreatePinnedToCore(guiTask, "gui", CONFIG_REPPANEL_GUI_TASK_STACK_SIZE, NULL, 0, NULL, 1);
@@ -73,6 +79,10 @@ _Noreturn void guiTask() {
 //    UBaseType_t uxHighWaterMark = uxTaskGetStackHighWaterMark( NULL );
     xGuiSemaphore = xSemaphoreCreateMutex();
     lv_init();
+    reppanel_input_coalesce_init();
+#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+    reppanel_img_decoder_init();
+#endif
     lvgl_driver_init();
 
     static lv_color_t buf1[DISP_BUF_SIZE];
@@ -124,6 +134,9 @@ _Noreturn void guiTask() {
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+    reppanel_thumbnail_cache_init();
+#endif
     init_reprap_model();
     read_settings_nvs();
     rep_panel_ui_create();
@@ -151,6 +164,7 @@ _Noreturn void guiTask() {
 
         //Try to lock the semaphore, if success, call lvgl stuff
         if (xSemaphoreTake(xGuiSemaphore, (TickType_t) 10) == pdTRUE) {
+            update_reprap_status_ui(reppanel_snapshot_apply());    // pick up new printer state from request task
             lv_task_handler();
             // handle screen saver stuff
             if (lv_disp_get_inactive_time(lcd_display) > (CONFIG_REPPANEL_SCREEN_SAVER_TIMEOUT * 1000)) {
@@ -19,6 +19,7 @@
 #endif
 #include "reppanel_jobselect.h"
 #include "rrf_objects.h"
+#include "reppanel_snapshot.h"
 #include <stdio.h>
 
 void draw_header(lv_obj_t *parent_screen);
@@ -195,10 +196,8 @@ void draw_header(lv_obj_t *parent_screen) {
     lv_img_set_src(img_chamber_tmp, &chamber_tmp);
 
     label_chamber_temp = lv_label_create(cont_header_right, NULL);
-    lv_label_set_text_fmt(label_chamber_temp, "%.01f/%.01f°%c",
-                          reprap_bed.temp_buff[reprap_bed.temp_hist_curr_pos],
-                          reprap_tools[current_visible_tool_indx].temp_buff[reprap_tools[current_visible_tool_indx].temp_hist_curr_pos],
-                          get_temp_unit());
+    lv_label_set_text_fmt(label_chamber_temp, "%.01f/%.01f°%c", reprap_bed.current_temp,
+                          reprap_tools[current_visible_tool_indx].current_temp, get_temp_unit());
 
 #if defined(CONFIG_REPPANEL_ESP32_CONSOLE_ENABLED)
     LV_IMG_DECLARE(consolebutton);
@@ -246,16 +245,43 @@ void update_rep_panel_conn_status() {
     }
 }
 
+/**
+ * Update UI elements showing the printer state. Only touches widgets whose data changed so an idle printer does not
+ * cause any redraws. Call from GUI task with the result of reppanel_snapshot_apply()
+ * @param dirty SNAPSHOT_DIRTY_* flags returned by reppanel_snapshot_apply()
+ */
+void update_reprap_status_ui(uint16_t dirty) {
+    static int shown_conn_stat = -1;
+    if (rp_conn_stat != shown_conn_stat) {
+        shown_conn_stat = rp_conn_stat;
+        update_rep_panel_conn_status();
+    }
+    if ((dirty & SNAPSHOT_DIRTY_STATUS) && label_status != NULL)
+        lv_label_set_text(label_status, reprap_model.reprap_state.status);
+    if (dirty & SNAPSHOT_DIRTY_AXES) update_machine_axes_ui();
+    if (dirty & SNAPSHOT_DIRTY_PARAMS) update_machine_params_ui();
+    if (dirty & SNAPSHOT_DIRTY_BED_TEMPS) update_bed_temps_ui();
+    if (dirty & SNAPSHOT_DIRTY_HEATERS) update_heater_status_ui(heater_states, reprap_model.num_heaters);
+    if (dirty & (SNAPSHOT_DIRTY_TOOLS | SNAPSHOT_DIRTY_TOOL_TEMPS)) update_process_status_ui();
+    if (dirty & (SNAPSHOT_DIRTY_BED_TEMPS | SNAPSHOT_DIRTY_TOOL_TEMPS)) update_header_temp_ui();
+    if (dirty & SNAPSHOT_DIRTY_TEMP_HISTORY) update_temp_chart_ui();
+    if ((dirty & SNAPSHOT_DIRTY_JOB) && job_running) update_print_job_status_ui();
+    if (dirty & SNAPSHOT_DIRTY_MSG) {
+        show_reprap_dialog(reprap_model.reprap_state.msg_box_title, reprap_model.reprap_state.msg_box_msg,
+                           reprap_model.reprap_state.mode, reprap_model.reprap_state.show_axis_controls);
+    }
+}
+
 static void show_process_screen(lv_obj_t *obj, lv_event_t event) {
     if (event == LV_EVENT_CLICKED) {
         update_rep_panel_conn_status();
         clean_screens();
         process_scr = lv_cont_create(NULL, NULL);
         lv_cont_set_layout(process_scr, LV_LAYOUT_COL_M);
+        visible_screen = REPPANEL_PROCESS_SCREEN;  // draw_process() fills in the state of the visible tool
         draw_header(process_scr);
         draw_process(process_scr);
         lv_scr_load(process_scr);
-        visible_screen = REPPANEL_PROCESS_SCREEN;
     }
 }
 
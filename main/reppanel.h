@@ -36,7 +36,7 @@ extern "C" {
 #define MAX_FILA_NAME_LEN   32
 #define MAX_TOOL_NAME_LEN   12
 #define MAX_LEN_STR_FILAMENT_LIST   (MAX_FILA_NAME_LEN * 32)
-#define MAX_NUM_ELEM_DIR    CONFIG_REPPANEL_MAX_NUM_ELEM_DIR      // Max number of elements per directory that can be listed
+#define MAX_NUM_ELEM_DIR    CONFIG_REPPANEL_MAX_NUM_ELEM_DIR      // Max number of elements per directory listing without SPI-RAM
 #define REPPANEL_RRF_MAX_AXES   5
 
 #define MAX_LEN_FILENAME    CONFIG_REPPANEL_MAX_FILENAME_LENGTH
@@ -77,9 +77,6 @@ extern lv_obj_t *ddlist_selected_filament;
 extern lv_obj_t *label_connection_status;
 
 
-extern int reprap_chamber_temp_curr_pos;
-extern double reprap_chamber_temp_buff[NUM_TEMPS_BUFF];
-
 // predefined by d2wc config. Temps the heaters can be set to
 extern double reprap_babysteps_amount;
 extern double reprap_extruder_amounts[NUM_TEMPS_BUFF];
@@ -87,8 +84,6 @@ extern double reprap_extruder_feedrates[NUM_TEMPS_BUFF];
 extern double reprap_move_feedrate;
 extern double reprap_mcu_temp;
 extern float reprap_job_percent;
-extern double reprap_job_first_layer_height;
-extern double reprap_job_layer_height;
 extern char reprap_firmware_name[32];
 extern char reprap_firmware_version[5];
 
@@ -112,20 +107,23 @@ typedef struct {
     int fans;
     char filament[MAX_FILA_NAME_LEN];
     int heater_indx;                    // only support one heater per tool for now
-    double temp_buff[NUM_TEMPS_BUFF];   // Temp buffer contains temperature history of heaters
-    int temp_hist_curr_pos;             // Pointers to current position within the temp buffer
+    double current_temp;                // history is kept by reppanel_temp_history.c
     double active_temp;
     double standby_temp;
 } reprap_tool_t;
 
 typedef struct {
-    double temp_buff[NUM_TEMPS_BUFF];   // Temp buffer contains temperature history of heater
-    int temp_hist_curr_pos;             // Pointers to current position within the temp buffer
+    double current_temp;                // history is kept by reppanel_temp_history.c
     int heater_indx;
     double active_temp;
     double standby_temp;
 } reprap_bed_t;
 
+typedef struct {
+    double current_temp;
+    int heater_indx;                    // -1 if the printer has no chamber heater
+} reprap_chamber_t;
+
 typedef struct {
     double temps_standby[NUM_TEMPS_BUFF];
     double temps_active[NUM_TEMPS_BUFF];
@@ -136,14 +134,14 @@ typedef struct {
     double temps_active[NUM_TEMPS_BUFF];
 } reprap_bed_poss_temps_t;
 
+// Expanded copy of a single entry of a directory listing. See reppanel_filelist.h for the listing itself
 typedef struct {
     char name[MAX_LEN_FILENAME];    // name of the files
     char dir[MAX_LEN_DIRNAME];      // current directory
     time_t time_stamp;              // unix timestamp indicating last change/upload of element
-    int type;                       // TREE_FOLDER_ELEM, TREE_FILE_ELEM, TREE_EMPTY_ELEM -> last element
+    int type;                       // TREE_FOLDER_ELEM, TREE_FILE_ELEM
 } file_tree_elem_t;
 
-extern file_tree_elem_t reprap_dir_elem[MAX_NUM_ELEM_DIR];  // Array used for buffering directory listings like macros/jobs
 
 // pos 0 is bed temp, rest are tool heaters
 enum {HEATER_OFF, HEATER_STDBY, HEATER_ACTIVE, HEATER_FAULT};
@@ -156,6 +154,7 @@ extern reprap_axes_t reprap_axes;
 extern reprap_params_t reprap_params;
 extern reprap_tool_t reprap_tools[MAX_NUM_TOOLS];
 extern reprap_bed_t reprap_bed;
+extern reprap_chamber_t reprap_chamber;
 extern reprap_tool_poss_temps_t reprap_tool_poss_temps;
 extern reprap_bed_poss_temps_t reprap_bed_poss_temps;
 
@@ -169,6 +168,8 @@ void rep_panel_ui_create();
 
 void update_rep_panel_conn_status();
 
+void update_reprap_status_ui(uint16_t dirty);
+
 void display_jobstatus();
 
 #ifdef __cplusplus
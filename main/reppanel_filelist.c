@@ -0,0 +1,323 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// The Duet returns large directories in pages. Every page names the index of the first entry of the next page
+// ("next") or 0 if it was the last one. Pages are appended to reprap_dir_listing as they arrive, so the UI can show
+// the first page while the request task fetches the rest in between status updates.
+// The directory is stored once per listing. Names go to a pool, entries are 8 byte handles into it, so thousands of
+// entries fit and sorting only swaps handles.
+// Complete listings are kept in a small LRU cache keyed by path. A cached listing is valid as long as seqs.directories
+// of the object model did not change since it was fetched.
+//
+
+#include <string.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "reppanel_filelist.h"
+#include "reppanel_helper.h"
+#include "main.h"
+
+#define TAG "FileList"
+
+reppanel_dir_listing_t reprap_dir_listing;
+
+typedef struct {
+    char dir[MAX_LEN_DIRNAME];      // empty if the slot is unused
+    file_tree_entry_t *entries;
+    int count;
+    char *names;
+    uint32_t names_used;
+    uint16_t dir_seq;               // seqs.directories when the listing was fetched
+    TickType_t fetched;
+    uint32_t last_used;             // for LRU replacement
+} filelist_cache_t;
+
+// Protected by xGuiSemaphore like the listing. Never touched by the GUI task
+static filelist_cache_t filelist_cache[FILELIST_CACHE_SIZE];
+static uint32_t filelist_cache_clock = 0;
+static volatile bool filelist_cache_flush_pending = false;
+
+static void filelist_lock() {
+    if (xGuiSemaphore != NULL) xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
+}
+
+static void filelist_unlock() {
+    if (xGuiSemaphore != NULL) xSemaphoreGive(xGuiSemaphore);
+}
+
+/**
+ * Resize a buffer of the listing. Prefers SPI-RAM
+ * @return New buffer or NULL. Old buffer is still valid in that case
+ */
+static void *filelist_realloc(void *ptr, size_t size) {
+    void *resized = NULL;
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+    resized = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+#endif
+    if (resized == NULL) resized = realloc(ptr, size);
+    if (resized == NULL) ESP_LOGW(TAG, "Could not grow listing to %u bytes", (unsigned) size);
+    return resized;
+}
+
+/**
+ * Make room for count entries with names taking names_used bytes
+ * @return false if the listing would be too large or there is not enough memory
+ */
+static bool filelist_reserve(int count, uint32_t names_used) {
+    reppanel_dir_listing_t *l = &reprap_dir_listing;
+    if (count > l->capacity) {
+        if (count > FILELIST_MAX_ENTRIES) return false;
+        int capacity = l->capacity + FILELIST_GROW_ENTRIES;
+        if (capacity < count) capacity = count;
+        if (capacity > FILELIST_MAX_ENTRIES) capacity = FILELIST_MAX_ENTRIES;
+        file_tree_entry_t *entries = filelist_realloc(l->entries, capacity * sizeof(file_tree_entry_t));
+        if (entries == NULL) return false;
+        l->entries = entries;
+        l->capacity = capacity;
+    }
+    if (names_used > l->names_size) {
+        if (names_used > FILELIST_MAX_NAMES_SIZE) return false;
+        uint32_t size = names_used + FILELIST_GROW_NAMES;
+        if (size > FILELIST_MAX_NAMES_SIZE) size = FILELIST_MAX_NAMES_SIZE;
+        char *names = filelist_realloc(l->names, size);
+        if (names == NULL) return false;
+        l->names = names;
+        l->names_size = size;
+    }
+    return true;
+}
+
+static uint32_t filelist_pack_stamp(time_t time_stamp) {
+    if (time_stamp < FILELIST_STAMP_EPOCH) return 0;
+    time_stamp -= FILELIST_STAMP_EPOCH;
+    return time_stamp > FILELIST_STAMP_MASK ? FILELIST_STAMP_MASK : (uint32_t) time_stamp;
+}
+
+/**
+ * @return false if the listing is full
+ */
+static bool filelist_add_entry(cJSON *entry) {
+    cJSON *name = cJSON_GetObjectItem(entry, "name");
+    cJSON *type = cJSON_GetObjectItem(entry, "type");
+    cJSON *date = cJSON_GetObjectItem(entry, "date");
+    if (!cJSON_IsString(name) || !cJSON_IsString(type)) return true;
+    size_t name_len = strnlen(name->valuestring, MAX_LEN_FILENAME - 1);
+    reppanel_dir_listing_t *l = &reprap_dir_listing;
+    if (!filelist_reserve(l->count + 1, l->names_used + name_len + 1)) return false;
+    file_tree_entry_t *added = &l->entries[l->count++];
+    added->name = l->names_used;
+    memcpy(&l->names[l->names_used], name->valuestring, name_len);
+    l->names[l->names_used + name_len] = '\0';
+    l->names_used += name_len + 1;
+    added->stamp_type = cJSON_IsString(date) ? filelist_pack_stamp(datestr_2unix(date->valuestring)) : 0;
+    if (type->valuestring[0] != 'f') added->stamp_type |= FILELIST_FOLDER_FLAG;
+    return true;
+}
+
+/**
+ * Add one page of a rr_filelist/M20 S3 response to the listing. A page with first == 0 starts a new listing.
+ * Pages that do not continue the current listing are dropped.
+ * @param dir Directory as returned by the Duet
+ * @param first Index of the first entry of the page
+ * @param next Index of the first entry of the next page. 0 if this was the last page
+ * @param files "files" array of the response
+ * @return true if the page was added
+ */
+bool reppanel_filelist_add_page(const char *dir, int first, int next, cJSON *files) {
+    filelist_lock();
+    if (first == 0) {
+        strlcpy(reprap_dir_listing.dir, dir, MAX_LEN_DIRNAME);
+        reprap_dir_listing.count = 0;
+        reprap_dir_listing.names_used = 0;
+        reprap_dir_listing.generation++;
+    } else if (first != reprap_dir_listing.next || strcmp(dir, reprap_dir_listing.dir) != 0) {
+        filelist_unlock();
+        ESP_LOGD(TAG, "Dropping page %i of %s", first, dir);
+        return false;
+    }
+    reprap_dir_listing.next = next > 0 ? next : 0;
+    reprap_dir_listing.retries = 0;
+    cJSON *entry = NULL;
+    cJSON_ArrayForEach(entry, files) {
+        if (!cJSON_IsObject(entry)) continue;
+        if (!filelist_add_entry(entry)) {
+            ESP_LOGW(TAG, "Listing of %s truncated to %i entries", dir, reprap_dir_listing.count);
+            reprap_dir_listing.next = 0;
+            break;
+        }
+    }
+    filelist_unlock();
+    ESP_LOGI(TAG, "%s: %i entries, next %i", dir, reprap_dir_listing.count, next);
+    return true;
+}
+
+/**
+ * Check if the current listing is still incomplete. Counts every call as a request for the next page.
+ * A successful request must add the page with reppanel_filelist_add_page()
+ * @param dir Receives the directory to request
+ * @param dir_len Size of dir
+ * @param first Receives the first entry to request
+ * @return true if the next page needs to be requested
+ */
+bool reppanel_filelist_next_page(char *dir, size_t dir_len, int *first) {
+    bool pending = false;
+    filelist_lock();
+    if (reprap_dir_listing.next > 0) {
+        if (reprap_dir_listing.retries++ < FILELIST_MAX_RETRIES) {
+            strlcpy(dir, reprap_dir_listing.dir, dir_len);
+            *first = reprap_dir_listing.next;
+            pending = true;
+        } else {
+            ESP_LOGW(TAG, "Giving up on %s after %i entries", reprap_dir_listing.dir, reprap_dir_listing.count);
+            reprap_dir_listing.next = 0;
+        }
+    }
+    filelist_unlock();
+    return pending;
+}
+
+/**
+ * @return Name of an entry of the listing. Valid until the listing changes
+ */
+const char *reppanel_filelist_name(int index) {
+    return &reprap_dir_listing.names[reprap_dir_listing.entries[index].name];
+}
+
+/**
+ * @return TREE_FOLDER_ELEM or TREE_FILE_ELEM
+ */
+int reppanel_filelist_type(int index) {
+    return reprap_dir_listing.entries[index].stamp_type & FILELIST_FOLDER_FLAG ? TREE_FOLDER_ELEM : TREE_FILE_ELEM;
+}
+
+/**
+ * Copy an entry of the listing. The copy stays valid when the listing changes
+ */
+void reppanel_filelist_get(int index, file_tree_elem_t *elem) {
+    file_tree_entry_t *entry = &reprap_dir_listing.entries[index];
+    strlcpy(elem->name, reppanel_filelist_name(index), MAX_LEN_FILENAME);
+    strlcpy(elem->dir, reprap_dir_listing.dir, MAX_LEN_DIRNAME);
+    elem->time_stamp = (time_t) (entry->stamp_type & FILELIST_STAMP_MASK) + FILELIST_STAMP_EPOCH;
+    elem->type = reppanel_filelist_type(index);
+}
+
+static int filelist_compare_stamp(const void *a, const void *b) {
+    uint32_t stamp_a = ((const file_tree_entry_t *) a)->stamp_type & FILELIST_STAMP_MASK;
+    uint32_t stamp_b = ((const file_tree_entry_t *) b)->stamp_type & FILELIST_STAMP_MASK;
+    if (stamp_a < stamp_b) return 1;
+    if (stamp_a > stamp_b) return -1;
+    return 0;
+}
+
+/**
+ * Sort entries from index on by modification date. Most recent first
+ */
+void reppanel_filelist_sort(int from) {
+    if (from >= reprap_dir_listing.count) return;
+    qsort(&reprap_dir_listing.entries[from], reprap_dir_listing.count - from, sizeof(file_tree_entry_t),
+          filelist_compare_stamp);
+}
+
+static void filelist_cache_drop(filelist_cache_t *cached) {
+    free(cached->entries);
+    free(cached->names);
+    memset(cached, 0, sizeof(filelist_cache_t));
+}
+
+static filelist_cache_t *filelist_cache_find(const char *dir) {
+    if (filelist_cache_flush_pending) {
+        filelist_cache_flush_pending = false;
+        for (int i = 0; i < FILELIST_CACHE_SIZE; i++) filelist_cache_drop(&filelist_cache[i]);
+        return NULL;
+    }
+    for (int i = 0; i < FILELIST_CACHE_SIZE; i++) {
+        if (filelist_cache[i].dir[0] != '\0' && strcmp(filelist_cache[i].dir, dir) == 0) return &filelist_cache[i];
+    }
+    return NULL;
+}
+
+/**
+ * Put the current listing into the cache. Call once the listing is complete. Never from the GUI task
+ * @param dir_seq Current seqs.directories of the object model. 0 if unknown
+ */
+void reppanel_filelist_cache_store(uint16_t dir_seq) {
+    filelist_lock();
+    filelist_cache_t *slot = filelist_cache_find(reprap_dir_listing.dir);
+    if (slot == NULL) {     // replace the least recently used one
+        slot = &filelist_cache[0];
+        for (int i = 1; i < FILELIST_CACHE_SIZE; i++) {
+            if (filelist_cache[i].last_used < slot->last_used) slot = &filelist_cache[i];
+        }
+    }
+    filelist_cache_drop(slot);
+    if (reprap_dir_listing.count > 0) {
+        slot->entries = filelist_realloc(NULL, reprap_dir_listing.count * sizeof(file_tree_entry_t));
+        slot->names = filelist_realloc(NULL, reprap_dir_listing.names_used);
+        if (slot->entries == NULL || slot->names == NULL) {
+            filelist_cache_drop(slot);
+            filelist_unlock();
+            return;
+        }
+        memcpy(slot->entries, reprap_dir_listing.entries, reprap_dir_listing.count * sizeof(file_tree_entry_t));
+        memcpy(slot->names, reprap_dir_listing.names, reprap_dir_listing.names_used);
+    }
+    strlcpy(slot->dir, reprap_dir_listing.dir, MAX_LEN_DIRNAME);
+    slot->count = reprap_dir_listing.count;
+    slot->names_used = reprap_dir_listing.names_used;
+    slot->dir_seq = dir_seq;
+    slot->fetched = xTaskGetTickCount();
+    slot->last_used = ++filelist_cache_clock;
+    filelist_unlock();
+}
+
+/**
+ * Make a cached listing the current one. Never call from the GUI task
+ * @param dir Directory to list
+ * @param dir_seq Current seqs.directories of the object model. Cached listings with a different one are outdated
+ * @param max_age_ms Cached listings older than that are outdated. 0 for no limit
+ * @return true if the listing was taken from the cache
+ */
+bool reppanel_filelist_cache_load(const char *dir, uint16_t dir_seq, uint32_t max_age_ms) {
+    filelist_lock();
+    filelist_cache_t *cached = filelist_cache_find(dir);
+    if (cached != NULL && (cached->dir_seq != dir_seq ||
+        (max_age_ms > 0 && xTaskGetTickCount() - cached->fetched > pdMS_TO_TICKS(max_age_ms)))) {
+        filelist_cache_drop(cached);
+        cached = NULL;
+    }
+    if (cached == NULL) {
+        filelist_unlock();
+        return false;
+    }
+    reprap_dir_listing.count = 0;
+    reprap_dir_listing.names_used = 0;
+    bool loaded = filelist_reserve(cached->count, cached->names_used);
+    if (loaded) {
+        if (cached->count > 0) {
+            memcpy(reprap_dir_listing.entries, cached->entries, cached->count * sizeof(file_tree_entry_t));
+            memcpy(reprap_dir_listing.names, cached->names, cached->names_used);
+        }
+        strlcpy(reprap_dir_listing.dir, cached->dir, MAX_LEN_DIRNAME);
+        reprap_dir_listing.count = cached->count;
+        reprap_dir_listing.names_used = cached->names_used;
+        reprap_dir_listing.next = 0;
+        reprap_dir_listing.generation++;
+        cached->last_used = ++filelist_cache_clock;
+    }
+    filelist_unlock();
+    if (loaded) ESP_LOGI(TAG, "%s: %i entries from cache", dir, reprap_dir_listing.count);
+    return loaded;
+}
+
+/**
+ * Drop all cached listings before the next lookup. Call after files were changed. Safe from any task
+ */
+void reppanel_filelist_cache_flush() {
+    filelist_cache_flush_pending = true;
+}
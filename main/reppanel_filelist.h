@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_FILELIST_H
+#define REPPANEL_ESP32_REPPANEL_FILELIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cJSON.h>
+#include "reppanel.h"
+
+#define FILELIST_GROW_ENTRIES   64      // entry handles grow by that many entries
+#define FILELIST_GROW_NAMES     1024    // name pool grows by that many bytes
+#define FILELIST_AVG_NAME_LEN   32      // name pool may hold FILELIST_MAX_ENTRIES names of that length
+#define FILELIST_MAX_RETRIES    3       // give up on the rest of a listing if a page fails that often
+#define FILELIST_PAGES_PER_TICK 4       // pages requested per iteration of the request task
+#define FILELIST_CACHE_MAX_AGE_MS   60000   // cached listings expire if the firmware has no seqs.directories (RRF2)
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+#define FILELIST_MAX_ENTRIES    4096
+#define FILELIST_CACHE_SIZE     8       // complete listings kept for browsing back and forth
+#else
+#define FILELIST_MAX_ENTRIES    (MAX_NUM_ELEM_DIR * 4)
+#define FILELIST_CACHE_SIZE     2
+#endif
+#define FILELIST_MAX_NAMES_SIZE (FILELIST_MAX_ENTRIES * FILELIST_AVG_NAME_LEN)
+
+#define FILELIST_STAMP_EPOCH    946684800   // 2000-01-01. Time stamps are stored relative to it
+#define FILELIST_STAMP_MASK     0x7FFFFFFF
+#define FILELIST_FOLDER_FLAG    0x80000000
+
+// One entry of a listing. Swapped when sorting
+typedef struct {
+    uint32_t name;                  // offset of the NULL terminated name in the name pool
+    uint32_t stamp_type;            // seconds since FILELIST_STAMP_EPOCH | FILELIST_FOLDER_FLAG
+} file_tree_entry_t;
+
+// Directory listing (jobs or macros) put together from the pages the Duet returns. Directory is only stored once
+typedef struct {
+    char dir[MAX_LEN_DIRNAME];      // listed directory
+    file_tree_entry_t *entries;     // order of the Duet until the UI sorts them
+    int count;                      // number of valid entries
+    int capacity;                   // number of entries that fit
+    char *names;                    // name pool
+    uint32_t names_used;
+    uint32_t names_size;
+    int next;                       // first entry of the next page to request. 0 once the listing is complete
+    int retries;                    // failed requests for the next page
+    uint32_t generation;            // incremented with every new listing
+} reppanel_dir_listing_t;
+
+// Written by the request task & read by the GUI task. Only access while holding xGuiSemaphore
+extern reppanel_dir_listing_t reprap_dir_listing;
+
+bool reppanel_filelist_add_page(const char *dir, int first, int next, cJSON *files);
+
+bool reppanel_filelist_next_page(char *dir, size_t dir_len, int *first);
+
+const char *reppanel_filelist_name(int index);
+
+int reppanel_filelist_type(int index);
+
+void reppanel_filelist_get(int index, file_tree_elem_t *elem);
+
+void reppanel_filelist_sort(int from);
+
+void reppanel_filelist_cache_store(uint16_t dir_seq);
+
+bool reppanel_filelist_cache_load(const char *dir, uint16_t dir_seq, uint32_t max_age_ms);
+
+void reppanel_filelist_cache_flush();
+
+#endif //REPPANEL_ESP32_REPPANEL_FILELIST_H
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// G-Codes from the GUI are not sent by the GUI task. They are put into a FreeRTOS queue & the request task sends them
+// at the start of its next cycle, so a button press returns right away and the display never waits on the network.
+// Once a G-Code was sent, the request task hands the result back to the GUI task via lv_async_call(). The console
+// history & the optional done callback are updated from there.
+// G-Codes queued within GCODE_BATCH_WINDOW_MS are joined into one newline separated request. If a G-Code sets the same
+// value as the one queued right before it (e.g. fan slider moved twice), only the later one is sent.
+//
+
+#include <string.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <lvgl/lvgl.h>
+
+#include "reppanel_gcode_queue.h"
+#include "reppanel_scheduler.h"
+#include "reppanel_helper.h"
+#include "main.h"
+#ifdef CONFIG_REPPANEL_ESP32_CONSOLE_ENABLED
+#include "reppanel_console.h"
+#endif
+
+#define TAG "GCodeQueue"
+
+static QueueHandle_t gcode_queue = NULL;
+
+/**
+ * Call once before the GUI & request task are started
+ */
+void reppanel_gcode_queue_init() {
+    gcode_queue = xQueueCreate(GCODE_QUEUE_LEN, sizeof(gcode_cmd_t));
+    if (gcode_queue == NULL) ESP_LOGE(TAG, "Failed to create G-Code queue");
+}
+
+/**
+ * Queue a G-Code for the request task. Does not block. Call from GUI task
+ * @param done_cb Called by the GUI task once the G-Code was sent. May be NULL
+ * @return false if the queue is full or the G-Code is too long
+ */
+bool reppanel_gcode_queue_push(const char *gcode, gcode_done_cb_t done_cb, void *user_data) {
+    static gcode_cmd_t cmd;     // only used by the GUI task. Too large for its stack
+    if (gcode_queue == NULL) return false;
+    if (strlen(gcode) >= sizeof(cmd.gcode)) {
+        ESP_LOGE(TAG, "G-Code too long: %s", gcode);
+        return false;
+    }
+    strlcpy(cmd.gcode, gcode, sizeof(cmd.gcode));
+    cmd.done_cb = done_cb;
+    cmd.user_data = user_data;
+    cmd.success = false;
+    if (xQueueSend(gcode_queue, &cmd, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Queue full. Dropping %s", gcode);
+        return false;
+    }
+    reppanel_sched_trigger();   // wake the request task
+    return true;
+}
+
+// G-Codes that set an absolute value. Sending only the last of several in a row has the same effect
+static const struct {
+    const char *code;
+    const char *index_params;   // tell apart the fan, heater, tool... a value is set for
+    bool requires_index;
+} supersedable_gcodes[] = {
+        {"M106", "P",  false},  // fan speed
+        {"M104", "T",  false},  // tool temperature
+        {"M140", "PH", false},  // bed temperature
+        {"M141", "PH", false},  // chamber temperature
+        {"M220", "",   false},  // speed factor
+        {"M221", "D",  false},  // extrusion factor
+        {"M42",  "P",  true},   // GPIO output
+        {"G10",  "P",  true},   // tool temperatures. G10 without P is a retraction
+};
+
+/**
+ * Key of G-Codes that set the same value. Made of the code, the index parameters with their values & the letters of
+ * all other parameters, e.g. "M140 P0 S" for "M140 P0 S60"
+ * @return false if the G-Code can not be superseded
+ */
+static bool gcode_supersede_key(const char *gcode, char *key, size_t key_len) {
+    if (strchr(gcode, '\n') != NULL) return false;
+    size_t word_len = strcspn(gcode, " ");
+    int indx = -1;
+    for (int i = 0; i < sizeof(supersedable_gcodes) / sizeof(supersedable_gcodes[0]); i++) {
+        if (strlen(supersedable_gcodes[i].code) == word_len &&
+            strncmp(gcode, supersedable_gcodes[i].code, word_len) == 0) {
+            indx = i;
+            break;
+        }
+    }
+    if (indx < 0) return false;
+    strlcpy(key, supersedable_gcodes[indx].code, key_len);
+    bool has_index = false;
+    char param[MAX_LEN_GCODE_SUPERSEDE];
+    for (const char *p = gcode + word_len; *p != '\0';) {
+        if (*p == ' ') {
+            p++;
+            continue;
+        }
+        size_t param_len = strcspn(p, " ");
+        if (strchr(supersedable_gcodes[indx].index_params, *p) != NULL) {
+            has_index = true;
+            snprintf(param, sizeof(param), " %.*s", (int) param_len, p);
+        } else {
+            snprintf(param, sizeof(param), " %c", *p);
+        }
+        if (strlcat(key, param, key_len) >= key_len) return false;
+        p += param_len;
+    }
+    return has_index || !supersedable_gcodes[indx].requires_index;
+}
+
+/**
+ * Take the queued G-Codes that are sent with the next request. Waits up to GCODE_BATCH_WINDOW_MS for more G-Codes
+ * once there is one. Call from request task
+ * @param max_encoded_len Longest batch the connection can send once URL encoded. A single G-Code is always taken
+ * @return false if the queue is empty
+ */
+bool reppanel_gcode_queue_pop_batch(gcode_batch_t *batch, size_t max_encoded_len) {
+    static gcode_cmd_t next;            // did not fit into the last batch
+    static bool next_valid = false;
+    char key[MAX_LEN_GCODE_SUPERSEDE], last_key[MAX_LEN_GCODE_SUPERSEDE];
+    bool last_supersedable = false;
+    size_t len = 0;                     // of batch->gcode incl. separators & the terminating null
+    size_t enc_len = 0;                 // of batch->gcode once URL encoded. Separators become %0A
+    batch->num_cmds = 0;
+    batch->gcode[0] = '\0';
+    if (gcode_queue == NULL) return false;
+    TickType_t start = xTaskGetTickCount();
+    while (batch->num_cmds < GCODE_QUEUE_LEN) {
+        gcode_cmd_t *cmd = &batch->cmds[batch->num_cmds];
+        if (next_valid) {
+            *cmd = next;
+            next_valid = false;
+        } else {
+            TickType_t wait = 0;
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (batch->num_cmds > 0 && elapsed < pdMS_TO_TICKS(GCODE_BATCH_WINDOW_MS))
+                wait = pdMS_TO_TICKS(GCODE_BATCH_WINDOW_MS) - elapsed;
+            if (xQueueReceive(gcode_queue, cmd, wait) != pdTRUE) break;
+        }
+        cmd->superseded = false;
+        bool supersedable = gcode_supersede_key(cmd->gcode, key, sizeof(key));
+        bool supersedes = supersedable && last_supersedable && strcmp(key, last_key) == 0;
+        size_t new_len = len + strlen(cmd->gcode) + 1;
+        size_t new_enc_len = enc_len + url_encoded_len(cmd->gcode) + (batch->num_cmds > 0 ? 3 : 0);
+        if (supersedes) {
+            new_len -= strlen(batch->cmds[batch->num_cmds - 1].gcode) + 1;
+            new_enc_len -= url_encoded_len(batch->cmds[batch->num_cmds - 1].gcode) + 3;
+        }
+        if (batch->num_cmds > 0 && (new_len > sizeof(batch->gcode) || new_enc_len > max_encoded_len)) {
+            next = *cmd;
+            next_valid = true;
+            break;
+        }
+        if (supersedes) batch->cmds[batch->num_cmds - 1].superseded = true;
+        len = new_len;
+        enc_len = new_enc_len;
+        last_supersedable = supersedable;
+        if (supersedable) strlcpy(last_key, key, sizeof(last_key));
+        batch->num_cmds++;
+    }
+    for (int i = 0; i < batch->num_cmds; i++) {
+        if (batch->cmds[i].superseded) continue;
+        if (batch->gcode[0] != '\0') strlcat(batch->gcode, "\n", sizeof(batch->gcode));
+        strlcat(batch->gcode, batch->cmds[i].gcode, sizeof(batch->gcode));
+    }
+    return batch->num_cmds > 0;
+}
+
+static void gcode_done_async(void *data) {
+    gcode_cmd_t *cmd = data;
+#ifdef CONFIG_REPPANEL_ESP32_CONSOLE_ENABLED
+    add_console_hist_entry(cmd->gcode, cmd->success ? CONSOLE_TYPE_REPPANEL : CONSOLE_TYPE_WARN);
+    update_entries_ui();
+#endif
+    if (cmd->done_cb != NULL) cmd->done_cb(cmd->gcode, cmd->success, cmd->user_data);
+    free(cmd);
+}
+
+static void gcode_done(const gcode_cmd_t *cmd, bool success) {
+    gcode_cmd_t *result = malloc(sizeof(gcode_cmd_t));
+    if (result == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate result of %s", cmd->gcode);
+        return;
+    }
+    *result = *cmd;
+    result->success = success;
+    // lv_async_call() creates an lv_task so LVGL must be locked
+    if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, portMAX_DELAY) == pdTRUE) {
+        lv_res_t res = lv_async_call(gcode_done_async, result);
+        xSemaphoreGive(xGuiSemaphore);
+        if (res == LV_RES_OK) return;
+    }
+    free(result);
+}
+
+/**
+ * Report the result of a popped batch to the GUI task. Superseded G-Codes share the result. Call from request task
+ */
+void reppanel_gcode_queue_batch_done(const gcode_batch_t *batch, bool success) {
+    if (!success) ESP_LOGW(TAG, "Failed to send %s", batch->gcode);
+    for (int i = 0; i < batch->num_cmds; i++) gcode_done(&batch->cmds[i], success);
+}
@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_GCODE_QUEUE_H
+#define REPPANEL_ESP32_REPPANEL_GCODE_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "reppanel.h"
+
+#define GCODE_QUEUE_LEN         8
+#define MAX_LEN_GCODE           (MAX_LEN_DIRNAME + MAX_LEN_FILENAME + 16)  // fits M32 "<dir>/<file>"
+#define GCODE_BATCH_WINDOW_MS   50      // G-Codes queued this long after the first one are sent along with it
+#define MAX_LEN_GCODE_SUPERSEDE 32
+
+/**
+ * Called by the GUI task once the G-Code was sent or dropped
+ * @param success false if the printer did not accept the G-Code or the connection was lost
+ */
+typedef void (*gcode_done_cb_t)(const char *gcode, bool success, void *user_data);
+
+typedef struct {
+    char gcode[MAX_LEN_GCODE];
+    gcode_done_cb_t done_cb;    // may be NULL
+    void *user_data;
+    bool success;
+    bool superseded;            // a later G-Code of the batch sets the same value
+} gcode_cmd_t;
+
+// G-Codes sent with a single request
+typedef struct {
+    gcode_cmd_t cmds[GCODE_QUEUE_LEN];
+    int num_cmds;
+    char gcode[MAX_LEN_GCODE];  // G-Codes of cmds that are not superseded. Separated by '\n'
+} gcode_batch_t;
+
+void reppanel_gcode_queue_init();
+
+bool reppanel_gcode_queue_push(const char *gcode, gcode_done_cb_t done_cb, void *user_data);
+
+bool reppanel_gcode_queue_pop_batch(gcode_batch_t *batch, size_t max_encoded_len);
+
+void reppanel_gcode_queue_batch_done(const gcode_batch_t *batch, bool success);
+
+#endif //REPPANEL_ESP32_REPPANEL_GCODE_QUEUE_H
@@ -50,6 +50,16 @@ char *url_encode(unsigned char *s, char *enc) {
     return (enc);
 }
 
+/**
+ * @return Length of s after url_encode() without the terminating null
+ */
+size_t url_encoded_len(const char *s) {
+    if (!encoding_inited) url_encoder_rfc_tables_init();
+    size_t len = 0;
+    for (; *s; s++) len += html5[(unsigned char) *s] ? 1 : 3;
+    return len;
+}
+
 bool ends_with(const char *base, char *str) {
     int blen = strlen(base);
     int slen = strlen(str);
@@ -60,10 +70,6 @@ void init_reprap_buffers() {
     for (int i = 0; i < MAX_NUM_TOOLS; i++) {
         reprap_extruder_amounts[i] = -1;
         reprap_extruder_feedrates[i] = -1;
-        reprap_chamber_temp_buff[i] = -1;
-    }
-    for (int i = 0; i < MAX_NUM_ELEM_DIR; i++) {
-        reprap_dir_elem[i].type = TREE_EMPTY_ELEM;
     }
 #ifdef CONFIG_REPPANEL_ESP32_CONSOLE_ENABLED
     for (int i = 0; i < MAX_CONSOLE_ENTRY_COUNT; i++) {
@@ -106,23 +112,6 @@ time_t datestr_2unix(const char *input) {
     }
 }
 
-/**
- * Compare function for qsort. Compares file_tree_elem_t structures by modification date/time stamp. Most recent element
- * is first in order (highest number first)
- * @param a type file_tree_elem_t
- * @param b type file_tree_elem_t
- * @return see qsort docs
- */
-int compare_tree_element_timestamp(const void *a, const void *b) {
-    file_tree_elem_t *tree_elemA = (file_tree_elem_t *) a;
-    file_tree_elem_t *tree_elemB = (file_tree_elem_t *) b;
-    if (tree_elemA->time_stamp - tree_elemB->time_stamp < 0)
-        return 1;
-    if (tree_elemA->time_stamp - tree_elemB->time_stamp > 0)
-        return -1;
-    return 0;
-}
-
 void RepPanelLogE(char *tag, char *msg) {
     ESP_LOGE(tag, "%s", msg);
 }
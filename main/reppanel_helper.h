@@ -16,6 +16,8 @@ char *get_version_string();
 
 char *url_encode(unsigned char *s, char *enc);
 
+size_t url_encoded_len(const char *s);
+
 bool ends_with(const char *base, char *str);
 
 void init_reprap_buffers();
@@ -26,8 +28,6 @@ void get_avail_duets(char *txt_buffer);
 
 time_t datestr_2unix(const char *input);
 
-int compare_tree_element_timestamp(const void *a, const void *b);
-
 void RepPanelLogE(char *tag, char *msg);
 
 void RepPanelLogW(char *tag, char *msg);
@@ -1,36 +1,125 @@
 //
 // Copyright (c) 2022 Wolfgang Christl
 // Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// LVGL image decoder for QOI images (https://qoiformat.org/qoi-specification.pdf) like the thumbnails RRF3.4+ reads
+// from G-code files. The image is not decoded as a whole. LVGL requests the image line by line via read_line and each
+// line is decoded from the compressed data when requested. Lines are mostly requested top to bottom, so decoding
+// continues where the last line ended. Only in case LVGL asks for an earlier line decoding starts over.
+//
 
-#ifdef CONFIG_LVGL_TFT_DISPLAY_MONOCHROME
+#include <string.h>
+#include <lvgl/lvgl.h>
+#include <esp_log.h>
 #include "reppanel_img_decoder.h"
-#include "src/lv_draw/lv_img_decoder.h"
-#include "../externals/qoi/qoi.h"
 
-// https://docs.lvgl.io/6.1/overview/image.html?highlight=image%20decoder
+#define TAG "ImgDecoder"
+
+#define QOI_OP_INDEX    0x00
+#define QOI_OP_DIFF     0x40
+#define QOI_OP_LUMA     0x80
+#define QOI_OP_RUN      0xc0
+#define QOI_OP_RGB      0xfe
+#define QOI_OP_RGBA     0xff
+#define QOI_MASK_2      0xc0
+#define QOI_COLOR_HASH(px)  ((px)[0] * 3 + (px)[1] * 5 + (px)[2] * 7 + (px)[3] * 11)
+
+static uint32_t qoi_read_u32(const uint8_t *bytes) {
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
 
-bool is_qoi_image(const uint8_t *data) {
+bool is_qoi_image(const uint8_t *data, uint32_t size) {
+    if (data == NULL || size < QOI_HEADER_SIZE + QOI_PADDING_SIZE) return false;
     if (data[0] == 'q' && data[1] == 'o' && data[2] == 'i' && data[3] == 'f') {
         return true;
     }
     return false;
 }
 
+/**
+ * Prepare decoding an image from the start
+ * @param data QOI image incl. header. Must stay valid while decoding
+ * @return false if this is no QOI image
+ */
+bool qoi_stream_init(qoi_stream_t *stream, const uint8_t *data, uint32_t size) {
+    if (!is_qoi_image(data, size)) return false;
+    memset(stream, 0, sizeof(qoi_stream_t));
+    stream->data = data;
+    stream->size = size - QOI_PADDING_SIZE;
+    stream->width = qoi_read_u32(&data[4]);
+    stream->height = qoi_read_u32(&data[8]);
+    stream->channels = data[12];
+    stream->pos = QOI_HEADER_SIZE;
+    stream->px[3] = 255;
+    if (stream->width == 0 || stream->height == 0 || (stream->channels != 3 && stream->channels != 4)) return false;
+    return true;
+}
+
+/**
+ * Decode the next pixel
+ * @param rgba Receives the pixel as R, G, B, A
+ * @return false if all pixels were read or the data ends within an op. Missing ops repeat the last pixel
+ */
+bool qoi_stream_read(qoi_stream_t *stream, uint8_t *rgba) {
+    if (stream->px_pos >= stream->width * stream->height) return false;
+    if (stream->run > 0) {
+        stream->run--;
+    } else if (stream->pos < stream->size) {
+        uint8_t *px = stream->px;
+        uint8_t b1 = stream->data[stream->pos++];
+        if (b1 == QOI_OP_RGB) {
+            if (stream->pos + 3 > stream->size) return false;
+            px[0] = stream->data[stream->pos++];
+            px[1] = stream->data[stream->pos++];
+            px[2] = stream->data[stream->pos++];
+        } else if (b1 == QOI_OP_RGBA) {
+            if (stream->pos + 4 > stream->size) return false;
+            px[0] = stream->data[stream->pos++];
+            px[1] = stream->data[stream->pos++];
+            px[2] = stream->data[stream->pos++];
+            px[3] = stream->data[stream->pos++];
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+            memcpy(px, stream->index[b1], 4);
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+            px[0] += ((b1 >> 4) & 0x03) - 2;
+            px[1] += ((b1 >> 2) & 0x03) - 2;
+            px[2] += (b1 & 0x03) - 2;
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+            if (stream->pos >= stream->size) return false;
+            uint8_t b2 = stream->data[stream->pos++];
+            int vg = (b1 & 0x3f) - 32;
+            px[0] += vg - 8 + ((b2 >> 4) & 0x0f);
+            px[1] += vg;
+            px[2] += vg - 8 + (b2 & 0x0f);
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_RUN) {
+            stream->run = (b1 & 0x3f);
+        }
+        memcpy(stream->index[QOI_COLOR_HASH(px) % 64], px, 4);
+    }
+    memcpy(rgba, stream->px, 4);
+    stream->px_pos++;
+    return true;
+}
+
+#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+// https://docs.lvgl.io/6.1/overview/image.html?highlight=image%20decoder
+
 /**
  * Get info about a QOI image
  * @param decoder pointer to the decoder where this function belongs
- * @param src can be file name or pointer to a C array
+ * @param src lv_img_dsc_t with the QOI image as data
  * @param header store the info here
  * @return LV_RES_OK: no error; LV_RES_INV: can't get the info
  */
 static lv_res_t decoder_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header) {
-    uint8_t *bytes = (uint8_t *) src;
-    if(is_qoi_image(bytes) == false) return LV_RES_INV;
-
-    int p = 4;
-    header->w = qoi_read_32(bytes, &p);
-    header->h = qoi_read_32(bytes, &p);
-    unsigned char channels = bytes[p++];
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+    const lv_img_dsc_t *img = src;
+    if (is_qoi_image(img->data, img->data_size) == false) return LV_RES_INV;
+
+    header->w = qoi_read_u32(&img->data[4]);
+    header->h = qoi_read_u32(&img->data[8]);
+    header->always_zero = 0;
+    unsigned char channels = img->data[12];
     if (channels == 3) {
         header->cf = LV_IMG_CF_RAW;
     } else if (channels == 4) {
@@ -42,44 +131,57 @@ static lv_res_t decoder_info(lv_img_decoder_t *decoder, const void *src, lv_img_
 }
 
 /**
- * Open a QOI image and return the decided image
+ * Open a QOI image. Nothing is decoded here. dsc->img_data stays NULL so LVGL uses decoder_read_line
  * @param decoder pointer to the decoder where this function belongs
  * @param dsc pointer to a descriptor which describes this decoding session
  * @return LV_RES_OK: no error; LV_RES_INV: can't get the info
  */
-static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc) {
-    /*Check whether the type `src` is known by the decoder*/
-//    if(is_qoi_image(src) == false) return LV_RES_INV;
-
-    qoi_desc *d;
-    /*Decode and store the image. If `dsc->img_data` is `NULL`, the `read_line` function will be called to get the image data line-by-line*/
-//    dsc->img_data = qoi_decode(src, size, d, 0);
-
-    /*Change the color format if required. For PNG usually 'Raw' is fine*/
-    dsc->header.cf = LV_IMG_CF_RAW;
-
-    /*Call a built in decoder function if required. It's not required if`my_png_decoder` opened the image in true color format.*/
-    lv_res_t res = lv_img_decoder_built_in_open(decoder, dsc);
-
-    return res;
+static lv_res_t decoder_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+    if (dsc->src_type != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+    const lv_img_dsc_t *img = dsc->src;
+    qoi_stream_t *stream = lv_mem_alloc(sizeof(qoi_stream_t));
+    if (stream == NULL) {
+        ESP_LOGW(TAG, "Not enough memory to decode QOI image");
+        return LV_RES_INV;
+    }
+    if (!qoi_stream_init(stream, img->data, img->data_size)) {
+        lv_mem_free(stream);
+        return LV_RES_INV;
+    }
+    dsc->user_data = stream;
+    dsc->img_data = NULL;
+    return LV_RES_OK;
 }
 
 /**
  * Decode `len` pixels starting from the given `x`, `y` coordinates and store them in `buf`.
- * Required only if the "open" function can't open the whole decoded pixel array. (dsc->img_data == NULL)
  * @param decoder pointer to the decoder the function associated with
  * @param dsc pointer to decoder descriptor
  * @param x start x coordinate
  * @param y start y coordinate
  * @param len number of pixels to decode
- * @param buf a buffer to store the decoded pixels
+ * @param buf a buffer to store the decoded pixels. lv_color_t followed by an alpha byte in case of LV_IMG_CF_RAW_ALPHA
  * @return LV_RES_OK: ok; LV_RES_INV: failed
  */
-lv_res_t decoder_built_in_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc, lv_coord_t x,
-                                    lv_coord_t y, lv_coord_t len, uint8_t * buf) {
-
-    /*Copy `len` pixels from `x` and `y` coordinates in True color format to `buf` */
-
+static lv_res_t decoder_read_line(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc, lv_coord_t x, lv_coord_t y,
+                                  lv_coord_t len, uint8_t *buf) {
+    qoi_stream_t *stream = dsc->user_data;
+    uint32_t first_px = (uint32_t) y * stream->width + x;
+    if (first_px < stream->px_pos && !qoi_stream_init(stream, stream->data, stream->size + QOI_PADDING_SIZE))
+        return LV_RES_INV;
+    uint8_t rgba[4];
+    while (stream->px_pos < first_px) {
+        if (!qoi_stream_read(stream, rgba)) return LV_RES_INV;
+    }
+    bool alpha = stream->channels == 4;
+    uint8_t px_size = sizeof(lv_color_t) + (alpha ? 1 : 0);
+    for (lv_coord_t i = 0; i < len; i++) {
+        if (!qoi_stream_read(stream, rgba)) return LV_RES_INV;
+        lv_color_t color = lv_color_make(rgba[0], rgba[1], rgba[2]);
+        memcpy(&buf[i * px_size], &color, sizeof(lv_color_t));
+        if (alpha) buf[i * px_size + sizeof(lv_color_t)] = rgba[3];
+    }
+    return LV_RES_OK;
 }
 
 /**
@@ -87,11 +189,19 @@ lv_res_t decoder_built_in_read_line(lv_img_decoder_t * decoder, lv_img_decoder_d
  * @param decoder pointer to the decoder where this function belongs
  * @param dsc pointer to a descriptor which describes this decoding session
  */
-static void decoder_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc) {
-    /*Free all allocated data*/
-
-    /*Call the built-in close function if the built-in open/read_line was used*/
-    lv_img_decoder_built_in_close(decoder, dsc);
+static void decoder_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc) {
+    if (dsc->user_data) lv_mem_free(dsc->user_data);
+    dsc->user_data = NULL;
+}
 
+/**
+ * Register the QOI decoder with LVGL. Call after lv_init()
+ */
+void reppanel_img_decoder_init() {
+    lv_img_decoder_t *decoder = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(decoder, decoder_info);
+    lv_img_decoder_set_open_cb(decoder, decoder_open);
+    lv_img_decoder_set_read_line_cb(decoder, decoder_read_line);
+    lv_img_decoder_set_close_cb(decoder, decoder_close);
 }
-#endif
\ No newline at end of file
+#endif
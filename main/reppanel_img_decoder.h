@@ -5,4 +5,32 @@
 #ifndef REPPANEL_ESP32_REPPANEL_IMG_DECODER_H
 #define REPPANEL_ESP32_REPPANEL_IMG_DECODER_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define QOI_HEADER_SIZE     14
+#define QOI_PADDING_SIZE    8
+
+// Decodes a QOI image pixel by pixel. Only the compressed data is kept in memory
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t pos;           // next byte of data to read
+    uint32_t width;
+    uint32_t height;
+    uint8_t channels;       // 3 RGB, 4 RGBA
+    uint32_t px_pos;        // number of pixels read
+    uint8_t run;            // pixels left that repeat px
+    uint8_t px[4];          // last pixel RGBA
+    uint8_t index[64][4];   // previously seen pixels
+} qoi_stream_t;
+
+bool is_qoi_image(const uint8_t *data, uint32_t size);
+
+bool qoi_stream_init(qoi_stream_t *stream, const uint8_t *data, uint32_t size);
+
+bool qoi_stream_read(qoi_stream_t *stream, uint8_t *rgba);
+
+void reppanel_img_decoder_init();
+
 #endif //REPPANEL_ESP32_REPPANEL_IMG_DECODER_H
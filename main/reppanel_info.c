@@ -10,16 +10,19 @@
 #include "reppanel_info.h"
 #include "reppanel.h"
 #include "esp32_wifi.h"
+#include "esp32_uart.h"
 
 #define TAG "RepPanelInfo"
 
+static const uint32_t uart_baud_options[] = {57600, 115200, 230400, 460800};    // same order as in ddl_uart_baud
+
 lv_obj_t *info_page;
 lv_obj_t *ta_wifi_pass;
 lv_obj_t *ta_ssid;
 lv_obj_t *ta_printer_addr;
 lv_obj_t *ta_reprap_pass;
 static lv_obj_t *cont_overlay, *cont_overlay_duet_addr;
-static lv_obj_t *ddl_ssid, *ddl_duets;
+static lv_obj_t *ddl_ssid, *ddl_duets, *ddl_uart_baud;
 
 static lv_obj_t *kb;
 
@@ -42,7 +45,11 @@ static void save_reppanel_settings_event(lv_obj_t *obj, lv_event_t event) {
         }
         const char *tmp_rep_pass = lv_ta_get_text(ta_reprap_pass);
         strlcpy(rep_pass, tmp_rep_pass, sizeof(rep_pass));
+        uint32_t new_baud_rate = uart_baud_options[lv_ddlist_get_selected(ddl_uart_baud)];
+        bool baud_rate_changed = new_baud_rate != uart_baud_rate;
+        uart_baud_rate = new_baud_rate;
         write_settings_to_nvs();
+        if (baud_rate_changed) reppanel_uart_request_baud_rate(uart_baud_rate);
         reconnect_wifi();
     }
 }
@@ -252,6 +259,17 @@ void draw_info(lv_obj_t *parent_screen) {
     lv_obj_set_event_cb(ta_reprap_pass, ta_event_cb);
     lv_ta_set_one_line(ta_reprap_pass, true);
 
+    lv_obj_t *uart_baud_cnt = lv_cont_create(info_page, ssid_cnt);
+    lv_obj_t *label_uart_baud = lv_label_create(uart_baud_cnt, NULL);
+    lv_label_set_text(label_uart_baud, "UART baud rate:");
+
+    ddl_uart_baud = lv_ddlist_create(uart_baud_cnt, NULL);
+    lv_ddlist_set_options(ddl_uart_baud, "57600\n115200\n230400\n460800");
+    lv_ddlist_set_align(ddl_uart_baud, LV_LABEL_ALIGN_LEFT);
+    for (int i = 0; i < sizeof(uart_baud_options) / sizeof(uart_baud_options[0]); i++) {
+        if (uart_baud_options[i] == uart_baud_rate) lv_ddlist_set_selected(ddl_uart_baud, i);
+    }
+
 //    label_sig_strength = lv_label_create(info_page, NULL);
 //    lv_label_set_recolor(label_sig_strength, true);
 //    lv_label_set_long_mode(label_sig_strength, LV_LABEL_LONG_BREAK);
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Controls that fire many events in short succession (fan slider while dragged, Z jog buttons tapped quickly) do not
+// send a G-Code per event. Their latest target is kept per control & at most one G-Code per INPUT_COALESCE_MS is
+// queued. An lv_task sends whatever is still pending once the interval is over, so the final value always reaches
+// the printer. Only used by the GUI task.
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <esp_log.h>
+#include <lvgl/lvgl.h>
+
+#include "reppanel_input_coalesce.h"
+#include "reppanel_request.h"
+#include "reppanel.h"
+
+#define TAG "InputCoalesce"
+
+typedef struct {
+    const char *gcode_fmt;      // gets the value
+    bool relative;              // values add up till they are sent
+    double value;
+    bool pending;
+    uint32_t last_sent;         // lv_tick_get()
+} input_coalesce_t;
+
+static input_coalesce_t controls[INPUT_COALESCE_NUM] = {
+        [INPUT_COALESCE_FAN] = {.gcode_fmt = "M106 S%.2f", .relative = false},
+        [INPUT_COALESCE_Z_JOG] = {.gcode_fmt = "M120\nG91\nG1 Z%.3f F6000\nG90\nM121", .relative = true},
+};
+
+static void input_coalesce_send(input_coalesce_t *ctrl) {
+    if (rp_conn_stat != REPPANEL_WIFI_CONNECTED && rp_conn_stat != REPPANEL_UART_CONNECTED) {
+        ctrl->pending = false;  // not sent after a reconnect
+        if (ctrl->relative) ctrl->value = 0;
+        return;
+    }
+    if (ctrl->relative && fabs(ctrl->value) < 0.0005) {    // moves cancelled out
+        ctrl->pending = false;
+        ctrl->value = 0;
+        return;
+    }
+    char gcode[64];
+    snprintf(gcode, sizeof(gcode), ctrl->gcode_fmt, ctrl->value);
+    if (!reprap_send_gcode(gcode)) return;     // G-Code queue is full. Task tries again
+    ctrl->pending = false;
+    if (ctrl->relative) ctrl->value = 0;
+    ctrl->last_sent = lv_tick_get();
+}
+
+static void input_coalesce_task(lv_task_t *task) {
+    for (int i = 0; i < INPUT_COALESCE_NUM; i++) {
+        if (controls[i].pending && lv_tick_elaps(controls[i].last_sent) >= INPUT_COALESCE_MS)
+            input_coalesce_send(&controls[i]);
+    }
+}
+
+static void input_coalesce_changed(input_coalesce_ctrl_t ctrl) {
+    controls[ctrl].pending = true;
+    if (lv_tick_elaps(controls[ctrl].last_sent) >= INPUT_COALESCE_MS) input_coalesce_send(&controls[ctrl]);
+}
+
+/**
+ * Call once after lv_init()
+ */
+void reppanel_input_coalesce_init() {
+    if (lv_task_create(input_coalesce_task, INPUT_COALESCE_TASK_MS, LV_TASK_PRIO_LOW, NULL) == NULL)
+        ESP_LOGE(TAG, "Failed to create task");
+}
+
+/**
+ * New target of a control. Replaces a target that was not sent yet
+ */
+void reppanel_input_coalesce_set(input_coalesce_ctrl_t ctrl, double value) {
+    controls[ctrl].value = value;
+    input_coalesce_changed(ctrl);
+}
+
+/**
+ * Add to the target of a relative control. Sent as the sum of all deltas since the last G-Code
+ */
+void reppanel_input_coalesce_add(input_coalesce_ctrl_t ctrl, double delta) {
+    controls[ctrl].value += delta;
+    input_coalesce_changed(ctrl);
+}
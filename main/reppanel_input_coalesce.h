@@ -0,0 +1,24 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_INPUT_COALESCE_H
+#define REPPANEL_ESP32_REPPANEL_INPUT_COALESCE_H
+
+#define INPUT_COALESCE_MS           CONFIG_REPPANEL_INPUT_COALESCE_MS
+#define INPUT_COALESCE_TASK_MS      20      // how often pending values are checked
+
+typedef enum {
+    INPUT_COALESCE_FAN,         // fan speed 0..1. Latest value is sent
+    INPUT_COALESCE_Z_JOG,       // [mm] Z moves add up till they are sent
+    INPUT_COALESCE_NUM
+} input_coalesce_ctrl_t;
+
+void reppanel_input_coalesce_init();
+
+void reppanel_input_coalesce_set(input_coalesce_ctrl_t ctrl, double value);
+
+void reppanel_input_coalesce_add(input_coalesce_ctrl_t ctrl, double delta);
+
+#endif //REPPANEL_ESP32_REPPANEL_INPUT_COALESCE_H
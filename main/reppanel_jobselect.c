@@ -10,6 +10,9 @@
 #include "reppanel.h"
 #include "reppanel_request.h"
 #include "rrf_objects.h"
+#include "reppanel_filelist.h"
+#include "reppanel_vlist.h"
+#include "reppanel_thumbnail.h"
 
 #define TAG             "JobSelect"
 #define CANCEL_BTN_TXT  "#ffffff Cancel#"
@@ -21,19 +24,22 @@
 #define JOBS_EMPTY ""
 #define BACK_TXT    "Back"
 
-lv_obj_t *jobs_list;
+static reppanel_vlist_t jobs_list;
 lv_obj_t *msg_box1; // file info msg box
+static lv_obj_t *img_file_thumbnail;    // part of msg_box1
 lv_obj_t *msg_box2; // delete confirmation message box
 lv_obj_t *msg_box3; // print confirmation message box
 lv_obj_t *preloader;
 
 char parent_dir_jobs[MAX_LEN_DIRNAME + 1];
-file_tree_elem_t *edit_job;
+file_tree_elem_t edit_job;      // copy of the selected entry. Listing may change while a dialog is open
+static uint32_t shown_generation;   // listing generation the rows of jobs_list show
+static bool has_back_btn;           // first row of jobs_list is the back button
 
 void send_print_command() {
-    ESP_LOGI(TAG, "Printing %s", edit_job->name);
-    char tmp_txt[strlen(edit_job->dir) + strlen(edit_job->name) + 10];
-    sprintf(tmp_txt, "M32 \"%s/%s\"", edit_job->dir, edit_job->name);
+    ESP_LOGI(TAG, "Printing %s", edit_job.name);
+    char tmp_txt[strlen(edit_job.dir) + strlen(edit_job.name) + 10];
+    sprintf(tmp_txt, "M32 \"%s/%s\"", edit_job.dir, edit_job.name);
     reprap_send_gcode(tmp_txt);
 }
 
@@ -52,13 +58,14 @@ static void print_file_handler(lv_obj_t *obj, lv_event_t event) {
 static void delete_file_handler(lv_obj_t *obj, lv_event_t event) {
     if (event == LV_EVENT_VALUE_CHANGED) {
         if (strcmp(lv_mbox_get_active_btn_text(msg_box2), "Yes") == 0) {
-            ESP_LOGI(TAG, "Deleting %s", edit_job->name);
-            char tmp_txt[strlen(edit_job->dir) + strlen(edit_job->name) + 10];
-            sprintf(tmp_txt, "M30 \"%s/%s\"", edit_job->dir, edit_job->name);
+            ESP_LOGI(TAG, "Deleting %s", edit_job.name);
+            char tmp_txt[strlen(edit_job.dir) + strlen(edit_job.name) + 10];
+            sprintf(tmp_txt, "M30 \"%s/%s\"", edit_job.dir, edit_job.name);
             reprap_send_gcode(tmp_txt);
+            reppanel_filelist_cache_flush();
             lv_obj_del_async(msg_box2);
             lv_obj_del_async(msg_box1);
-            request_jobs(edit_job->dir);
+            request_jobs(edit_job.dir);
         } else {
             lv_obj_del_async(msg_box2);
         }
@@ -66,7 +73,10 @@ static void delete_file_handler(lv_obj_t *obj, lv_event_t event) {
 }
 
 static void job_action_handler(lv_obj_t *obj, lv_event_t event) {
-    if (event == LV_EVENT_VALUE_CHANGED) {
+    if (event == LV_EVENT_DELETE && obj == msg_box1) {
+        msg_box1 = NULL;
+        img_file_thumbnail = NULL;
+    } else if (event == LV_EVENT_VALUE_CHANGED) {
         if (strcmp(lv_mbox_get_active_btn_text(msg_box1), CANCEL_BTN_TXT) == 0) {
             ESP_LOGI(TAG, "Close window. No action");
             lv_obj_del_async(msg_box1);
@@ -83,9 +93,9 @@ static void job_action_handler(lv_obj_t *obj, lv_event_t event) {
             lv_obj_del_async(msg_box1);
             display_jobstatus();
         } else if (strcmp(lv_mbox_get_active_btn_text(msg_box1), SIM_BTN_TXT) == 0) {
-            ESP_LOGI(TAG, "Simulate %s", edit_job->name);
-            char tmp_txt[strlen(edit_job->dir) + strlen(edit_job->name) + 10];
-            sprintf(tmp_txt, "M37 P\"%s/%s\"", edit_job->dir, edit_job->name);
+            ESP_LOGI(TAG, "Simulate %s", edit_job.name);
+            char tmp_txt[strlen(edit_job.dir) + strlen(edit_job.name) + 10];
+            sprintf(tmp_txt, "M37 P\"%s/%s\"", edit_job.dir, edit_job.name);
             reprap_send_gcode(tmp_txt);
             lv_obj_del_async(msg_box1);
             display_jobstatus();
@@ -115,10 +125,42 @@ void update_file_info_dialog_ui(reprap_model_t *_reprap_model) {
     lv_mbox_set_text(msg_box1, mbox_txt);
 }
 
-static void job_clicked_event_handler(lv_obj_t *obj, lv_event_t event) {
-    int selected_indx = lv_list_get_btn_index(jobs_list, obj);
+/**
+ * Show the thumbnail of edit_job in the file info dialog once it was fetched
+ */
+void update_file_info_thumbnail_ui() {
+    if (!msg_box1) return;
+    char file_path[MAX_LEN_DIRNAME + MAX_LEN_FILENAME + 2];
+    snprintf(file_path, sizeof(file_path), "%s/%s", edit_job.dir, edit_job.name);
+    const void *src = reppanel_thumbnail_src(file_path);
+    if (src == NULL) {
+        if (img_file_thumbnail) lv_obj_set_hidden(img_file_thumbnail, true);
+        return;
+    }
+    if (!img_file_thumbnail) {
+        img_file_thumbnail = lv_img_create(msg_box1, NULL);
+        lv_obj_move_background(img_file_thumbnail);    // show above the text
+    }
+    lv_img_set_src(img_file_thumbnail, src);
+    lv_obj_set_hidden(img_file_thumbnail, false);
+}
+
+static void job_row_text(int index, const char **symbol, const char **text) {
+    if (has_back_btn) {
+        if (index == 0) {
+            *symbol = LV_SYMBOL_LEFT;
+            *text = BACK_TXT;
+            return;
+        }
+        index--;
+    }
+    *symbol = reppanel_filelist_type(index) == TREE_FOLDER_ELEM ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE;
+    *text = reppanel_filelist_name(index);
+}
+
+static void job_clicked_event_handler(int selected_indx, lv_event_t event) {
     // check if back button exists
-    if (strcmp(reprap_dir_elem[0].dir, JOBS_ROOT_DIR) != 0) {
+    if (has_back_btn) {
         if (selected_indx == 0 && event == LV_EVENT_SHORT_CLICKED) {
             // back button was pressed
             ESP_LOGI(TAG, "Going back to parent %s", parent_dir_jobs);
@@ -130,39 +172,41 @@ static void job_clicked_event_handler(lv_obj_t *obj, lv_event_t event) {
             return;
         } else if (selected_indx != 0) {
             // no back button pressed
-            // decrease index to match with reprap_macros array indexing
+            // decrease index to match with reprap_dir_listing indexing
             selected_indx--;
         }
     }
-    edit_job = &reprap_dir_elem[selected_indx];
+    // rows are outdated in case a new listing arrived but the list was not updated yet
+    if (shown_generation != reprap_dir_listing.generation || selected_indx >= reprap_dir_listing.count) return;
+    reppanel_filelist_get(selected_indx, &edit_job);
     if (event == LV_EVENT_SHORT_CLICKED) {
-        if (reprap_dir_elem[selected_indx].type == TREE_FILE_ELEM) {
+        if (edit_job.type == TREE_FILE_ELEM) {
             static const char *btns[] = {"Yes", "No", ""};
             msg_box3 = lv_mbox_create(lv_layer_top(), NULL);
-            char msg[strlen(edit_job->name) + 23];
-            sprintf(msg, "Do you want to print %s?", edit_job->name);
+            char msg[strlen(edit_job.name) + 23];
+            sprintf(msg, "Do you want to print %s?", edit_job.name);
             lv_mbox_set_text(msg_box3, msg);
             lv_mbox_add_btns(msg_box3, btns);
             lv_obj_set_event_cb(msg_box3, print_file_handler);
             lv_obj_set_width(msg_box3, lv_disp_get_hor_res(NULL) - 20);
             lv_obj_align(msg_box3, lv_layer_top(), LV_ALIGN_CENTER, 0, 0);
-        } else if (reprap_dir_elem[selected_indx].type == TREE_FOLDER_ELEM) {
-            ESP_LOGI(TAG, "Clicked folder %s (index %i)", edit_job->name, selected_indx);
+        } else if (edit_job.type == TREE_FOLDER_ELEM) {
+            ESP_LOGI(TAG, "Clicked folder %s (index %i)", edit_job.name, selected_indx);
             if (!preloader)
                 preloader = lv_preload_create(lv_layer_top(), NULL);
             lv_obj_set_size(preloader, 75, 75);
             lv_obj_align_origo(preloader, lv_layer_top(), LV_ALIGN_CENTER, 0, 0);
             static char tmp_txt_job_path[MAX_LEN_DIRNAME + MAX_LEN_FILENAME + 1];
-            sprintf(tmp_txt_job_path, "%s/%s", reprap_dir_elem[selected_indx].dir, edit_job->name);
+            sprintf(tmp_txt_job_path, "%s/%s", edit_job.dir, edit_job.name);
             request_jobs(tmp_txt_job_path);
         } else {
             ESP_LOGW(TAG, "Selected unknown file tree element -> Index: %i - Type: %i - Name: %s - Dir: %s", selected_indx,
-                     reprap_dir_elem[selected_indx].type, reprap_dir_elem[selected_indx].name, reprap_dir_elem[selected_indx].dir);
+                     edit_job.type, edit_job.name, edit_job.dir);
         }
-    } else if (event == LV_EVENT_LONG_PRESSED && reprap_dir_elem[selected_indx].type == TREE_FILE_ELEM) {   // file info dialog
+    } else if (event == LV_EVENT_LONG_PRESSED && edit_job.type == TREE_FILE_ELEM) {   // file info dialog
         // request file info
-        char tmp_txt[strlen(edit_job->dir) + strlen(edit_job->name) + 2];
-        sprintf(tmp_txt, "%s/%s", edit_job->dir, edit_job->name);
+        char tmp_txt[strlen(edit_job.dir) + strlen(edit_job.name) + 2];
+        sprintf(tmp_txt, "%s/%s", edit_job.dir, edit_job.name);
         trigger_request_fileinfo(tmp_txt);
         // build UI
         static const char *btns[] = {SIM_BTN_TXT, PRINT_BTN_TXT, DELETE_BTN_TXT, CANCEL_BTN_TXT, ""};
@@ -173,46 +217,46 @@ static void job_clicked_event_handler(lv_obj_t *obj, lv_event_t event) {
         lv_obj_set_width(msg_box1, lv_disp_get_hor_res(NULL) - 15);
         lv_obj_set_event_cb(msg_box1, job_action_handler);
         lv_obj_align(msg_box1, lv_layer_top(), LV_ALIGN_IN_TOP_MID, 0, 50);
+        update_file_info_thumbnail_ui();    // in case it was fetched before
     }
 }
 
+/**
+ * Show reprap_dir_listing. Called for every page of the listing. Rows only exist for the visible entries, so a page
+ * of the listing that is already shown just extends the list. Once the listing is complete all entries are sorted
+ * and the visible rows are bound again keeping the scroll position
+ */
 void update_job_list_ui() {
     if (visible_screen != REPPANEL_JOBSELECT_SCREEN) return;
-    lv_obj_del(preloader);
-    if (jobs_list) {
-        lv_list_clean(jobs_list);
-    } else {
+    if (preloader) {
+        lv_obj_del(preloader);
+        preloader = NULL;
+    }
+    if (!jobs_list.list) return;
+    bool same_listing = shown_generation == reprap_dir_listing.generation;
+    if (same_listing && reprap_dir_listing.next > 0) {
+        int shown_count = jobs_list.count - (has_back_btn ? 1 : 0);
+        reppanel_filelist_sort(shown_count);    // by modification date
+        reppanel_vlist_set_count(&jobs_list, jobs_list.count + reprap_dir_listing.count - shown_count);
         return;
     }
+    shown_generation = reprap_dir_listing.generation;
 
     // Add back button in case we are not in root directory
-    if (strcmp(reprap_dir_elem[0].dir, JOBS_ROOT_DIR) != 0) {
-        lv_obj_t *back_btn;
-        back_btn = lv_list_add_btn(jobs_list, LV_SYMBOL_LEFT, BACK_TXT);
-        lv_obj_set_event_cb(back_btn, job_clicked_event_handler);
+    has_back_btn = strcmp(reprap_dir_listing.dir, JOBS_ROOT_DIR) != 0;
+    if (has_back_btn) {
         // update parent dir
-        strcpy(parent_dir_jobs, reprap_dir_elem[0].dir);
+        strcpy(parent_dir_jobs, reprap_dir_listing.dir);
         char *pch;
         pch = strrchr(parent_dir_jobs, '/');
-        parent_dir_jobs[pch - parent_dir_jobs] = '\0';
+        if (pch != NULL) parent_dir_jobs[pch - parent_dir_jobs] = '\0';
     } else {
         strcpy(parent_dir_jobs, JOBS_EMPTY);
     }
-    // count number of elements
-    uint8_t cnt = 0;
-    for (int i = 0; reprap_dir_elem[i].type != TREE_EMPTY_ELEM && i < MAX_NUM_ELEM_DIR; i++) {
-        cnt++;
-    }
-    // sort by modification date
-    qsort(reprap_dir_elem, cnt, sizeof(file_tree_elem_t), compare_tree_element_timestamp);
-    for (int i = 0; reprap_dir_elem[i].type != TREE_EMPTY_ELEM && i < MAX_NUM_ELEM_DIR; i++) {
-        lv_obj_t *list_btn;
-        if (reprap_dir_elem[i].type == TREE_FOLDER_ELEM)
-            list_btn = lv_list_add_btn(jobs_list, LV_SYMBOL_DIRECTORY, reprap_dir_elem[i].name);
-        else
-            list_btn = lv_list_add_btn(jobs_list, LV_SYMBOL_FILE, reprap_dir_elem[i].name);
-        lv_obj_set_event_cb(list_btn, job_clicked_event_handler);
-    }
+    reppanel_filelist_sort(0);  // by modification date
+    if (!same_listing) reppanel_vlist_scroll_top(&jobs_list);
+    reppanel_vlist_set_count(&jobs_list, reprap_dir_listing.count + (has_back_btn ? 1 : 0));
+    reppanel_vlist_refresh(&jobs_list);
 }
 
 
@@ -224,8 +268,10 @@ void draw_jobselect(lv_obj_t *parent_screen) {
     preloader = lv_preload_create(jobs_container, NULL);
     lv_obj_set_size(preloader, 75, 75);
 
-    jobs_list = lv_list_create(jobs_container, NULL);
-    lv_obj_set_size(jobs_list, LV_HOR_RES - 10, lv_disp_get_ver_res(NULL) - (lv_obj_get_height(cont_header) + 5));
+    reppanel_vlist_create(&jobs_list, jobs_container, LV_HOR_RES - 10,
+                          lv_disp_get_ver_res(NULL) - (lv_obj_get_height(cont_header) + 5),
+                          job_row_text, job_clicked_event_handler);
+    shown_generation = reprap_dir_listing.generation - 1;   // rows are empty
 
     request_jobs(JOBS_ROOT_DIR);
 }
\ No newline at end of file
@@ -14,4 +14,6 @@ void update_job_list_ui();
 
 void update_file_info_dialog_ui(reprap_model_t *_reprap_model);
 
+void update_file_info_thumbnail_ui();
+
 #endif //LVGL_REPPANEL_JOBSELECT_H
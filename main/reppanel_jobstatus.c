@@ -11,12 +11,11 @@
 #include "reppanel.h"
 #include "reppanel_request.h"
 #include "rrf_objects.h"
+#include "reppanel_thumbnail.h"
 
 #define TAG "JobStatus"
 
 float reprap_job_percent;
-double reprap_job_first_layer_height = 0;
-double reprap_job_layer_height = 0;
 
 lv_obj_t *cont_percent;
 lv_obj_t *label_job_progress_percent;
@@ -24,6 +23,9 @@ lv_obj_t *label_job_elapsed_time;
 lv_obj_t *label_job_remaining_time;
 lv_obj_t *label_job_layer_status;
 lv_obj_t *label_job_filename;
+static lv_obj_t *jobstatus_page;
+static lv_obj_t *cont_main;
+static lv_obj_t *img_job_thumbnail;
 
 static lv_style_t style_button_job_pause;
 lv_obj_t *button_job_pause;
@@ -41,11 +43,10 @@ void update_print_job_status_ui() {
         }
     }
 
-    if (reprap_job_first_layer_height > 0 && reprap_job_layer_height > 0 && reprap_model.reprap_job.file.height > 0 &&
-        label_job_layer_status) {
-        if (reprap_model.reprap_job.file.numLayers == 0) {
-            int total_layer_cnt = (int) (((reprap_model.reprap_job.file.height - reprap_job_first_layer_height) / reprap_job_layer_height) +
-                                         1);
+    reprap_job_t *job = &reprap_model.reprap_job;
+    if (job->file.firstLayerHeight > 0 && job->file.layerHeight > 0 && job->file.height > 0 && label_job_layer_status) {
+        if (job->file.numLayers == 0) {
+            int total_layer_cnt = (int) (((job->file.height - job->file.firstLayerHeight) / job->file.layerHeight) + 1);
             lv_label_set_text_fmt(label_job_layer_status, "%i/%i", reprap_model.reprap_job.layer, total_layer_cnt);
         } else {
             lv_label_set_text_fmt(label_job_layer_status, "%i/%i", reprap_model.reprap_job.layer, reprap_model.reprap_job.file.numLayers);
@@ -96,6 +97,10 @@ void update_print_job_status_ui() {
         // only update when changed. Otherwise label will not scroll
         if (last != NULL && strcmp(lv_label_get_text(label_job_filename), last+1) != 0) {
             lv_label_set_text(label_job_filename, last + 1);
+#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+            if (reprap_model.api_level >= 1) trigger_request_fileinfo_curr_job();   // for the thumbnail of the new job
+            update_job_thumbnail_ui();
+#endif
         }
     }
 
@@ -112,6 +117,24 @@ void update_print_job_status_ui() {
     }
 }
 
+/**
+ * Show the thumbnail of the current job next to the progress once it was fetched
+ */
+void update_job_thumbnail_ui() {
+    if (visible_screen != REPPANEL_JOBSTATUS_SCREEN || !img_job_thumbnail) return;
+    const void *src = reppanel_thumbnail_src(reprap_model.reprap_job.file.fileName);
+    if (src == NULL) {
+        lv_obj_set_hidden(img_job_thumbnail, true);
+        lv_obj_align_origo(cont_main, jobstatus_page, LV_ALIGN_CENTER, -40, -50);
+        return;
+    }
+    lv_img_set_src(img_job_thumbnail, src);
+    lv_obj_set_hidden(img_job_thumbnail, false);
+    lv_obj_align(img_job_thumbnail, jobstatus_page, LV_ALIGN_IN_TOP_RIGHT, -10, 10);
+    // make room for the thumbnail
+    lv_obj_align_origo(cont_main, jobstatus_page, LV_ALIGN_CENTER, -40 - lv_obj_get_width(img_job_thumbnail) / 2, -50);
+}
+
 void resume_job_event(lv_obj_t *obj, lv_event_t event) {
     if (event == LV_EVENT_CLICKED) {
         ESP_LOGI(TAG, "Resuming print job");
@@ -135,7 +158,7 @@ void pause_job_event(lv_obj_t *obj, lv_event_t event) {
 
 
 void draw_jobstatus(lv_obj_t *parent_screen) {
-    lv_obj_t *jobstatus_page = lv_page_create(parent_screen, NULL);
+    jobstatus_page = lv_page_create(parent_screen, NULL);
     lv_obj_set_size(jobstatus_page, lv_disp_get_hor_res(NULL),
                     lv_disp_get_ver_res(NULL) - (lv_obj_get_height(cont_header) + 5));
     lv_page_set_scrl_fit(jobstatus_page, LV_FIT_FLOOD);
@@ -146,7 +169,7 @@ void draw_jobstatus(lv_obj_t *parent_screen) {
     style_jobstatus_page.body.padding.inner = 0;
     lv_page_set_style(jobstatus_page, LV_PAGE_STYLE_SCRL, &style_jobstatus_page);
 
-    lv_obj_t *cont_main = lv_cont_create(jobstatus_page, NULL);
+    cont_main = lv_cont_create(jobstatus_page, NULL);
     lv_cont_set_fit(cont_main, LV_FIT_TIGHT);
     lv_cont_set_layout(cont_main, LV_LAYOUT_ROW_M);
     static lv_style_t style_cont_main;
@@ -293,8 +316,15 @@ void draw_jobstatus(lv_obj_t *parent_screen) {
     lv_obj_align(button_job_resume, jobstatus_page, LV_ALIGN_IN_BOTTOM_RIGHT, -32, -30);
     lv_obj_align(button_job_stop, jobstatus_page, LV_ALIGN_IN_BOTTOM_RIGHT, -84, -30);
 
+    img_job_thumbnail = lv_img_create(jobstatus_page, NULL);
+    lv_obj_set_hidden(img_job_thumbnail, true);
+
 #ifdef CONFIG_REPPANEL_RRF2_SUPPORT
     if (reprap_model.api_level < 1) trigger_request_fileinfo_curr_job();
+#endif
+#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+    if (reprap_model.api_level >= 1) trigger_request_fileinfo_curr_job();   // object model has no thumbnail data
 #endif
     update_print_job_status_ui();
+    update_job_thumbnail_ui();
 }
\ No newline at end of file
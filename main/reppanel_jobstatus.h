@@ -17,4 +17,6 @@ void draw_jobstatus(lv_obj_t *parent_screen);
 
 void update_print_job_status_ui();
 
+void update_job_thumbnail_ui();
+
 #endif //REPPANEL_ESP32_REPPANEL_JOBSTATUS_H
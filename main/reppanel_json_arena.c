@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// cJSON allocates every node and string on its own. Parsing a response this way fragments the heap over time.
+// Instead every parsed response gets a bump arena sized from the length of the JSON. cJSON_Delete() does not
+// touch the arena and the whole arena is reset at once afterwards. Allocations that do not fit go to the heap.
+// A task can only own one arena. Trees must be parsed and deleted by the same task.
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "reppanel_json_arena.h"
+
+#define TAG "JsonArena"
+
+typedef struct {
+    uint8_t *mem;
+    size_t size;
+    size_t used;
+    size_t needed;          // used + everything that did not fit into the arena
+    size_t json_len;        // length of the response the arena was sized for
+    int depth;              // number of trees of the owner that use the arena
+    TaskHandle_t owner;     // NULL if the arena is free. Only ever set by the owning task itself
+} json_arena_t;
+
+static json_arena_t json_arenas[JSON_ARENA_COUNT];
+static SemaphoreHandle_t json_arena_mutex = NULL;
+static size_t json_arena_ratio = JSON_ARENA_INIT_RATIO;
+
+static json_arena_t *json_arena_of_caller() {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < JSON_ARENA_COUNT; i++) {
+        if (json_arenas[i].owner == task) return &json_arenas[i];
+    }
+    return NULL;
+}
+
+static void *json_arena_malloc(size_t size) {
+    json_arena_t *arena = json_arena_of_caller();
+    if (arena != NULL) {
+        size_t aligned = (size + JSON_ARENA_ALIGN - 1) & ~((size_t) JSON_ARENA_ALIGN - 1);
+        arena->needed += aligned;
+        if (arena->used + aligned <= arena->size) {
+            void *ptr = arena->mem + arena->used;
+            arena->used += aligned;
+            return ptr;
+        }
+    }
+    return malloc(size);
+}
+
+static void json_arena_free(void *ptr) {
+    json_arena_t *arena = json_arena_of_caller();
+    if (arena != NULL && (uint8_t *) ptr >= arena->mem && (uint8_t *) ptr < arena->mem + arena->size)
+        return;     // released together with the arena
+    free(ptr);
+}
+
+static size_t json_arena_wanted_size(size_t json_len) {
+    size_t wanted = json_len * json_arena_ratio / 16 + JSON_ARENA_GRANULARITY;
+    wanted = (wanted + JSON_ARENA_GRANULARITY - 1) / JSON_ARENA_GRANULARITY * JSON_ARENA_GRANULARITY;
+    return wanted > JSON_ARENA_MAX_SIZE ? JSON_ARENA_MAX_SIZE : wanted;
+}
+
+/**
+ * Make the arena at least size bytes large. Prefers SPI-RAM. Arena stays empty if there is not enough memory
+ */
+static void json_arena_reserve(json_arena_t *arena, size_t size) {
+    if (arena->size >= size) return;
+    free(arena->mem);
+    arena->mem = NULL;
+    arena->size = 0;
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+    arena->mem = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+#endif
+    if (arena->mem == NULL) arena->mem = malloc(size);
+    if (arena->mem == NULL) {
+        ESP_LOGW(TAG, "Could not allocate %u bytes. Parsing on the heap", (unsigned) size);
+        return;
+    }
+    arena->size = size;
+}
+
+/**
+ * Hand an arena to the calling task. Reuses the arena the task already owns
+ */
+static void json_arena_acquire(size_t json_len) {
+    json_arena_t *arena = json_arena_of_caller();
+    if (arena != NULL) {
+        arena->depth++;
+        return;
+    }
+    size_t wanted = json_arena_wanted_size(json_len);
+    xSemaphoreTake(json_arena_mutex, portMAX_DELAY);
+    for (int i = 0; i < JSON_ARENA_COUNT; i++) {
+        if (json_arenas[i].owner != NULL) continue;
+        // prefer one that is large enough already
+        if (arena == NULL || (arena->size < wanted && json_arenas[i].size > arena->size)) arena = &json_arenas[i];
+    }
+    if (arena != NULL) arena->owner = xTaskGetCurrentTaskHandle();
+    xSemaphoreGive(json_arena_mutex);
+    if (arena == NULL) {
+        ESP_LOGD(TAG, "All arenas in use. Parsing on the heap");
+        return;
+    }
+    json_arena_reserve(arena, wanted);
+    arena->used = 0;
+    arena->needed = 0;
+    arena->json_len = json_len;
+    arena->depth = 1;
+}
+
+static void json_arena_release() {
+    json_arena_t *arena = json_arena_of_caller();
+    if (arena == NULL || --arena->depth > 0) return;
+    if (arena->needed > arena->size && arena->json_len > 0) {
+        size_t ratio = arena->needed * 16 / arena->json_len + 1;
+        if (ratio > json_arena_ratio) json_arena_ratio = ratio;
+        ESP_LOGD(TAG, "Arena of %u bytes too small for %u bytes of JSON. Needed %u", (unsigned) arena->size,
+                 (unsigned) arena->json_len, (unsigned) arena->needed);
+    }
+    if (arena->size > JSON_ARENA_KEEP_SIZE) {
+        free(arena->mem);
+        arena->mem = NULL;
+        arena->size = 0;
+    }
+    arena->used = 0;
+    xSemaphoreTake(json_arena_mutex, portMAX_DELAY);
+    arena->owner = NULL;
+    xSemaphoreGive(json_arena_mutex);
+}
+
+/**
+ * Make cJSON use the arenas. Call once before any JSON is parsed
+ */
+void reppanel_json_arena_init() {
+    memset(json_arenas, 0, sizeof(json_arenas));
+    json_arena_mutex = xSemaphoreCreateMutex();
+    configASSERT(json_arena_mutex);
+    cJSON_Hooks hooks = {.malloc_fn = json_arena_malloc, .free_fn = json_arena_free};
+    cJSON_InitHooks(&hooks);
+}
+
+/**
+ * Parse a response into an arena. Tree must be deleted with reppanel_json_delete() by the same task
+ * @param json Response. Does not need to be NULL terminated
+ * @param len Length of the response without NULL termination
+ * @return Parsed tree or NULL. Call reppanel_json_delete() in both cases
+ */
+cJSON *reppanel_json_parse(const char *json, size_t len) {
+    json_arena_acquire(len);
+    return cJSON_ParseWithLength(json, len);
+}
+
+/**
+ * Delete a tree returned by reppanel_json_parse() and reset the arena
+ * @param root Tree or NULL
+ */
+void reppanel_json_delete(cJSON *root) {
+    cJSON_Delete(root);
+    json_arena_release();
+}
@@ -0,0 +1,30 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_JSON_ARENA_H
+#define REPPANEL_ESP32_REPPANEL_JSON_ARENA_H
+
+#include <stddef.h>
+#include <cJSON.h>
+
+#define JSON_ARENA_COUNT        3       // status task, GUI task & async file list task parse at the same time
+#define JSON_ARENA_ALIGN        8       // cJSON nodes contain a double
+#define JSON_ARENA_GRANULARITY  1024    // arena sizes are rounded up to this
+#define JSON_ARENA_INIT_RATIO   48      // initial guess of arena bytes needed per 16 bytes of JSON. Learned later on
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+#define JSON_ARENA_MAX_SIZE     (1024 * 512)
+#define JSON_ARENA_KEEP_SIZE    (1024 * 64)     // larger arenas are freed once the response was processed
+#else
+#define JSON_ARENA_MAX_SIZE     (1024 * 24)
+#define JSON_ARENA_KEEP_SIZE    (1024 * 8)
+#endif
+
+void reppanel_json_arena_init();
+
+cJSON *reppanel_json_parse(const char *json, size_t len);
+
+void reppanel_json_delete(cJSON *root);
+
+#endif //REPPANEL_ESP32_REPPANEL_JSON_ARENA_H
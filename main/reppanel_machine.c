@@ -2,6 +2,7 @@
 // Copyright (c) 2020 Wolfgang Christl
 // Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
 
+#include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include <freertos/task.h>
 #include <lvgl/src/lv_objx/lv_page.h>
@@ -12,6 +13,7 @@
 #include "reppanel_machine.h"
 #include "reppanel_helper.h"
 #include "reppanel_request.h"
+#include "reppanel_input_coalesce.h"
 #include "reppanel.h"
 #include "duet_status_json.h"
 
@@ -105,26 +107,19 @@ static void fan_off_event(lv_obj_t *obj, lv_event_t event) {
 }
 
 static void slider_event_cb(lv_obj_t *slider, lv_event_t event) {
-    if (event == LV_EVENT_RELEASED) {
-        static char buf[11]; /* max 10 bytes for number plus 1 null terminating byte */
-        snprintf(buf, 11, "M106 S%.2f", (lv_slider_get_value(slider) / 100.));
-        reprap_send_gcode(buf);
+    if (event == LV_EVENT_VALUE_CHANGED) {   // also while dragged
+        reppanel_input_coalesce_set(INPUT_COALESCE_FAN, lv_slider_get_value(slider) / 100.);
     }
 }
 
 static void height_adjust_event(lv_obj_t *obj, lv_event_t event) {
     if (event == LV_EVENT_VALUE_CHANGED) {
         const char *amount = lv_btnm_get_active_btn_text(obj);
-        char *dir;
-        if (lv_btn_get_state(btn_closer) == LV_BTN_STATE_TGL_REL) {
-            dir = "-";
-        } else {
-            dir = "";
-        }
-        ESP_LOGI(TAG, "Moving %s%s", dir, amount);
-        char command[64];
-        sprintf(command, "M120\nG91\nG1 Z%s%s F6000\nG90\nM121", dir, amount);
-        reprap_send_gcode(command);
+        if (amount == NULL) return;
+        double dist = strtod(amount, NULL);
+        if (lv_btn_get_state(btn_closer) == LV_BTN_STATE_TGL_REL) dist = -dist;
+        ESP_LOGI(TAG, "Moving %.2f", dist);
+        reppanel_input_coalesce_add(INPUT_COALESCE_Z_JOG, dist);
     }
 }
 
@@ -328,11 +323,11 @@ static void mesh_bed_leveling_event(lv_obj_t *obj, lv_event_t event) {
     }
 }
 
-void update_ui_machine() {
-    portMUX_TYPE mutex = portMUX_INITIALIZER_UNLOCKED;
-    portENTER_CRITICAL(&mutex); // not sure this really helps?!
+/**
+ * Update position & homed state of the axes
+ */
+void update_machine_axes_ui() {
     if (label_z_pos_cali) lv_label_set_text_fmt(label_z_pos_cali, "%.02f mm", reprap_axes.axes[2]);
-    portEXIT_CRITICAL(&mutex);
     if (visible_screen != REPPANEL_MACHINE_SCREEN) return;
 
     if (btn_home_x && machine_page) {
@@ -356,6 +351,13 @@ void update_ui_machine() {
         else
             lv_btn_set_style(btn_home_all, LV_BTN_STYLE_REL, &not_homed_style);
     }
+}
+
+/**
+ * Update ATX power & fan
+ */
+void update_machine_params_ui() {
+    if (visible_screen != REPPANEL_MACHINE_SCREEN) return;
     if (btn_power && machine_page) {
         if (reprap_params.power) {
             lv_btn_set_style(btn_power, LV_BTN_STYLE_REL, &homed_style);
@@ -367,10 +369,16 @@ void update_ui_machine() {
     }
     if (label_fan && machine_page) {
         lv_label_set_text_fmt(label_fan, " %u%% ", reprap_params.fan);
-        lv_slider_set_value(slider, reprap_params.fan, LV_ANIM_ON);
+        if (!lv_slider_is_dragged(slider))     // status may still lag behind the slider
+            lv_slider_set_value(slider, reprap_params.fan, LV_ANIM_ON);
     }
 }
 
+void update_ui_machine() {
+    update_machine_axes_ui();
+    update_machine_params_ui();
+}
+
 void draw_machine(lv_obj_t *parent_screen) {
     machine_page = lv_page_create(parent_screen, NULL);
     lv_obj_set_size(machine_page, lv_disp_get_hor_res(NULL),
@@ -8,6 +8,8 @@
 #define LVGL_REPPANEL_MACHINE_H
 
 void update_ui_machine();
+void update_machine_axes_ui();
+void update_machine_params_ui();
 void show_reprap_dialog(char *title, char *msg, uint8_t mode, bool show_height_adjust);
 void draw_machine(lv_obj_t *parent_screen);
 
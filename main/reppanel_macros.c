@@ -7,6 +7,8 @@
 #include <esp_log.h>
 #include "reppanel.h"
 #include "reppanel_request.h"
+#include "reppanel_filelist.h"
+#include "reppanel_vlist.h"
 
 #define TAG "Macros"
 
@@ -14,18 +16,20 @@
 #define MACRO_EMPTY ""
 #define BACK_TXT    "Back"
 
-lv_obj_t *macro_list;
+static reppanel_vlist_t macro_list;
 lv_obj_t *msg_box3;
 lv_obj_t *preloader;
-file_tree_elem_t *edit_macro;
+file_tree_elem_t edit_macro;    // copy of the selected entry. Listing may change while a dialog is open
+static uint32_t shown_generation;   // listing generation the rows of macro_list show
+static bool has_back_btn;           // first row of macro_list is the back button
 char parent_dir_macros[MAX_LEN_DIRNAME + 1];
 
 static void exe_macro_file_handler(lv_obj_t *obj, lv_event_t event) {
     if (event == LV_EVENT_VALUE_CHANGED) {
         if (strcmp(lv_mbox_get_active_btn_text(msg_box3), "Yes") == 0) {
-            ESP_LOGI(TAG, "Running file %s", lv_list_get_btn_text(obj));
-            char tmp_txt[strlen(edit_macro->dir) + strlen(edit_macro->name) + 10];
-            sprintf(tmp_txt, "M98 P\"%s/%s\"", edit_macro->dir, edit_macro->name);
+            ESP_LOGI(TAG, "Running file %s", edit_macro.name);
+            char tmp_txt[strlen(edit_macro.dir) + strlen(edit_macro.name) + 10];
+            sprintf(tmp_txt, "M98 P\"%s/%s\"", edit_macro.dir, edit_macro.name);
             reprap_send_gcode(tmp_txt);
             lv_obj_del_async(msg_box3);
         } else {
@@ -34,11 +38,23 @@ static void exe_macro_file_handler(lv_obj_t *obj, lv_event_t event) {
     }
 }
 
-static void macro_clicked_event_handler(lv_obj_t *obj, lv_event_t event) {
+static void macro_row_text(int index, const char **symbol, const char **text) {
+    if (has_back_btn) {
+        if (index == 0) {
+            *symbol = LV_SYMBOL_LEFT;
+            *text = BACK_TXT;
+            return;
+        }
+        index--;
+    }
+    *symbol = reppanel_filelist_type(index) == TREE_FOLDER_ELEM ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE;
+    *text = reppanel_filelist_name(index);
+}
+
+static void macro_clicked_event_handler(int selected_indx, lv_event_t event) {
     if (event == LV_EVENT_CLICKED) {
-        int selected_indx = lv_list_get_btn_index(macro_list, obj);
         // check if back button exists
-        if (strcmp(reprap_dir_elem[0].dir, MACRO_ROOT_DIR) != 0) {
+        if (has_back_btn) {
             if (selected_indx == 0) {
                 // back button was pressed
                 ESP_LOGI(TAG, "Going back to parent %s", parent_dir_macros);
@@ -50,74 +66,64 @@ static void macro_clicked_event_handler(lv_obj_t *obj, lv_event_t event) {
                 return;
             } else {
                 // no back button pressed
-                // decrease index to match with reprap_macros array indexing
+                // decrease index to match with reprap_dir_listing indexing
                 selected_indx--;
             }
         }
-        edit_macro = &reprap_dir_elem[selected_indx];
-        if (edit_macro == NULL)
-            return;
-        if (reprap_dir_elem[selected_indx].type == TREE_FILE_ELEM) {
+        // rows are outdated in case a new listing arrived but the list was not updated yet
+        if (shown_generation != reprap_dir_listing.generation || selected_indx >= reprap_dir_listing.count) return;
+        reppanel_filelist_get(selected_indx, &edit_macro);
+        if (edit_macro.type == TREE_FILE_ELEM) {
             static const char *btns[] = {"Yes", "No", ""};
             msg_box3 = lv_mbox_create(lv_layer_top(), NULL);
             char msg[100];
-            sprintf(msg, "Do you want to execute %s?", edit_macro->name);
+            sprintf(msg, "Do you want to execute %s?", edit_macro.name);
             lv_mbox_set_text(msg_box3, msg);
             lv_mbox_add_btns(msg_box3, btns);
             lv_obj_set_event_cb(msg_box3, exe_macro_file_handler);
             lv_obj_set_width(msg_box3, lv_disp_get_hor_res(NULL) - 20);
             lv_obj_align(msg_box3, lv_layer_top(), LV_ALIGN_CENTER, 0, 0);
-        } else if (reprap_dir_elem[selected_indx].type == TREE_FOLDER_ELEM) {
-            ESP_LOGI(TAG, "Clicked folder %s (index %i)", edit_macro->name, selected_indx);
+        } else if (edit_macro.type == TREE_FOLDER_ELEM) {
+            ESP_LOGI(TAG, "Clicked folder %s (index %i)", edit_macro.name, selected_indx);
             if (!preloader)
                 preloader = lv_preload_create(lv_layer_top(), NULL);
             lv_obj_set_size(preloader, 75, 75);
             lv_obj_align_origo(preloader, lv_layer_top(), LV_ALIGN_CENTER, 0, 0);
             static char tmp_txt[MAX_LEN_DIRNAME + MAX_LEN_FILENAME + 1];
-            sprintf(tmp_txt, "%s/%s", reprap_dir_elem[selected_indx].dir, edit_macro->name);
+            sprintf(tmp_txt, "%s/%s", edit_macro.dir, edit_macro.name);
             request_macros(tmp_txt);
         }
     }
 }
 
+/**
+ * Show reprap_dir_listing. Called for every page of the listing. Only binds the visible rows again
+ */
 void update_macro_list_ui() {
     if (visible_screen != REPPANEL_MACROS_SCREEN) return;
-    lv_obj_del(preloader);
-    if (macro_list) {
-        lv_list_clean(macro_list);
-        ESP_LOGI(TAG, "Cleaned Macro List");
-    } else {
-        return;
+    if (preloader) {
+        lv_obj_del(preloader);
+        preloader = NULL;
     }
+    if (!macro_list.list) return;
+    bool same_listing = shown_generation == reprap_dir_listing.generation;
+    shown_generation = reprap_dir_listing.generation;
 
     // Add back button in case we are not in root directory
-    if (strcmp(reprap_dir_elem[0].dir, MACRO_ROOT_DIR) != 0) {
-        lv_obj_t *back_btn;
-        back_btn = lv_list_add_btn(macro_list, LV_SYMBOL_LEFT, BACK_TXT);
-        lv_obj_set_event_cb(back_btn, macro_clicked_event_handler);
+    has_back_btn = strcmp(reprap_dir_listing.dir, MACRO_ROOT_DIR) != 0;
+    if (has_back_btn) {
         // update parent dir
-        strcpy(parent_dir_macros, reprap_dir_elem[0].dir);
+        strcpy(parent_dir_macros, reprap_dir_listing.dir);
         char *pch;
         pch = strrchr(parent_dir_macros, '/');
-        parent_dir_macros[pch - parent_dir_macros] = '\0';
+        if (pch != NULL) parent_dir_macros[pch - parent_dir_macros] = '\0';
     } else {
         strcpy(parent_dir_macros, MACRO_EMPTY);
     }
-    // count number of elements
-    uint8_t cnt = 0;
-    for (int i = 0; reprap_dir_elem[i].type != TREE_EMPTY_ELEM && i < MAX_NUM_ELEM_DIR; i++) {
-        cnt++;
-    }
-    // sort by modification date
-    qsort(reprap_dir_elem, cnt, sizeof(file_tree_elem_t), compare_tree_element_timestamp);
-    for (int i = 0; reprap_dir_elem[i].type != TREE_EMPTY_ELEM && i < MAX_NUM_ELEM_DIR; i++) {
-        lv_obj_t *list_btn;
-        if (reprap_dir_elem[i].type == TREE_FOLDER_ELEM)
-            list_btn = lv_list_add_btn(macro_list, LV_SYMBOL_DIRECTORY, reprap_dir_elem[i].name);
-        else
-            list_btn = lv_list_add_btn(macro_list, LV_SYMBOL_FILE, reprap_dir_elem[i].name);
-        lv_obj_set_event_cb(list_btn, macro_clicked_event_handler);
-    }
+    reppanel_filelist_sort(0);  // by modification date
+    if (!same_listing) reppanel_vlist_scroll_top(&macro_list);
+    reppanel_vlist_set_count(&macro_list, reprap_dir_listing.count + (has_back_btn ? 1 : 0));
+    reppanel_vlist_refresh(&macro_list);
 }
 
 void draw_macro(lv_obj_t *parent_screen) {
@@ -129,8 +135,10 @@ void draw_macro(lv_obj_t *parent_screen) {
     preloader = lv_preload_create(macro_container, NULL);
     lv_obj_set_size(preloader, 75, 75);
 
-    macro_list = lv_list_create(macro_container, NULL);
-    lv_obj_set_size(macro_list, LV_HOR_RES - 10, lv_disp_get_ver_res(NULL) - (lv_obj_get_height(cont_header) + 5));
+    reppanel_vlist_create(&macro_list, macro_container, LV_HOR_RES - 10,
+                          lv_disp_get_ver_res(NULL) - (lv_obj_get_height(cont_header) + 5),
+                          macro_row_text, macro_clicked_event_handler);
+    shown_generation = reprap_dir_listing.generation - 1;   // rows are empty
 
     request_macros(MACRO_ROOT_DIR);
 }
\ No newline at end of file
@@ -8,10 +8,13 @@
 #include "reppanel_process.h"
 #include "reppanel.h"
 #include "reppanel_request.h"
+#include "reppanel_temp_history.h"
 #include "rrf_objects.h"
 
 #define TAG     "Process"
 
+#define TEMP_CHART_POINTS   80
+
 lv_obj_t *label_bed_temp;
 lv_obj_t *label_tool_temp;
 lv_obj_t *label_extruder_name;
@@ -36,9 +39,17 @@ lv_obj_t *popup_page;
 lv_obj_t *ddlist_selected_filament;
 static lv_obj_t *cont_filament;
 
+static lv_obj_t *temp_chart_page;
+static lv_obj_t *temp_chart;
+static lv_chart_series_t *temp_chart_ser;
+static lv_obj_t *label_temp_chart_title;
+static lv_obj_t *label_temp_chart_stats;
+static int temp_chart_heater = TEMP_HISTORY_BED;
+
 //int num_tools = 1;
 reprap_tool_t reprap_tools[MAX_NUM_TOOLS];
 reprap_bed_t reprap_bed;
+reprap_chamber_t reprap_chamber;
 reprap_tool_poss_temps_t reprap_tool_poss_temps;
 reprap_bed_poss_temps_t reprap_bed_poss_temps;
 double reprap_extruder_amounts[NUM_TEMPS_BUFF];
@@ -95,14 +106,12 @@ void update_heater_status_ui(const int *states, int _num_heaters) {
             apply_heater_style(states[i], btn_tool_temp_active, btn_tool_temp_standby);
         }
     }
-    memcpy(heater_states, states, MAX_NUM_TOOLS);
 }
 
 void update_bed_temps_ui() {
     if (visible_screen != REPPANEL_PROCESS_SCREEN) return;
     if (label_bed_temp != NULL)
-        lv_label_set_text_fmt(label_bed_temp, "%.1f°%c", reprap_bed.temp_buff[reprap_bed.temp_hist_curr_pos],
-                              get_temp_unit());
+        lv_label_set_text_fmt(label_bed_temp, "%.1f°%c", reprap_bed.current_temp, get_temp_unit());
     if (label_bed_temp_active != NULL)
         lv_label_set_text_fmt(label_bed_temp_active, "%.0f°%c", reprap_bed.active_temp, get_temp_unit());
     if (label_bed_temp_standby != NULL)
@@ -115,8 +124,7 @@ void update_process_status_ui() {
         lv_label_set_text(label_extruder_name, reprap_tools[current_visible_tool_indx].name);
     }
     if (label_tool_temp != NULL) {
-        lv_label_set_text_fmt(label_tool_temp, "%.1f°%c",
-                              reprap_tools[current_visible_tool_indx].temp_buff[reprap_tools[current_visible_tool_indx].temp_hist_curr_pos],
+        lv_label_set_text_fmt(label_tool_temp, "%.1f°%c", reprap_tools[current_visible_tool_indx].current_temp,
                               get_temp_unit());
         lv_label_set_text_fmt(label_tool_temp_active, "%.0f°%c", reprap_tools[current_visible_tool_indx].active_temp,
                               get_temp_unit());
@@ -127,10 +135,8 @@ void update_process_status_ui() {
 
 void update_header_temp_ui() {
     if (label_chamber_temp) {
-        lv_label_set_text_fmt(label_chamber_temp, "%.01f/%.01f°%c",
-                              reprap_bed.temp_buff[reprap_bed.temp_hist_curr_pos],
-                              reprap_tools[current_visible_tool_indx].temp_buff[reprap_tools[current_visible_tool_indx].temp_hist_curr_pos],
-                              get_temp_unit());
+        lv_label_set_text_fmt(label_chamber_temp, "%.01f/%.01f°%c", reprap_bed.current_temp,
+                              reprap_tools[current_visible_tool_indx].current_temp, get_temp_unit());
     }
 }
 
@@ -145,10 +151,21 @@ void update_next_tool_button_visibility() {
         lv_obj_set_hidden(prev_extruder_label, false);
 }
 
+/**
+ * Show name, temperatures & heater state of the visible tool. The printer state may not change, so status updates
+ * will not do it
+ */
+static void update_visible_tool_ui() {
+    update_process_status_ui();
+    update_heater_status_ui(heater_states, reprap_model.num_heaters);
+    update_header_temp_ui();
+}
+
 static void choose_prev_tool_event_handler(lv_obj_t *obj, lv_event_t event) {
     if (event == LV_EVENT_CLICKED) {
         if (current_visible_tool_indx > 0) current_visible_tool_indx--;
         update_next_tool_button_visibility();
+        update_visible_tool_ui();
     }
 }
 
@@ -156,6 +173,7 @@ static void choose_next_tool_event_handler(lv_obj_t *obj, lv_event_t event) {
     if (event == LV_EVENT_CLICKED) {
         if (current_visible_tool_indx < (reprap_model.num_tools - 1)) current_visible_tool_indx++;
         update_next_tool_button_visibility();
+        update_visible_tool_ui();
     }
 }
 
@@ -323,6 +341,98 @@ static void close_popup_page(lv_obj_t *obj, lv_event_t event) {
     }
 }
 
+/**
+ * Show the history of the heater selected in the temperature chart. Called whenever samples were added
+ */
+void update_temp_chart_ui() {
+    if (temp_chart == NULL) return;
+    if (temp_chart_heater == TEMP_HISTORY_BED) {
+        lv_label_set_text(label_temp_chart_title, "Bed");
+    } else if (temp_chart_heater == TEMP_HISTORY_CHAMBER) {
+        lv_label_set_text(label_temp_chart_title, "Chamber");
+    } else {
+        lv_label_set_text(label_temp_chart_title, reprap_tools[temp_chart_heater - TEMP_HISTORY_TOOL(0)].name);
+    }
+    static int16_t samples[TEMP_CHART_POINTS];
+    static lv_coord_t points[TEMP_CHART_POINTS];
+    int num_points = reppanel_temp_history_view(temp_chart_heater, samples, TEMP_CHART_POINTS);
+    for (int i = 0; i < TEMP_CHART_POINTS; i++) points[i] = i < num_points ? samples[i] : LV_CHART_POINT_DEF;
+    temp_history_stats_t stats;
+    if (!reppanel_temp_history_stats(temp_chart_heater, &stats)) {
+        lv_label_set_text(label_temp_chart_stats, "No temperatures recorded yet");
+        lv_chart_set_points(temp_chart, temp_chart_ser, points);
+        return;
+    }
+    // [0.1°] with a margin of 2° so a constant temperature is not drawn on the border
+    lv_chart_set_range(temp_chart, (lv_coord_t) (stats.min * 10) - 20, (lv_coord_t) (stats.max * 10) + 20);
+    lv_chart_set_points(temp_chart, temp_chart_ser, points);
+    lv_label_set_text_fmt(label_temp_chart_stats, "Min %.1f°%c  Avg %.1f°%c  Max %.1f°%c  (last %u min)", stats.min,
+                          get_temp_unit(), stats.avg, get_temp_unit(), stats.max, get_temp_unit(),
+                          (unsigned) (stats.duration + 59) / 60);
+}
+
+static void select_temp_chart_heater(lv_obj_t *obj, lv_event_t event) {
+    if (event == LV_EVENT_CLICKED) {
+        temp_chart_heater = (int) (lv_obj_user_data_t) obj->user_data;
+        update_temp_chart_ui();
+    }
+}
+
+static void close_temp_chart(lv_obj_t *obj, lv_event_t event) {
+    if (event == LV_EVENT_CLICKED) {
+        lv_obj_del_async(temp_chart_page);
+    }
+}
+
+static void temp_chart_page_event(lv_obj_t *obj, lv_event_t event) {
+    if (event == LV_EVENT_DELETE) {
+        temp_chart_page = NULL;
+        temp_chart = NULL;
+    }
+}
+
+/**
+ * Shows the temperature history of the bed or the visible tool. Other heaters can be selected
+ */
+static void show_temp_chart_event_handler(lv_obj_t *obj, lv_event_t event) {
+    if (event != LV_EVENT_CLICKED || temp_chart_page != NULL) return;
+    temp_chart_heater = obj == label_bed_temp ? TEMP_HISTORY_BED : TEMP_HISTORY_TOOL(current_visible_tool_indx);
+    temp_chart_page = lv_page_create(lv_layer_top(), NULL);
+    static lv_style_t style_bg;
+    lv_style_copy(&style_bg, lv_page_get_style(temp_chart_page, LV_PAGE_STYLE_BG));
+    style_bg.body.border.width = 1;
+    style_bg.body.border.color = REP_PANEL_DARK_ACCENT;
+    lv_page_set_style(temp_chart_page, LV_PAGE_STYLE_BG, &style_bg);
+    lv_page_set_scrl_layout(temp_chart_page, LV_LAYOUT_COL_L);
+    lv_obj_set_size(temp_chart_page, LV_HOR_RES - 20, LV_VER_RES - 20);
+    lv_obj_align(temp_chart_page, NULL, LV_ALIGN_CENTER, 0, 0);
+    lv_obj_set_event_cb(temp_chart_page, temp_chart_page_event);
+    label_temp_chart_title = lv_label_create(temp_chart_page, NULL);
+
+    temp_chart = lv_chart_create(temp_chart_page, NULL);
+    lv_obj_set_size(temp_chart, LV_HOR_RES - 70, LV_VER_RES / 2);
+    lv_chart_set_type(temp_chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_series_width(temp_chart, 2);
+    lv_chart_set_div_line_count(temp_chart, 3, 0);
+    lv_chart_set_point_count(temp_chart, TEMP_CHART_POINTS);
+    temp_chart_ser = lv_chart_add_series(temp_chart, REP_PANEL_DARK_ACCENT);
+    label_temp_chart_stats = lv_label_create(temp_chart_page, NULL);
+
+    lv_obj_t *cont_buttons = lv_cont_create(temp_chart_page, NULL);
+    lv_cont_set_layout(cont_buttons, LV_LAYOUT_ROW_M);
+    lv_cont_set_fit(cont_buttons, LV_FIT_TIGHT);
+    lv_obj_t *btn = create_button(cont_buttons, NULL, "Bed", select_temp_chart_heater);
+    lv_obj_set_user_data(btn, (lv_obj_user_data_t) TEMP_HISTORY_BED);
+    btn = create_button(cont_buttons, NULL, reprap_tools[current_visible_tool_indx].name, select_temp_chart_heater);
+    lv_obj_set_user_data(btn, (lv_obj_user_data_t) TEMP_HISTORY_TOOL(current_visible_tool_indx));
+    if (reprap_chamber.heater_indx >= 0) {
+        btn = create_button(cont_buttons, NULL, "Chamber", select_temp_chart_heater);
+        lv_obj_set_user_data(btn, (lv_obj_user_data_t) TEMP_HISTORY_CHAMBER);
+    }
+    create_button(cont_buttons, NULL, "Close", close_temp_chart);
+    update_temp_chart_ui();
+}
+
 /**
  * Shows UI so user can choose desired temp from config
  * @param obj
@@ -498,8 +608,9 @@ void draw_process(lv_obj_t *parent_screen) {
     lv_obj_t *label_bed = lv_label_create(holder_bed, NULL);
     lv_label_set_text(label_bed, "Bed");
     label_bed_temp = lv_label_create(holder2, NULL);
-    lv_label_set_text_fmt(label_bed_temp, "%.1f°%c", reprap_bed.temp_buff[reprap_bed.temp_hist_curr_pos],
-                          get_temp_unit());
+    lv_label_set_text_fmt(label_bed_temp, "%.1f°%c", reprap_bed.current_temp, get_temp_unit());
+    lv_obj_set_click(label_bed_temp, true);
+    lv_obj_set_event_cb(label_bed_temp, show_temp_chart_event_handler);
 
     const lv_style_t *panel_style = lv_cont_get_style(holder_empty, LV_CONT_STYLE_MAIN);
 
@@ -543,9 +654,10 @@ void draw_process(lv_obj_t *parent_screen) {
     lv_obj_set_event_cb(next_extruder_label, choose_next_tool_event_handler);
 
     label_tool_temp = lv_label_create(holder3, NULL);
-    lv_label_set_text_fmt(label_tool_temp, "%.1f°%c",
-                          reprap_tools[current_visible_tool_indx].temp_buff[reprap_tools[current_visible_tool_indx].temp_hist_curr_pos],
+    lv_label_set_text_fmt(label_tool_temp, "%.1f°%c", reprap_tools[current_visible_tool_indx].current_temp,
                           get_temp_unit());
+    lv_obj_set_click(label_tool_temp, true);
+    lv_obj_set_event_cb(label_tool_temp, show_temp_chart_event_handler);
 
     btn_tool_temp_active = lv_btn_create(holder3, btn_bed_temp_active);
     lv_obj_set_user_data(btn_tool_temp_active, (lv_obj_user_data_t) BTN_TOOL_TMP_ACTIVE);
@@ -586,4 +698,5 @@ void draw_process(lv_obj_t *parent_screen) {
     lv_obj_set_style(next_extruder_label, &style_label_icon);
 
     update_next_tool_button_visibility();
+    update_visible_tool_ui();
 }
\ No newline at end of file
@@ -17,6 +17,8 @@ void update_process_status_ui();
 
 void update_header_temp_ui();
 
+void update_temp_chart_ui();
+
 
 extern lv_obj_t *label_bed_temp_active;
 extern lv_obj_t *label_bed_temp_standby;
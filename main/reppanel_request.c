@@ -23,14 +23,26 @@
 #include "reppanel_machine.h"
 #include "esp32_uart.h"
 #include "esp32_wifi.h"
+#include "esp32_http_pool.h"
+#include "reppanel_scheduler.h"
 #include "rrf3_object_model_parser.h"
+#include "rrf3_stream_parser.h"
 #include "rrf_objects.h"
+#include "reppanel_snapshot.h"
+#include "reppanel_json_arena.h"
+#include "reppanel_filelist.h"
+#include "reppanel_thumbnail.h"
+#include "reppanel_gcode_queue.h"
+#include "reppanel_uart_txn.h"
+#include "reppanel_sbc_ws.h"
 
 #define TAG                         "RequestTask"
 #define REQUEST_TIMEOUT_MS          50
 #define REQUEST_TIMEOUT_FILEINFO_MS 1500    // getting the file info may take very long for the duet
+#define REQUEST_TIMEOUT_REPLY_MS    1000
+#define RRF3_FULL_MODEL_MIN_KEYS    4       // request the whole object model at once if that many keys changed
+#define RRF3_MAX_REQUESTS_PER_TICK  3       // single key requests per poll so we do not overrun the poll period
 
-EXT_RAM_ATTR file_tree_elem_t reprap_dir_elem[MAX_NUM_ELEM_DIR];    // put it to the external PSRAM
 static char request_file_path[512];
 
 char rep_addr_resolved[512];
@@ -48,46 +60,61 @@ int last_status_seq = -1;
 
 static bool request_file_info = false;
 
+static rrf3_stream_parser_t status_parser;     // object model responses are parsed while they are received
+
+static void status_parser_begin(void *ctx) {
+    rrf3_stream_begin((rrf3_stream_parser_t *) ctx, &reprap_work);
+}
+
+static bool status_parser_feed(void *ctx, const char *data, int len) {
+    return rrf3_stream_feed((rrf3_stream_parser_t *) ctx, data, len);
+}
+
+static const http_pool_consumer_t status_parser_consumer = {
+        .begin = status_parser_begin,
+        .feed = status_parser_feed,
+};
+
 #ifdef CONFIG_REPPANEL_RRF2_SUPPORT
 const char *decode_reprap2_status(const char *valuestring) {
-    job_paused = false;
+    reprap_work.job_paused = false;
     switch (*valuestring) {
         case REPRAP_STATUS_PROCESS_CONFIG:
-            job_running = false;
+            reprap_work.job_running = false;
             return "Reading config";
         case REPRAP_STATUS_IDLE:
-            job_running = false;
+            reprap_work.job_running = false;
             return "Idle";
         case REPRAP_STATUS_BUSY:
-            job_running = false;
+            reprap_work.job_running = false;
             return "Busy";
         case REPRAP_STATUS_PRINTING:
-            job_running = true;
+            reprap_work.job_running = true;
             return "Printing";
         case REPRAP_STATUS_DECELERATING:
-            job_running = false;
+            reprap_work.job_running = false;
             return "Decelerating";
         case REPRAP_STATUS_STOPPED:
-            job_running = true;
-            job_paused = true;
+            reprap_work.job_running = true;
+            reprap_work.job_paused = true;
             return "Paused";
         case REPRAP_STATUS_RESUMING:
-            job_running = true;
+            reprap_work.job_running = true;
             return "Resuming";
         case REPRAP_STATUS_HALTED:
-            job_running = false;
+            reprap_work.job_running = false;
             return "Halted";
         case REPRAP_STATUS_FLASHING:
-            job_running = false;
+            reprap_work.job_running = false;
             return "Flashing";
         case REPRAP_STATUS_CHANGINGTOOL:
-            job_running = true;
+            reprap_work.job_running = true;
             return "Tool change";
         case REPRAP_STATUS_SIMULATING:
-            job_running = true;
+            reprap_work.job_running = true;
             return "Simulating";
         case REPRAP_STATUS_OFF:
-            job_running = false;
+            reprap_work.job_running = false;
             return "Off";
         default:
             break;
@@ -97,17 +124,17 @@ const char *decode_reprap2_status(const char *valuestring) {
 #endif
 
 void decode_rrf3_status() {
-    if (strncmp(reprap_model.reprap_state.status, "simulating", REPRAP_MAX_STATUS_LEN - 1) == 0
-        || strncmp(reprap_model.reprap_state.status, "printing", REPRAP_MAX_STATUS_LEN - 1) == 0
-        || strncmp(reprap_model.reprap_state.status, "processing", REPRAP_MAX_STATUS_LEN - 1) == 0) {
-        job_running = true;
-        job_paused = false;
-    } else if (strncmp(reprap_model.reprap_state.status, "paused", REPRAP_MAX_STATUS_LEN - 1) == 0) {
-        job_paused = true;
-        job_running = true;
+    if (strncmp(reprap_work.model.reprap_state.status, "simulating", REPRAP_MAX_STATUS_LEN - 1) == 0
+        || strncmp(reprap_work.model.reprap_state.status, "printing", REPRAP_MAX_STATUS_LEN - 1) == 0
+        || strncmp(reprap_work.model.reprap_state.status, "processing", REPRAP_MAX_STATUS_LEN - 1) == 0) {
+        reprap_work.job_running = true;
+        reprap_work.job_paused = false;
+    } else if (strncmp(reprap_work.model.reprap_state.status, "paused", REPRAP_MAX_STATUS_LEN - 1) == 0) {
+        reprap_work.job_paused = true;
+        reprap_work.job_running = true;
     } else {
-        job_running = false;
-        job_paused = false;
+        reprap_work.job_running = false;
+        reprap_work.job_paused = false;
     }
 }
 
@@ -119,34 +146,34 @@ static bool duet_request_reply = false;
  * @param buff raw HTTP response buffer containing the JSON
  */
 void process_reprap2_status(char *buff) {
-    cJSON *root = cJSON_Parse(buff);
+    cJSON *root = reppanel_json_parse(buff, strlen(buff));
     if (root == NULL) {
         const char *error_ptr = cJSON_GetErrorPtr();
         if (error_ptr != NULL) {
             ESP_LOGE(TAG, "Error before: %s", error_ptr);
         }
-        cJSON_Delete(root);
+        reppanel_json_delete(root);
         return;
     }
 
     cJSON *name = cJSON_GetObjectItem(root, DUET_STATUS);
     if (cJSON_IsString(name) && (name->valuestring != NULL)) {
-        strlcpy(reprap_model.reprap_state.status, decode_reprap2_status(name->valuestring), REPRAP_MAX_STATUS_LEN);
+        strlcpy(reprap_work.model.reprap_state.status, decode_reprap2_status(name->valuestring), REPRAP_MAX_STATUS_LEN);
     }
 
     cJSON *coords = cJSON_GetObjectItem(root, "coords");
     if (coords) {
         cJSON *axesHomed = cJSON_GetObjectItem(coords, "axesHomed");
         if (axesHomed && cJSON_IsArray(axesHomed)) {
-            reprap_axes.homed[0] = cJSON_GetArrayItem(axesHomed, 0)->valueint == 1;
-            reprap_axes.homed[1] = cJSON_GetArrayItem(axesHomed, 1)->valueint == 1;
-            reprap_axes.homed[2] = cJSON_GetArrayItem(axesHomed, 2)->valueint == 1;
+            reprap_work.axes.homed[0] = cJSON_GetArrayItem(axesHomed, 0)->valueint == 1;
+            reprap_work.axes.homed[1] = cJSON_GetArrayItem(axesHomed, 1)->valueint == 1;
+            reprap_work.axes.homed[2] = cJSON_GetArrayItem(axesHomed, 2)->valueint == 1;
         }
         cJSON *xyz = cJSON_GetObjectItem(coords, "xyz");
         if (xyz && cJSON_IsArray(xyz)) {
-            reprap_axes.axes[0] = cJSON_GetArrayItem(xyz, 0)->valuedouble;
-            reprap_axes.axes[1] = cJSON_GetArrayItem(xyz, 1)->valuedouble;
-            reprap_axes.axes[2] = cJSON_GetArrayItem(xyz, 2)->valuedouble;
+            reprap_work.axes.axes[0] = cJSON_GetArrayItem(xyz, 0)->valuedouble;
+            reprap_work.axes.axes[1] = cJSON_GetArrayItem(xyz, 1)->valuedouble;
+            reprap_work.axes.axes[2] = cJSON_GetArrayItem(xyz, 2)->valuedouble;
         }
     }
 
@@ -154,47 +181,52 @@ void process_reprap2_status(char *buff) {
     if (params) {
         cJSON *atxPower = cJSON_GetObjectItem(params, "atxPower");
         if (atxPower && cJSON_IsNumber(atxPower)) {
-            reprap_params.power = atxPower->valueint == 1;
+            reprap_work.params.power = atxPower->valueint == 1;
         }
         cJSON *fanPercent = cJSON_GetObjectItem(params, "fanPercent");
         if (fanPercent && cJSON_IsArray(fanPercent)) {
-            reprap_params.fan = cJSON_GetArrayItem(fanPercent, 0)->valueint;
+            reprap_work.params.fan = cJSON_GetArrayItem(fanPercent, 0)->valueint;
         }
     }
 
-    int _heater_states[MAX_NUM_TOOLS];  // bed heater state must be on pos 0
     cJSON *duet_temps = cJSON_GetObjectItem(root, DUET_TEMPS);
     if (duet_temps) {
         cJSON *duet_temps_bed = cJSON_GetObjectItem(duet_temps, DUET_TEMPS_BED);
-        if (duet_temps_bed) {
-            if (reprap_bed.temp_hist_curr_pos < (NUM_TEMPS_BUFF - 1)) {
-                reprap_bed.temp_hist_curr_pos++;
-            } else {
-                reprap_bed.temp_hist_curr_pos = 0;
-            }
-            reprap_bed.temp_buff[reprap_bed.temp_hist_curr_pos] = cJSON_GetObjectItem(duet_temps_bed,
-                                                                                      DUET_TEMPS_BED_CURRENT)->valuedouble;
+        cJSON *duet_temps_bed_current = cJSON_GetObjectItem(duet_temps_bed, DUET_TEMPS_BED_CURRENT);
+        if (duet_temps_bed_current && cJSON_IsNumber(duet_temps_bed_current)) {
+            reprap_work.bed.current_temp = duet_temps_bed_current->valuedouble;
         }
         // Get bed heater index
         cJSON *duet_temps_bed_heater = cJSON_GetObjectItem(duet_temps_bed,
                                                            DUET_TEMPS_BED_HEATER);    // bed heater state
         if (duet_temps_bed_heater && cJSON_IsNumber(duet_temps_bed_heater)) {
-            reprap_bed.heater_indx = duet_temps_bed_heater->valueint;
+            reprap_work.bed.heater_indx = duet_temps_bed_heater->valueint;
         }
         // Get bed active temp
         cJSON *duet_temps_bed_active = cJSON_GetObjectItem(duet_temps_bed, DUET_TEMPS_ACTIVE);    // bed active temp
         if (duet_temps_bed_active && cJSON_IsNumber(duet_temps_bed_active)) {
-            reprap_bed.active_temp = duet_temps_bed_active->valuedouble;
+            reprap_work.bed.active_temp = duet_temps_bed_active->valuedouble;
         }
         // Get bed standby temp
         cJSON *duet_temps_bed_standby = cJSON_GetObjectItem(duet_temps_bed, DUET_TEMPS_STANDBY);    // bed active temp
         if (duet_temps_bed_standby && cJSON_IsNumber(duet_temps_bed_standby)) {
-            reprap_bed.standby_temp = duet_temps_bed_standby->valuedouble;
+            reprap_work.bed.standby_temp = duet_temps_bed_standby->valuedouble;
         }
         // Get bed heater state
         cJSON *duet_temps_bed_state = cJSON_GetObjectItem(duet_temps_bed, DUET_TEMPS_BED_STATE);    // bed heater state
         if (duet_temps_bed_state && cJSON_IsNumber(duet_temps_bed_state)) {
-            _heater_states[0] = duet_temps_bed_state->valueint;
+            reprap_work.heater_states[0] = duet_temps_bed_state->valueint;
+        }
+        // Chamber is only reported if there is a chamber heater
+        cJSON *duet_temps_chamber = cJSON_GetObjectItem(duet_temps, DUET_TEMPS_CHAMBER);
+        cJSON *duet_temps_chamber_current = cJSON_GetObjectItem(duet_temps_chamber, DUET_TEMPS_CURRENT);
+        cJSON *duet_temps_chamber_heater = cJSON_GetObjectItem(duet_temps_chamber, DUET_TEMPS_BED_HEATER);
+        if (duet_temps_chamber_current && cJSON_IsNumber(duet_temps_chamber_current)) {
+            reprap_work.chamber.current_temp = duet_temps_chamber_current->valuedouble;
+            reprap_work.chamber.heater_indx = cJSON_IsNumber(duet_temps_chamber_heater) ?
+                                              duet_temps_chamber_heater->valueint : 0;
+        } else {
+            reprap_work.chamber.heater_indx = -1;
         }
     }
 
@@ -255,13 +287,13 @@ void process_reprap2_status(char *buff) {
     cJSON *iterator = NULL;
     cJSON_ArrayForEach(iterator, duet_temps_state) {
         if (cJSON_IsNumber(iterator)) {
-            if (pos != reprap_bed.heater_indx) {                                            // ignore bed heater
-                _heater_states[pos] = iterator->valueint;
+            if (pos != reprap_work.bed.heater_indx) {                                            // ignore bed heater
+                reprap_work.heater_states[pos] = iterator->valueint;
             }
             pos++;
         }
     }
-    reprap_model.num_heaters = pos;
+    reprap_work.model.num_heaters = pos;
 
     // Get tool information
     pos = 0;
@@ -270,30 +302,30 @@ void process_reprap2_status(char *buff) {
         cJSON_ArrayForEach(iterator, tools) {
             if (cJSON_IsObject(iterator)) {
                 if (cJSON_IsNumber(cJSON_GetObjectItem(iterator, "number")))
-                    reprap_tools[pos].number = cJSON_GetObjectItem(iterator, "number")->valueint;
+                    reprap_work.tools[pos].number = cJSON_GetObjectItem(iterator, "number")->valueint;
                 if (cJSON_IsString(cJSON_GetObjectItem(iterator, "name")))
-                    strlcpy(reprap_tools[pos].name, cJSON_GetObjectItem(iterator, "name")->valuestring,
+                    strlcpy(reprap_work.tools[pos].name, cJSON_GetObjectItem(iterator, "name")->valuestring,
                             MAX_TOOL_NAME_LEN);
                 if (cJSON_IsString(cJSON_GetObjectItem(iterator, "filament")))
-                    strlcpy(reprap_tools[pos].filament, cJSON_GetObjectItem(iterator, "filament")->valuestring,
+                    strlcpy(reprap_work.tools[pos].filament, cJSON_GetObjectItem(iterator, "filament")->valuestring,
                             MAX_FILA_NAME_LEN);
-                reprap_tools[pos].heater_indx = pos + 1;    // set to some default value
+                reprap_work.tools[pos].heater_indx = pos + 1;    // set to some default value
                 if (cJSON_IsArray(cJSON_GetObjectItem(iterator, "heaters"))) {
                     // Ignore multiple heaters per tool
                     cJSON *heaterindx_item = cJSON_GetArrayItem(cJSON_GetObjectItem(iterator, "heaters"), 0);
-                    reprap_tools[pos].heater_indx = heaterindx_item->valueint;
+                    reprap_work.tools[pos].heater_indx = heaterindx_item->valueint;
                 }
                 pos++;
             }
         }
         got_extended_status = true;
-        reprap_model.num_tools = pos;    // update number of tools
+        reprap_work.model.num_tools = pos;    // update number of tools
     }
 
     // Get firmware information
     cJSON *mcutemp = cJSON_GetObjectItem(root, DUET_MCU_TEMP);
     if (mcutemp)
-        reprap_mcu_temp = cJSON_GetObjectItem(mcutemp, "cur")->valuedouble;
+        reprap_work.mcu_temp = cJSON_GetObjectItem(mcutemp, "cur")->valuedouble;
     cJSON *firmware_name = cJSON_GetObjectItem(root, DUET_FIRM_NAME);
     if (firmware_name)
         strlcpy(reprap_firmware_name, firmware_name->valuestring, sizeof(reprap_firmware_name));
@@ -304,14 +336,10 @@ void process_reprap2_status(char *buff) {
     // Get current tool temperatures
     cJSON *duet_temps_current = cJSON_GetObjectItem(duet_temps, DUET_TEMPS_CURRENT);
     if (duet_temps_current) {
-        for (int i = 0; i < reprap_model.num_tools; i++) {
-            if (reprap_tools[i].temp_hist_curr_pos < (NUM_TEMPS_BUFF - 1)) {
-                reprap_tools[i].temp_hist_curr_pos++;
-            } else {
-                reprap_tools[i].temp_hist_curr_pos = 0;
-            }
-            reprap_tools[i].temp_buff[reprap_tools[i].temp_hist_curr_pos] = cJSON_GetArrayItem(duet_temps_current,
-                                                                                               reprap_tools[i].heater_indx)->valuedouble;
+        for (int i = 0; i < reprap_work.model.num_tools; i++) {
+            cJSON *tool_current = cJSON_GetArrayItem(duet_temps_current, reprap_work.tools[i].heater_indx);
+            if (tool_current && cJSON_IsNumber(tool_current))
+                reprap_work.tools[i].current_temp = tool_current->valuedouble;
         }
     }
     // Get active & standby tool temperatures. As for now there is only support one heater per tool
@@ -320,199 +348,84 @@ void process_reprap2_status(char *buff) {
     cJSON *duet_temps_tools_standby = cJSON_GetObjectItem(duet_temps_tools, DUET_TEMPS_STANDBY);
     if (duet_temps_tools_active && cJSON_IsArray(duet_temps_tools_active) && duet_temps_tools_standby &&
         cJSON_IsArray(duet_temps_tools_standby)) {
-        for (int i = 0; i < reprap_model.num_tools; i++) {
+        for (int i = 0; i < reprap_work.model.num_tools; i++) {
             cJSON *tool_active_temps_arr = cJSON_GetArrayItem(duet_temps_tools_active,
-                                                              reprap_tools[i].number);
+                                                              reprap_work.tools[i].number);
             cJSON *tool_standby_temps_arr = cJSON_GetArrayItem(duet_temps_tools_standby,
-                                                               reprap_tools[i].number);
+                                                               reprap_work.tools[i].number);
             if (tool_active_temps_arr) {
-                reprap_tools[i].active_temp = cJSON_GetArrayItem(tool_active_temps_arr, 0)->valuedouble;
+                reprap_work.tools[i].active_temp = cJSON_GetArrayItem(tool_active_temps_arr, 0)->valuedouble;
             }
             if (tool_standby_temps_arr) {
-                reprap_tools[i].standby_temp = cJSON_GetArrayItem(tool_standby_temps_arr, 0)->valuedouble;
+                reprap_work.tools[i].standby_temp = cJSON_GetArrayItem(tool_standby_temps_arr, 0)->valuedouble;
             }
         }
     }
     // print job status
-    bool got_printjob_status = false;
     cJSON *print_progess = cJSON_GetObjectItem(root, REPRAP_FRAC_PRINTED);
     if (print_progess && cJSON_IsNumber(print_progess)) {
-        got_printjob_status = true;
-        reprap_job_percent = print_progess->valuedouble;
+        reprap_work.job_percent = print_progess->valuedouble;
     }
 
     cJSON *job_dur = cJSON_GetObjectItem(root, REPRAP_JOB_DUR);
     if (job_dur && cJSON_IsNumber(job_dur)) {
-        reprap_model.reprap_job.duration = job_dur->valueint;
+        reprap_work.model.reprap_job.duration = job_dur->valueint;
     }
 
     cJSON *job_curr_layer = cJSON_GetObjectItem(root, REPRAP_CURR_LAYER);
     if (job_curr_layer && cJSON_IsNumber(job_curr_layer)) {
-        reprap_model.reprap_job.layer = job_curr_layer->valueint;
+        reprap_work.model.reprap_job.layer = job_curr_layer->valueint;
     }
 
-    // update UI
-    if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
-        if (label_status != NULL) lv_label_set_text(label_status, reprap_model.reprap_state.status);
-        update_ui_machine();
-        update_bed_temps_ui();
-        update_heater_status_ui(_heater_states, reprap_model.num_heaters);  // update UI with new values
-        update_process_status_ui();
-        update_header_temp_ui();
-        if (got_printjob_status) update_print_job_status_ui();
+    reppanel_snapshot_publish();    // GUI task updates the UI with the new values
+    if ((disp_msg || disp_msgbox) && xGuiSemaphore != NULL &&
+        xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
         if (disp_msg) show_reprap_dialog("", msg_txt,  1, false);
         if (disp_msgbox) show_reprap_dialog(msg_title, msg_msg, msg_mode, disp_z_jog_buttons);
-        update_rep_panel_conn_status();
         xSemaphoreGive(xGuiSemaphore);
     }
 
-    cJSON_Delete(root);
+    reppanel_json_delete(root);
 
 }
 #endif
 
 /**
  * For RRF3 object model responses
- * @param buff raw HTTP response buffer containing object model JSON
+ * @param parser Parser that was fed the entire object model response
  */
-void process_reprap3_status(char *buff) {
-    cJSON *root = cJSON_ParseWithLength(buff, JSON_BUFF_SIZE);
-    if (root == NULL) {
-        const char *error_ptr = cJSON_GetErrorPtr();
-        if (error_ptr != NULL) {
-            ESP_LOGE(TAG, "Error before: %s", error_ptr);
-        }
-        cJSON_Delete(root);
-        return;
-    }
-    cJSON *result = cJSON_GetObjectItem(root, "result");
-    if (result == NULL) {
-        cJSON_Delete(root);
+void process_reprap3_status(rrf3_stream_parser_t *parser) {
+    if (!rrf3_stream_end(parser))
         return;
-    }
-    cJSON *key = cJSON_GetObjectItem(root, "key");
-    cJSON *flags = cJSON_GetObjectItem(root, "flags");
-    cJSON *sub_object_result;
-    sub_object_result = cJSON_GetObjectItem(result, "boards");
-    if (sub_object_result)
-        reppanel_parse_rrf_boards(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "boards") == 0)
-        reppanel_parse_rrf_boards(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "fans");
-    if (sub_object_result)
-        reppanel_parse_rrf_fans(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "fans") == 0) {
-        reppanel_parse_rrf_fans(result, flags, &reprap_model);
-    }
-
-    sub_object_result = cJSON_GetObjectItem(result, "heat");
-    if (sub_object_result)
-        reppanel_parse_rrf_heaters(sub_object_result, heater_states, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "heat") == 0)
-        reppanel_parse_rrf_heaters(result, heater_states, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "tools");
-    if (sub_object_result)
-        reppanel_parse_rrf_tools(sub_object_result, heater_states, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "tools") == 0)
-        reppanel_parse_rrf_tools(result, heater_states, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "job");
-    if (sub_object_result)
-        reppanel_parse_rrf_job(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "job") == 0)
-        reppanel_parse_rrf_job(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "move");
-    if (sub_object_result)
-        reppanel_parse_rrf_move(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "move") == 0)
-        reppanel_parse_rrf_move(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "state");
-    if (sub_object_result)
-        reppanel_parse_rrf_state(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "state") == 0)
-        reppanel_parse_rrf_state(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "network");
-    if (sub_object_result)
-        reppanel_parse_rrf_network(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "network") == 0)
-        reppanel_parse_rrf_network(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "sensors");
-    if (sub_object_result)
-        reppanel_parse_rrf_sensors(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "sensors") == 0)
-        reppanel_parse_rrf_sensors(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "inputs");
-    if (sub_object_result)
-        reppanel_parse_rrf_inputs(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "inputs") == 0)
-        reppanel_parse_rrf_inputs(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "seqs");
-    if (sub_object_result) {
-        reppanel_parse_rrf_seqs(sub_object_result, &reprap_model);
-    } else if (strcmp(key->valuestring, "seqs") == 0) {
-        reppanel_parse_rrf_seqs(result, &reprap_model);
-    }
-
-    sub_object_result = cJSON_GetObjectItem(result, "global");
-    if (sub_object_result)
-        reppanel_parse_rrf_global(sub_object_result, flags, &reprap_model);
-    else if (strcmp(key->valuestring, "global") == 0)
-        reppanel_parse_rrf_global(result, flags, &reprap_model);
-
-    sub_object_result = cJSON_GetObjectItem(result, "directories");
-    if (sub_object_result) {
-        reppanel_parse_rrf_directories(sub_object_result, flags, &reprap_model);
-    } else if (strcmp(key->valuestring, "directories") == 0) {
-        reppanel_parse_rrf_directories(result, flags, &reprap_model);
-    }
-    cJSON_Delete(root);
-
     decode_rrf3_status();
-
-    if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
-        if (label_status != NULL) lv_label_set_text(label_status, reprap_model.reprap_state.status);
-        update_ui_machine();
-        update_bed_temps_ui();  // update UI with new values
-        update_heater_status_ui(heater_states, reprap_model.num_heaters);  // update UI with new values
-        update_process_status_ui();     // update UI with new values
-        update_header_temp_ui();
-        if (job_running) update_print_job_status_ui();
-        update_rep_panel_conn_status();
-        if (reprap_model.reprap_state.new_msg) {
-            show_reprap_dialog(reprap_model.reprap_state.msg_box_title, reprap_model.reprap_state.msg_box_msg,
-                               reprap_model.reprap_state.mode, reprap_model.reprap_state.show_axis_controls);
-            reprap_model.reprap_state.new_msg = false;
-        }
-        xSemaphoreGive(xGuiSemaphore);
-    }
+    reppanel_snapshot_publish();    // GUI task updates the UI with the new values
 }
 
+/**
+ * Process a status response that was received entirely e.g. via UART
+ * @param buff NULL terminated response
+ */
 void process_reprap_status(char *buff) {
 #ifdef CONFIG_REPPANEL_RRF2_SUPPORT
-    if (reprap_model.api_level < 1)
+    if (reprap_work.model.api_level < 1) {
         process_reprap2_status(buff);
-    else
+        return;
+    }
 #endif
-        process_reprap3_status(buff);
+    rrf3_stream_begin(&status_parser, &reprap_work);
+    rrf3_stream_feed(&status_parser, buff, strlen(buff));
+    process_reprap3_status(&status_parser);
 }
 
 void process_reprap_settings(char *buff) {
     ESP_LOGI(TAG, "Processing DWC status json");
-    cJSON *root = cJSON_Parse(buff);
+    cJSON *root = reppanel_json_parse(buff, strlen(buff));
     if (root == NULL) {
         const char *error_ptr = cJSON_GetErrorPtr();
         if (error_ptr != NULL) {
             ESP_LOGE(TAG, "Error before: %s", error_ptr);
         }
-        cJSON_Delete(root);
+        reppanel_json_delete(root);
         return;
     }
     cJSON *machine = cJSON_GetObjectItem(root, "machine");
@@ -578,204 +491,321 @@ void process_reprap_settings(char *buff) {
         }
     }
     got_duet_settings = true;
-    cJSON_Delete(root);
+    reppanel_json_delete(root);
+}
+
+static void update_filelist_ui(const char *dir) {
+    if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
+        if (strncmp("0:/macros", dir, 9) == 0)
+            update_macro_list_ui();
+        else
+            update_job_list_ui();
+        xSemaphoreGive(xGuiSemaphore);
+    }
+}
+
+/**
+ * Show the cached listing of a directory if it is still up to date. RRF2 & the DSF object model (SBC) have no
+ * seqs.directories so the cached listings expire after a while instead. Same till the first seqs.directories arrived
+ * @return false if the directory needs to be requested
+ */
+static bool show_cached_filelist(const char *dir) {
+    bool has_dir_seq = reprap_work.model.api_level >= 1 && !duet_sbc_mode &&
+                       reprap_work.model.reprap_seqs.directories != 0;
+    uint32_t max_age_ms = has_dir_seq ? 0 : FILELIST_CACHE_MAX_AGE_MS;
+    if (!reppanel_filelist_cache_load(dir, reprap_work.model.reprap_seqs.directories, max_age_ms)) return false;
+    update_filelist_ui(dir);
+    return true;
 }
 
-void process_reprap_filelist(char *buffer) {
-    cJSON *root = cJSON_Parse(buffer);
+/**
+ * Process one page of a directory listing (rr_filelist or M20 S3). Updates the macro/job list UI
+ * @param buffer NULL terminated response
+ * @return Index of the first entry of the next page. 0 if the listing is complete or the page was not processed
+ */
+int process_reprap_filelist(char *buffer) {
+    cJSON *root = reppanel_json_parse(buffer, strlen(buffer));
     if (root == NULL) {
         const char *error_ptr = cJSON_GetErrorPtr();
         if (error_ptr != NULL) {
             ESP_LOGE(TAG, "Error before: %s", error_ptr);
         }
-        cJSON_Delete(root);
-        return;
+        reppanel_json_delete(root);
+        return 0;
     }
     cJSON *err_resp = cJSON_GetObjectItem(root, "err");
     if (err_resp) {
         ESP_LOGE(TAG, "reprap_filelist - Duet responded with error code %i", err_resp->valueint);
-        ESP_LOGE(TAG, "%s", cJSON_Print(root));
-        cJSON_Delete(root);
-        return;
-    }
-    cJSON *next = cJSON_GetObjectItem(root, "next");
-    if (next != NULL && next->valueint != 0) {
-        // TODO: Not only get first list. Get all items. Check for next item
-    }
+        char *printed = cJSON_Print(root);
+        ESP_LOGE(TAG, "%s", printed);
+        cJSON_free(printed);
+        reppanel_json_delete(root);
+        return 0;
+    }
+    cJSON *first_item = cJSON_GetObjectItem(root, "first");
+    cJSON *next_item = cJSON_GetObjectItem(root, "next");
+    int first = cJSON_IsNumber(first_item) ? first_item->valueint : 0;
+    int next = cJSON_IsNumber(next_item) ? next_item->valueint : 0;
     cJSON *dir_name = cJSON_GetObjectItem(root, "dir");
-    if (dir_name && strncmp("0:/filaments", dir_name->valuestring, 12) == 0) {
+    if (!cJSON_IsString(dir_name)) {
+        reppanel_json_delete(root);
+        return 0;
+    }
+    if (strncmp("0:/filaments", dir_name->valuestring, 12) == 0) {
         ESP_LOGI(TAG, "Processing filament names");
         got_filaments = true;
-
+        if (first == 0) filament_names[0] = '\0';
         cJSON *filament_folders = cJSON_GetObjectItem(root, "files");
-        if (filament_folders) {
-            cJSON *iterator = NULL;
-            int pos = 0;
-            filament_names[0] = '\0';
-            cJSON_ArrayForEach(iterator, filament_folders) {
-                if (cJSON_IsObject(iterator)) {
-                    if (strncmp("d", cJSON_GetObjectItem(iterator, "type")->valuestring, 1) == 0) {
-                        if (pos != 0) strncat(filament_names, "\n", MAX_LEN_STR_FILAMENT_LIST - strlen(filament_names));
-                        strncat(filament_names, cJSON_GetObjectItem(iterator, "name")->valuestring,
-                                MAX_LEN_STR_FILAMENT_LIST - strlen(filament_names));
-                        pos++;
-                    }
-                }
-            }
-            ESP_LOGI(TAG, "Filament names\n%s", filament_names);
-        } else {
-            filament_names[0] = '\0';
-        }
-    } else if (dir_name && strncmp("0:/macros", dir_name->valuestring, 9) == 0) {
-        ESP_LOGI(TAG, "Processing macros");
-        // will add a back button if dir is empty
-        strncpy(reprap_dir_elem[0].dir, dir_name->valuestring, MAX_LEN_DIRNAME - 1);
-        for (int i = 0; i < MAX_NUM_ELEM_DIR; i++) {
-            reprap_dir_elem[i].type = TREE_EMPTY_ELEM;
-        }
-        cJSON *_folders = cJSON_GetObjectItem(root, "files");
-        if (_folders) {
-            cJSON *iterator = NULL;
-            int pos = 0;
-            cJSON_ArrayForEach(iterator, _folders) {
-                if (cJSON_IsObject(iterator)) {
-                    if (pos < MAX_NUM_ELEM_DIR) {
-                        strncpy(reprap_dir_elem[pos].name, cJSON_GetObjectItem(iterator, "name")->valuestring,
-                                MAX_LEN_FILENAME - 1);
-                        strncpy(reprap_dir_elem[pos].dir, dir_name->valuestring, MAX_LEN_DIRNAME - 1);
-                        reprap_dir_elem[pos].time_stamp = datestr_2unix(
-                                cJSON_GetObjectItem(iterator, "date")->valuestring);
-                        if (strncmp("f", cJSON_GetObjectItem(iterator, "type")->valuestring, 1) == 0) {
-                            reprap_dir_elem[pos].type = TREE_FILE_ELEM;
-                        } else {
-                            reprap_dir_elem[pos].type = TREE_FOLDER_ELEM;
-                        }
-                        pos++;
-                    }
-                }
-            }
-        }
-        if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
-            update_macro_list_ui();
-            xSemaphoreGive(xGuiSemaphore);
-        }
-    } else if (dir_name && strncmp("0:/gcodes", dir_name->valuestring, 9) == 0) {
-        ESP_LOGI(TAG, "Processing jobs");
         cJSON *iterator = NULL;
-        // will add a back button if dir is empty
-        strncpy(reprap_dir_elem[0].dir, dir_name->valuestring, MAX_LEN_DIRNAME - 1);
-        for (int i = 0; i < MAX_NUM_ELEM_DIR; i++) {  // clear array
-            reprap_dir_elem[i].type = TREE_EMPTY_ELEM;
-        }
-        int pos = 0;
-        cJSON *_folders = cJSON_GetObjectItem(root, "files");
-        if (_folders) {
-            cJSON_ArrayForEach(iterator, _folders) {
-                if (cJSON_IsObject(iterator)) {
-                    if (pos < MAX_NUM_ELEM_DIR) {
-                        strncpy(reprap_dir_elem[pos].name, cJSON_GetObjectItem(iterator, "name")->valuestring,
-                                MAX_LEN_FILENAME - 1);
-                        strncpy(reprap_dir_elem[pos].dir, dir_name->valuestring, MAX_LEN_DIRNAME - 1);
-                        reprap_dir_elem[pos].time_stamp = datestr_2unix(
-                                cJSON_GetObjectItem(iterator, "date")->valuestring);
-                        if (strncmp("f", cJSON_GetObjectItem(iterator, "type")->valuestring, 1) == 0) {
-                            reprap_dir_elem[pos].type = TREE_FILE_ELEM;
-                        } else {
-                            reprap_dir_elem[pos].type = TREE_FOLDER_ELEM;
-                        }
-                        pos++;
-                    }
-                }
+        cJSON_ArrayForEach(iterator, filament_folders) {
+            cJSON *type = cJSON_GetObjectItem(iterator, "type");
+            cJSON *name = cJSON_GetObjectItem(iterator, "name");
+            if (cJSON_IsString(type) && cJSON_IsString(name) && type->valuestring[0] == 'd') {
+                if (filament_names[0] != '\0')
+                    strncat(filament_names, "\n", MAX_LEN_STR_FILAMENT_LIST - strlen(filament_names) - 1);
+                strncat(filament_names, name->valuestring, MAX_LEN_STR_FILAMENT_LIST - strlen(filament_names) - 1);
             }
         }
-        if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
-            update_job_list_ui();
-            xSemaphoreGive(xGuiSemaphore);
+        ESP_LOGI(TAG, "Filament names\n%s", filament_names);
+    } else if (strncmp("0:/macros", dir_name->valuestring, 9) == 0 ||
+               strncmp("0:/gcodes", dir_name->valuestring, 9) == 0) {
+        ESP_LOGI(TAG, "Processing %s", dir_name->valuestring);
+        if (reppanel_filelist_add_page(dir_name->valuestring, first, next, cJSON_GetObjectItem(root, "files"))) {
+            if (next <= 0) reppanel_filelist_cache_store(reprap_work.model.reprap_seqs.directories);
+            update_filelist_ui(dir_name->valuestring);
+        } else {
+            next = 0;
         }
+    } else {
+        next = 0;
+    }
+    reppanel_json_delete(root);
+    return next > 0 ? next : 0;
+}
+
+/**
+ * Show the completed or cached thumbnail
+ */
+static void publish_thumbnail() {
+    if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, portMAX_DELAY) == pdTRUE) {
+        if (reppanel_thumbnail_publish()) {
+            update_file_info_thumbnail_ui();
+            update_job_thumbnail_ui();
+        }
+        xSemaphoreGive(xGuiSemaphore);
+    }
+}
+
+/**
+ * Show the thumbnail reppanel_parse_file_info() picked from the flash cache or start fetching it, unless it is
+ * already shown or being fetched
+ * @param file_path File the info was requested for. NULL or empty for the file of the current job
+ */
+static void request_thumbnail(const char *file_path) {
+    if (duet_sbc_mode) return;     // DSF does not provide rr_thumbnail
+    reprap_job_t *job = &reprap_work.model.reprap_job;
+    bool cached;
+    if (file_path != NULL && strlen(file_path) > 0) {
+        cached = reppanel_thumbnail_request(file_path, job->file.size, job->file.lastModified, &job->file.thumbnail);
+    } else {
+        char job_path[MAX_LEN_FILENAME + 10];
+        snprintf(job_path, sizeof(job_path), "0:/gcodes%s", job->file.fileName);   // stored without 0:/gcodes
+        cached = reppanel_thumbnail_request(job_path, job->file.size, job->file.lastModified, &job->file.thumbnail);
+    }
+    if (cached) publish_thumbnail();
+}
+
+/**
+ * Process a chunk of a thumbnail (rr_thumbnail, M31.1). Updates the UI once the thumbnail is complete
+ * @return false if the response holds no valid chunk
+ */
+bool process_reprap_thumbnail(char *buffer) {
+    cJSON *root = reppanel_json_parse(buffer, strlen(buffer));
+    if (root == NULL) {
+        reppanel_json_delete(root);
+        return false;
+    }
+    cJSON *err_resp = cJSON_GetObjectItem(root, "err");
+    cJSON *offset = cJSON_GetObjectItem(root, "offset");
+    cJSON *data = cJSON_GetObjectItem(root, "data");
+    cJSON *next = cJSON_GetObjectItem(root, "next");
+    if ((err_resp && err_resp->valueint != 0) || !cJSON_IsNumber(offset) || !cJSON_IsString(data) ||
+        !cJSON_IsNumber(next)) {
+        ESP_LOGW(TAG, "Invalid thumbnail response");
+        reppanel_json_delete(root);
+        return false;
+    }
+    if (reppanel_thumbnail_add_chunk(offset->valueint, data->valuestring, next->valueint)) publish_thumbnail();
+    reppanel_json_delete(root);
+    return true;
+}
+
+/**
+ * Show a reply of the Duet to a G-Code. Also added to the console history
+ */
+static void show_reprap_reply(char *reply) {
+    if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 10) == pdTRUE) {
+#ifdef CONFIG_REPPANEL_ESP32_CONSOLE_ENABLED
+        add_console_hist_entry(reply, CONSOLE_TYPE_INFO);
+        update_entries_ui();
+#endif
+        show_reprap_dialog("Response to G-Code", reply, 1, false);
+        xSemaphoreGive(xGuiSemaphore);
     }
-    cJSON_Delete(root);
 }
 
 void process_reprap_reply(wifi_response_buff_t *response_buffer) {
     if (response_buffer->buf_pos > 1) {
-        if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 10) == pdTRUE) {
-            show_reprap_dialog("Response to G-Code", response_buffer->buffer, 1, false);
-            xSemaphoreGive(xGuiSemaphore);
-        }
-        reprap_model.reprap_seqs_changed.reply_changed = 0;
+        show_reprap_reply(response_buffer->buffer);
+        reprap_work.model.reprap_seqs_changed.reply_changed = 0;
     }
 }
 
-void reprap_uart_send_gcode(char *gcode) {
-    reppanel_write_uart(gcode, strlen(gcode));
-    ESP_LOGD(TAG, "Sent %s", gcode);
+/**
+ * Text received via UART that no request waits for. {"resp":"..."} or plain text
+ */
+static void process_uart_text(char *line, void *ctx) {
+    cJSON *root = NULL;
+    char *text = line;
+    if (line[0] == '{') {
+        root = reppanel_json_parse(line, strlen(line));
+        cJSON *resp = cJSON_GetObjectItem(root, "resp");
+        text = cJSON_IsString(resp) ? resp->valuestring : "";
+    }
+    while (strlen(text) > 0 && (text[strlen(text) - 1] == '\n' || text[strlen(text) - 1] == '\r'))
+        text[strlen(text) - 1] = '\0';
+    if (strlen(text) > 0) show_reprap_reply(text);
+    reppanel_json_delete(root);
+}
+
+/**
+ * Write a G-Code that has no response of its own. Replies end up in process_uart_text()
+ * @param receive_buff Used for responses to requests in flight that are read before the G-Code fits
+ */
+void reprap_uart_send_gcode(uart_response_buff_t *receive_buff, char *gcode) {
+    reppanel_uart_txn_submit(receive_buff, gcode, UART_RESP_NONE, NULL, NULL);
 }
 
 void reprap_uart_check_objmodel_support(uart_response_buff_t *receive_buff) {
     ESP_LOGI(TAG, "Checking RRF API-Level Support");
+    // RRF2 responds with an error message, so do not use a transaction
+    reppanel_uart_txn_cancel_all();
     esp32_flush_uart();
-    reprap_uart_send_gcode("M409 F\"d2f\"");
+    reppanel_write_uart("M409 F\"d2f\"", strlen("M409 F\"d2f\""));
     if (reppanel_read_response(receive_buff)) {
-        cJSON *root = cJSON_Parse((char *) receive_buff->buffer);
+        cJSON *root = reppanel_json_parse((char *) receive_buff->buffer, strlen((char *) receive_buff->buffer));
         if (root == NULL) {
             ESP_LOGW(TAG, "Could not detect M409 Object Model query support");
-            cJSON_Delete(root);
-            reprap_model.api_level = 0;
+            reppanel_json_delete(root);
+            reprap_work.model.api_level = 0;
             return;
         }
         cJSON *result = cJSON_GetObjectItem(root, "result");
         if (result == NULL) {
             ESP_LOGW(TAG, "Could not detect M409 Object Model \"result\" as part of JSON");
-            cJSON_Delete(root);
-            reprap_model.api_level = 0;
+            reppanel_json_delete(root);
+            reprap_work.model.api_level = 0;
             return;
         }
-        reprap_model.api_level = 1;
+        reprap_work.model.api_level = 1;
+        reppanel_json_delete(root);
     } else {
         ESP_LOGW(TAG, "Did not receive a response on requesting M409 Object Model");
-        reprap_model.api_level = 0;
+        reprap_work.model.api_level = 0;
     }
-    ESP_LOGI(TAG, "Detected API-Level Support: %i", reprap_model.api_level);
+    ESP_LOGI(TAG, "Detected API-Level Support: %i", reprap_work.model.api_level);
+}
+
+static void uart_status_done(char *line, void *ctx) {
+    if (line == NULL) return;
+    ESP_LOGD(TAG, "%s", line);
+    process_reprap_status(line);
 }
 
+/**
+ * Request the status via UART. Does not wait for the response. See reppanel_uart_txn_wait_all()
+ */
 void reprap_uart_get_status(uart_response_buff_t *receive_buff, int type, char *key, char *flags) {
-    ESP_LOGI(TAG, "Getting status (UART) %i - API-Level %i - key: %s flags: %s", type, reprap_model.api_level, key, flags);
+    ESP_LOGI(TAG, "Getting status (UART) %i - API-Level %i - key: %s flags: %s", type, reprap_work.model.api_level, key,
+             flags);
     char buff[32];
-    if (reprap_model.api_level < 1) {
+    if (reprap_work.model.api_level < 1) {
         sprintf(buff, "M408 S%i", type);
+        reppanel_uart_txn_submit(receive_buff, buff, UART_RESP_STATUS, uart_status_done, NULL);
     } else {
         sprintf(buff, "M409 K\"%s\" F\"%s\"", key, flags);
-    }
-    reprap_uart_send_gcode(buff);
-    if (reppanel_read_response(receive_buff)) {
-        ESP_LOGD(TAG, "%s", receive_buff->buffer);
-        process_reprap_status((char *) receive_buff->buffer);
+        reppanel_uart_txn_submit(receive_buff, buff, UART_RESP_OBJECT_MODEL, uart_status_done, NULL);
     }
 }
 
+/**
+ * Passes the response of a request that waits for it to the caller
+ */
+static void uart_response_done(char *line, void *ctx) {
+    *(char **) ctx = line;
+}
+
+/**
+ * Send a request & wait for its response and all others in flight
+ * @return Response. Valid till the next request. NULL if there was none
+ */
+static char *reprap_uart_request(uart_response_buff_t *receive_buff, const char *gcode, uart_resp_type_t expect) {
+    char *response = NULL;
+    reppanel_uart_txn_submit(receive_buff, gcode, expect, uart_response_done, &response);
+    reppanel_uart_txn_wait_all(receive_buff);
+    return response;
+}
+
 void reprap_uart_get_file_info(uart_response_buff_t *receive_buff) {
     char buff[524];
     sprintf(buff, "M36 \"%s\"", request_file_path);
-    reprap_uart_send_gcode(buff);
-    if (reppanel_read_response(receive_buff)) {
-        reppanel_parse_rr_fileinfo((char *) receive_buff->buffer, &reprap_model, sizeof(uart_response_buff_t));
+    char *response = reprap_uart_request(receive_buff, buff, UART_RESP_FILEINFO);
+    if (response != NULL) {
+        reppanel_parse_rr_fileinfo(response, &reprap_work.model, sizeof(uart_response_buff_t));
         ESP_LOGI(TAG, "Received file info");
         request_file_info = false;
+        request_thumbnail(request_file_path);
+        reppanel_snapshot_publish();
         // update UI of file dialog msg box
         if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
-            update_file_info_dialog_ui(&reprap_model);
+            update_file_info_dialog_ui(&reprap_work.model);
             xSemaphoreGive(xGuiSemaphore);
         }
     }
 }
 
-void reprap_uart_get_filelist(uart_response_buff_t *receive_buff, char *path) {
-    char buff[512];
-    sprintf(buff, "M20 S3 P\"%s\"", path);
-    reprap_uart_send_gcode(buff);
-    if (reppanel_read_response(receive_buff)) {
-        process_reprap_filelist((char *) receive_buff->buffer);
+/**
+ * Request one page of a directory listing via UART
+ * @param path Directory on the printer
+ * @param first Index of the first entry to list. 0 for the first page
+ * @return Index of the first entry of the next page. 0 if the listing is complete or the request failed
+ */
+int reprap_uart_get_filelist(uart_response_buff_t *receive_buff, char *path, int first) {
+    char buff[sizeof(request_file_path) + 24];
+    if (first > 0)
+        snprintf(buff, sizeof(buff), "M20 S3 P\"%s\" R%i", path, first);
+    else
+        snprintf(buff, sizeof(buff), "M20 S3 P\"%s\"", path);
+    char *response = reprap_uart_request(receive_buff, buff, UART_RESP_FILELIST);
+    if (response != NULL) {
+        return process_reprap_filelist(response);
+    }
+    return 0;
+}
+
+/**
+ * Request one chunk of a thumbnail via UART
+ * @param file G-code file containing the thumbnail
+ * @param offset Offset of the chunk as named by the file info or the previous chunk
+ */
+bool reprap_uart_get_thumbnail(uart_response_buff_t *receive_buff, char *file, uint32_t offset) {
+    char buff[sizeof(request_file_path) + 24];
+    snprintf(buff, sizeof(buff), "M31.1 P\"%s\" S%u", file, (unsigned) offset);
+    char *response = reprap_uart_request(receive_buff, buff, UART_RESP_THUMBNAIL);
+    if (response != NULL) {
+        return process_reprap_thumbnail(response);
     }
+    return false;
 }
 
 /**
@@ -793,43 +823,6 @@ void reprap_uart_download(uart_response_buff_t *receive_buff, char *path) {
     got_duet_settings = true;
 }
 
-esp_err_t http_event_handle(esp_http_client_event_t *evt) {
-    if (esp_http_client_get_status_code(evt->client) == 401) {
-        ESP_LOGW(TAG, "Need to authorise first. Ignoring data.");
-        return ESP_OK;
-    }
-    wifi_response_buff_t *resp_buff = (wifi_response_buff_t *) evt->user_data;
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGI(TAG, "Event handler detected http error");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            resp_buff->buf_pos = 0;
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-        case HTTP_EVENT_ON_HEADER:
-            break;
-        case HTTP_EVENT_ON_DATA:
-            if (!esp_http_client_is_chunked_response(evt->client)) {
-                if ((resp_buff->buf_pos + evt->data_len) < JSON_BUFF_SIZE) {
-                    strncpy(&resp_buff->buffer[resp_buff->buf_pos], (char *) evt->data, evt->data_len);
-                    resp_buff->buf_pos += evt->data_len;
-                } else {
-                    ESP_LOGE(TAG, "Status-JSON buffer overflow (%i >= %i). Resetting!",
-                             (evt->data_len + resp_buff->buf_pos), JSON_BUFF_SIZE);
-                    resp_buff->buf_pos = 0;
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            resp_buff->buf_pos = 0;
-            break;
-    }
-    return ESP_OK;
-}
-
 void wifi_duet_authorise(wifi_response_buff_t *resp_buff) {
     char printer_url[MAX_REQ_ADDR_LENGTH];
     if (duet_sbc_mode) {
@@ -837,31 +830,37 @@ void wifi_duet_authorise(wifi_response_buff_t *resp_buff) {
     } else {
         sprintf(printer_url, "%s/rr_connect?password=%s", rep_addr_resolved, rep_pass);
     }
-    esp_http_client_config_t config = {
-            .url = printer_url,
-            .timeout_ms = REQUEST_TIMEOUT_MS,
-            .event_handler = http_event_handle,
-            .user_data = resp_buff,
-    };
     ESP_LOGD(TAG, "Resp. buff is NULL: %i - %p", resp_buff==NULL, resp_buff);
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
+    http_pool_conn_t *conn = http_pool_acquire(printer_url, REQUEST_TIMEOUT_MS, resp_buff);
+    if (conn == NULL) return;
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    http_pool_release(conn, err == ESP_OK);
 
     if (err == ESP_OK) {
-        switch (esp_http_client_get_status_code(client)) {
+        switch (status_code) {
             case 200:
                 status_request_err_cnt = 0;
                 if (rp_conn_stat != REPPANEL_UART_CONNECTED)
                     rp_conn_stat = REPPANEL_WIFI_CONNECTED;
-                cJSON *root = cJSON_Parse(resp_buff->buffer);   // get JSON response to read API level
+                cJSON *root = reppanel_json_parse(resp_buff->buffer, resp_buff->buf_pos);   // read API level
                 if (root == NULL) {
                     ESP_LOGE(TAG, "Error parsing authorisation response");
-                    cJSON_Delete(root);
+                    reppanel_json_delete(root);
                     return;
                 }
-                reppanel_parse_rr_connect(root, &reprap_model);
-                cJSON_Delete(root);
-                ESP_LOGI(TAG, "Detected API Level %i", reprap_model.api_level);
+                reppanel_parse_rr_connect(root, &reprap_work.model);
+                reppanel_json_delete(root);
+                if (duet_sbc_mode) reprap_work.model.api_level = 1;     // DSF only provides the RRF3 object model
+                http_pool_set_session_key(reprap_work.model.session_key);
+                ESP_LOGI(TAG, "Detected API Level %i", reprap_work.model.api_level);
+                break;
+            case 404:
+                if (!duet_sbc_mode) {
+                    ESP_LOGI(TAG, "No rr_connect. Trying DSF of a Duet 3 + SBC");
+                    duet_sbc_mode = true;
+                    wifi_duet_authorise(resp_buff);
+                }
                 break;
             case 500:
                 ESP_LOGE(TAG, "Generic error authorising DUET");
@@ -877,8 +876,6 @@ void wifi_duet_authorise(wifi_response_buff_t *resp_buff) {
                 break;
         }
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
 }
 
 void reprap_wifi_get_status(wifi_response_buff_t *resp_buff, int type, char *key, char *flags) {
@@ -887,7 +884,7 @@ void reprap_wifi_get_status(wifi_response_buff_t *resp_buff, int type, char *key
         sprintf(request_addr, "%s/machine/status", rep_addr_resolved);
     else {
 #ifdef CONFIG_REPPANEL_RRF2_SUPPORT
-        if (reprap_model.api_level < 1) {
+        if (reprap_work.model.api_level < 1) {
             sprintf(request_addr, "%s/rr_status?type=%i", rep_addr_resolved, type);
         } else {
 #endif
@@ -900,23 +897,26 @@ void reprap_wifi_get_status(wifi_response_buff_t *resp_buff, int type, char *key
         }
 #endif
     }
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = REQUEST_TIMEOUT_MS,
-            .event_handler = http_event_handle,
-            .user_data = resp_buff,
-    };
     ESP_LOGI(TAG, "Requesting: %s", request_addr);
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_MS, resp_buff);
+    if (conn == NULL) return;
+    // object model is parsed while it is received
+    bool stream_object_model = duet_sbc_mode || reprap_work.model.api_level >= 1;
+    if (stream_object_model) http_pool_set_consumer(conn, &status_parser_consumer, &status_parser);
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    http_pool_release(conn, err == ESP_OK);
 
     if (err == ESP_OK) {
-        switch (esp_http_client_get_status_code(client)) {
+        switch (status_code) {
             case 200:
                 status_request_err_cnt = 0;
                 if (rp_conn_stat != REPPANEL_UART_CONNECTED)
                     rp_conn_stat = REPPANEL_WIFI_CONNECTED;
-                process_reprap_status(resp_buff->buffer);
+                if (stream_object_model)
+                    process_reprap3_status(&status_parser);
+                else
+                    process_reprap_status(resp_buff->buffer);
                 break;
             case 401:
                 ESP_LOGI(TAG, "Authorising with Duet");
@@ -947,24 +947,19 @@ void reprap_wifi_get_status(wifi_response_buff_t *resp_buff, int type, char *key
             }
         }
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
 }
 
 void reprap_wifi_get_rreply(wifi_response_buff_t *response_buffer) {
     char request_addr[MAX_REQ_ADDR_LENGTH];
     sprintf(request_addr, "%s/rr_reply", rep_addr_resolved);
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = 1000,
-            .event_handler = http_event_handle,
-            .user_data = response_buffer
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_REPLY_MS, response_buffer);
+    if (conn == NULL) return;
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    http_pool_release(conn, err == ESP_OK);
     ESP_LOGI(TAG, "Requesting rr_reply");
     if (err == ESP_OK) {
-        switch (esp_http_client_get_status_code(client)) {
+        switch (status_code) {
             case 200:
                 if (response_buffer->buf_pos > 1) {
                     ESP_LOGI(TAG, "Got reply!");
@@ -976,52 +971,56 @@ void reprap_wifi_get_rreply(wifi_response_buff_t *response_buffer) {
                 wifi_duet_authorise(response_buffer);
                 break;
             default:
-                ESP_LOGE(TAG, "Error getting reply (HTTP error code %i)!", esp_http_client_get_status_code(client));
+                ESP_LOGE(TAG, "Error getting reply (HTTP error code %i)!", status_code);
                 break;
         }
     } else {
         ESP_LOGW(TAG, "Error getting reply via WiFi: %s", esp_err_to_name(err));
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
 }
 
-bool reprap_wifi_send_gcode(char *gcode) {
+/**
+ * Send a G-Code via WiFi & fetch the reply of the Duet. Call from request task
+ * @param resp_buffer Receives the reply
+ */
+bool reprap_wifi_send_gcode(wifi_response_buff_t *resp_buffer, char *gcode) {
     bool success = false;
     char request_addr[MAX_REQ_ADDR_LENGTH];
-    char encoded_gcode[strlen(gcode) * 3];
+    char encoded_gcode[strlen(gcode) * 3 + 1];
     url_encode((unsigned char *) gcode, encoded_gcode);
     if (duet_sbc_mode) {
         sprintf(request_addr, "%s/machine/code", rep_addr_resolved);
     } else {
-        sprintf(request_addr, "%s/rr_gcode?gcode=%s", rep_addr_resolved, encoded_gcode);
+        if (snprintf(request_addr, sizeof(request_addr), "%s/rr_gcode?gcode=%s", rep_addr_resolved,
+                     encoded_gcode) >= sizeof(request_addr)) {
+            ESP_LOGE(TAG, "G-Code too long to send: %s", gcode);
+            return false;
+        }
     }
 
     ESP_LOGV(TAG, "%s", request_addr);
-    wifi_response_buff_t resp_buff_gui_task;
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = REQUEST_TIMEOUT_MS,
-            .event_handler = http_event_handle,
-            .user_data = &resp_buff_gui_task
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_MS, resp_buffer);
+    if (conn == NULL) return false;
     if (duet_sbc_mode) {
-        esp_http_client_set_method(client, HTTP_METHOD_POST);
-        esp_http_client_set_post_field(client, gcode, strlen(gcode));
+        esp_http_client_set_method(conn->client, HTTP_METHOD_POST);
+        esp_http_client_set_post_field(conn->client, gcode, strlen(gcode));
     }
-    esp_err_t err = esp_http_client_perform(client);
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Status = %d, content_length = %d", status_code,
+                 esp_http_client_get_content_length(conn->client));
+    }
+    http_pool_release(conn, err == ESP_OK);
 
     if (err == ESP_OK) {
-        ESP_LOGI(TAG, "Status = %d, content_length = %d", esp_http_client_get_status_code(client),
-                 esp_http_client_get_content_length(client));
-        switch (esp_http_client_get_status_code(client)) {
+        switch (status_code) {
             case 200:
                 success = true;
                 break;
             case 401:
                 //ESP_LOGI(TAG, "Authorising with Duet");
-                wifi_duet_authorise(&resp_buff_gui_task);
+                wifi_duet_authorise(resp_buffer);
                 break;
             case 500:
                 ESP_LOGE(TAG, "Generic error getting status");
@@ -1040,43 +1039,50 @@ bool reprap_wifi_send_gcode(char *gcode) {
         ESP_LOGW(TAG, "Error sending GCode via WiFi: %s", esp_err_to_name(err));
         success = false;
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
     if (success) {
         if (duet_sbc_mode) {
             // TODO: Get reply
         } else {
-            reprap_wifi_get_rreply(&resp_buff_gui_task);
+            reprap_wifi_get_rreply(resp_buffer);
         }
     }
     return success;
 }
 
-void reprap_wifi_get_filelist(wifi_response_buff_t *resp_buffer, char *directory) {
-    char request_addr[MAX_REQ_ADDR_LENGTH];
-    char encoded_dir[strlen(directory) * 3];
+static void reprap_wifi_filelist_addr(char *request_addr, char *directory, int first) {
+    char encoded_dir[strlen(directory) * 3 + 1];
     url_encode((unsigned char *) directory, encoded_dir);
     if (duet_sbc_mode) {
         sprintf(request_addr, "%s/machine/directory/%s", rep_addr_resolved, encoded_dir);
     } else {
-        sprintf(request_addr, "%s/rr_filelist?dir=%s&first=0", rep_addr_resolved, encoded_dir);
+        sprintf(request_addr, "%s/rr_filelist?dir=%s&first=%i", rep_addr_resolved, encoded_dir, first);
     }
-    ESP_LOGI(TAG, "%s", request_addr);
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = REQUEST_TIMEOUT_MS,
-            .event_handler = http_event_handle,
-            .user_data = resp_buffer,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
+}
 
+/**
+ * Request one page of a directory listing via WiFi
+ * @param directory Directory on the printer
+ * @param first Index of the first entry to list. 0 for the first page
+ * @return Index of the first entry of the next page. 0 if the listing is complete or the request failed
+ */
+int reprap_wifi_get_filelist(wifi_response_buff_t *resp_buffer, char *directory, int first) {
+    char request_addr[MAX_REQ_ADDR_LENGTH];
+    reprap_wifi_filelist_addr(request_addr, directory, first);
+    ESP_LOGI(TAG, "%s", request_addr);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_MS, resp_buffer);
+    if (conn == NULL) return 0;
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
     if (err == ESP_OK) {
-        ESP_LOGI(TAG, "Got file list via WiFi %d", esp_http_client_get_content_length(client));
+        ESP_LOGI(TAG, "Got file list via WiFi %d", esp_http_client_get_content_length(conn->client));
+    }
+    http_pool_release(conn, err == ESP_OK);
 
-        switch (esp_http_client_get_status_code(client)) {
+    int next = 0;
+    if (err == ESP_OK) {
+        switch (status_code) {
             case 200:
-                process_reprap_filelist(resp_buffer->buffer);
+                next = process_reprap_filelist(resp_buffer->buffer);
                 break;
             case 401:
                 //ESP_LOGI(TAG, "Authorising with Duet");
@@ -1098,72 +1104,30 @@ void reprap_wifi_get_filelist(wifi_response_buff_t *resp_buffer, char *directory
     } else {
         ESP_LOGW(TAG, "Error getting file list via WiFi: %s", esp_err_to_name(err));
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
+    return next;
 }
 
 /**
- * Task that gets files list
+ * Task that gets all pages of a files list
  * @param params Char array describing path to directory on pritner
  */
 void reprap_wifi_get_filelist_task(void *params) {
     char *directory = params;
-    char request_addr[MAX_REQ_ADDR_LENGTH];
-    char encoded_dir[strlen(directory) * 3];
-    url_encode((unsigned char *) directory, encoded_dir);
-    if (duet_sbc_mode) {
-        sprintf(request_addr, "%s/machine/directory/%s", rep_addr_resolved, encoded_dir);
-    } else {
-        sprintf(request_addr, "%s/rr_filelist?dir=%s&first=0", rep_addr_resolved, encoded_dir);
-    }
     ESP_LOGD("FileListTask", "Unformatted: %s", directory);
-    ESP_LOGD("FileListTask", "Request: %s", request_addr);
     wifi_response_buff_t resp_buff_filelist_task;
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = REQUEST_TIMEOUT_MS,
-            .event_handler = http_event_handle,
-            .user_data = &resp_buff_filelist_task,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
-
-    if (err == ESP_OK) {
-        //ESP_LOGI(TAG, "Status = %d, content_length = %d", esp_http_client_get_status_code(client), esp_http_client_get_content_length(client));
-
-        switch (esp_http_client_get_status_code(client)) {
-            case 200:
-                process_reprap_filelist(resp_buff_filelist_task.buffer);
-                break;
-            case 401:
-                //ESP_LOGI(TAG, "Authorising with Duet");
-                wifi_duet_authorise(&resp_buff_filelist_task);
-                break;
-            case 500:
-                ESP_LOGE(TAG, "Generic error getting file list");
-                break;
-            case 502:
-                ESP_LOGE(TAG, "Incompatible DCS version");
-                break;
-            case 503:
-                ESP_LOGE(TAG, "Get filelist: DCS is unavailable");
-                duet_sbc_mode = false;
-                break;
-            default:
-                break;
-        }
-    } else {
-        ESP_LOGW(TAG, "Error getting file list via WiFi: %s", esp_err_to_name(err));
-    }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
+    http_pool_buff_init(&resp_buff_filelist_task);
+    int first = 0;
+    do {
+        first = reprap_wifi_get_filelist(&resp_buff_filelist_task, directory, first);
+    } while (first > 0);
+    http_pool_buff_free(&resp_buff_filelist_task);
     vTaskDelete(NULL);
 }
 
 void reprap_wifi_get_fileinfo(wifi_response_buff_t *resp_data, char *filename) {
     char request_addr[MAX_REQ_ADDR_LENGTH];
-    if (filename != NULL || strlen(filename) == 0) {
-        char encoded_filename[strlen(filename) * 3];
+    if (filename != NULL && strlen(filename) > 0) {
+        char encoded_filename[strlen(filename) * 3 + 1];
         url_encode((unsigned char *) filename, encoded_filename);
         if (duet_sbc_mode) {
             sprintf(request_addr, "%s/machine/fileinfo/%s", rep_addr_resolved, encoded_filename);
@@ -1178,21 +1142,20 @@ void reprap_wifi_get_fileinfo(wifi_response_buff_t *resp_data, char *filename) {
         }
     }
     ESP_LOGI(TAG, "Getting file info %s", request_addr);
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = REQUEST_TIMEOUT_FILEINFO_MS,
-            .event_handler = http_event_handle,
-            .user_data = resp_data,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_FILEINFO_MS, resp_data);
+    if (conn == NULL) return;
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    http_pool_release(conn, err == ESP_OK);
 
     if (err == ESP_OK) {
-        switch (esp_http_client_get_status_code(client)) {
+        switch (status_code) {
             case 200:
-                reppanel_parse_rr_fileinfo(resp_data->buffer, &reprap_model,JSON_BUFF_SIZE);
+                reppanel_parse_rr_fileinfo(resp_data->buffer, &reprap_work.model, resp_data->buf_pos + 1);
+                request_thumbnail(filename);
+                reppanel_snapshot_publish();
                 if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
-                    update_file_info_dialog_ui(&reprap_model);
+                    update_file_info_dialog_ui(&reprap_work.model);
                     xSemaphoreGive(xGuiSemaphore);
                 }
                 break;
@@ -1216,27 +1179,58 @@ void reprap_wifi_get_fileinfo(wifi_response_buff_t *resp_data, char *filename) {
     } else {
         ESP_LOGW(TAG, "Error getting file info via WiFi: %s", esp_err_to_name(err));
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
+}
+
+/**
+ * Request one chunk of a thumbnail via WiFi
+ * @param file G-code file containing the thumbnail
+ * @param offset Offset of the chunk as named by the file info or the previous chunk
+ */
+bool reprap_wifi_get_thumbnail(wifi_response_buff_t *resp_data, char *file, uint32_t offset) {
+    char request_addr[MAX_REQ_ADDR_LENGTH];
+    char encoded_file[strlen(file) * 3 + 1];
+    url_encode((unsigned char *) file, encoded_file);
+    snprintf(request_addr, sizeof(request_addr), "%s/rr_thumbnail?name=%s&offset=%u", rep_addr_resolved, encoded_file,
+             (unsigned) offset);
+    ESP_LOGD(TAG, "Getting thumbnail %s", request_addr);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_FILEINFO_MS, resp_data);
+    if (conn == NULL) return false;
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    http_pool_release(conn, err == ESP_OK);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Error getting thumbnail via WiFi: %s", esp_err_to_name(err));
+        return false;
+    }
+    switch (status_code) {
+        case 200:
+            return process_reprap_thumbnail(resp_data->buffer);
+        case 401:
+            wifi_duet_authorise(resp_data);
+            break;
+        default:
+            ESP_LOGW(TAG, "Thumbnail: Duet responded with %i", status_code);
+            break;
+    }
+    return false;
 }
 
 void reprap_wifi_get_config() {
     char request_addr[MAX_REQ_ADDR_LENGTH];
     sprintf(request_addr, "%s/rr_config", rep_addr_resolved);
     wifi_response_buff_t resp_buff_gui_task;
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = REQUEST_TIMEOUT_MS,
-            .event_handler = http_event_handle,
-            .user_data = &resp_buff_gui_task,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
+    http_pool_buff_init(&resp_buff_gui_task);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_MS, &resp_buff_gui_task);
+    if (conn == NULL) return;
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    http_pool_release(conn, err == ESP_OK);
 
     if (err == ESP_OK) {
         //ESP_LOGI(TAG, "Status = %d, content_length = %d", esp_http_client_get_status_code(client), esp_http_client_get_content_length(client));
     }
-    switch (esp_http_client_get_status_code(client)) {
+    switch (status_code) {
         case 200:
             // TODO process_reprap_config();
             break;
@@ -1247,8 +1241,7 @@ void reprap_wifi_get_config() {
         default:
             break;
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
+    http_pool_buff_free(&resp_buff_gui_task);
 }
 
 
@@ -1259,18 +1252,15 @@ void reprap_wifi_download(wifi_response_buff_t *response_buffer, char *file) {
     } else {
         sprintf(request_addr, "%s/rr_download?name=%s", rep_addr_resolved, file);
     }
-    esp_http_client_config_t config = {
-            .url = request_addr,
-            .timeout_ms = REQUEST_TIMEOUT_MS,
-            .event_handler = http_event_handle,
-            .user_data = response_buffer,
-    };
     ESP_LOGI(TAG, "Downloading %s", request_addr);
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
+    http_pool_conn_t *conn = http_pool_acquire(request_addr, REQUEST_TIMEOUT_MS, response_buffer);
+    if (conn == NULL) return;
+    esp_err_t err = http_pool_perform(conn);
+    int status_code = esp_http_client_get_status_code(conn->client);
+    http_pool_release(conn, err == ESP_OK);
 
     if (err == ESP_OK) {
-        switch (esp_http_client_get_status_code(client)) {
+        switch (status_code) {
             case 200:
                 if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 100) == pdTRUE) {
                     process_reprap_settings(response_buffer->buffer);
@@ -1297,32 +1287,52 @@ void reprap_wifi_download(wifi_response_buff_t *response_buffer, char *file) {
     } else {
         ESP_LOGW(TAG, "Error requesting RepRap status: %s", esp_err_to_name(err));
     }
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
 }
 
 /**
- * Send GCode to the printer. Blocking call. Call from UI thread!
+ * Queue a G-Code for the printer. Non blocking call. The request task sends it. Call from UI thread!
  * @param gcode_command
+ * @return false if not connected to the printer or the queue is full
  */
 bool reprap_send_gcode(char *gcode_command) {
-    if (rp_conn_stat == REPPANEL_WIFI_CONNECTED) {
-        if (reprap_wifi_send_gcode(gcode_command)) {
-#if defined(REPPANEL_ESP32_CONSOLE_ENABLED)
-            add_console_hist_entry(gcode_command, CONSOLE_TYPE_REPPANEL);
-            update_entries_ui();
+    if (rp_conn_stat != REPPANEL_WIFI_CONNECTED && rp_conn_stat != REPPANEL_UART_CONNECTED) return false;
+    return reppanel_gcode_queue_push(gcode_command, NULL, NULL);
+}
+
+/**
+ * rr_gcode takes the batch URL encoded as part of the request address. UART & SBC (POST body) take any length
+ */
+static size_t gcode_batch_max_encoded_len() {
+#ifdef CONFIG_REPPANEL_ESP32_WIFI_ENABLED
+    if (rp_conn_stat == REPPANEL_WIFI_CONNECTED && !duet_sbc_mode)
+        return MAX_REQ_ADDR_LENGTH - strlen(rep_addr_resolved) - strlen("/rr_gcode?gcode=") - 1;
 #endif
-            return true;
+    return SIZE_MAX;
+}
+
+/**
+ * Send all G-Codes queued by the GUI task. G-Codes queued in short succession are sent with a single request.
+ * Call from request task
+ */
+static void send_queued_gcodes(uart_response_buff_t *uart_receive_buff, wifi_response_buff_t *wifi_resp_buff) {
+    static gcode_batch_t batch;
+    bool sent = false;
+    while (reppanel_gcode_queue_pop_batch(&batch, gcode_batch_max_encoded_len())) {
+        bool success = false;
+        if (rp_conn_stat == REPPANEL_UART_CONNECTED) {
+            reprap_uart_send_gcode(uart_receive_buff, batch.gcode);
+            success = true;
+        }
+#ifdef CONFIG_REPPANEL_ESP32_WIFI_ENABLED
+        else if (rp_conn_stat == REPPANEL_WIFI_CONNECTED) {
+            success = reprap_wifi_send_gcode(wifi_resp_buff, batch.gcode);
         }
-    } else if (rp_conn_stat == REPPANEL_UART_CONNECTED) {
-        reprap_uart_send_gcode(gcode_command);
-#if defined(REPPANEL_ESP32_CONSOLE_ENABLED)
-        add_console_hist_entry(gcode_command, CONSOLE_TYPE_REPPANEL);
-        update_entries_ui();
 #endif
-        return true;
+        if (batch.num_cmds > 1) ESP_LOGI(TAG, "Sent %i G-Codes with one request", batch.num_cmds);
+        sent |= success;
+        reppanel_gcode_queue_batch_done(&batch, success);
     }
-    return false;
+    if (sent) reppanel_sched_trigger();   // show the effect of the G-Codes right away
 }
 
 /**
@@ -1350,6 +1360,7 @@ void request_macros(char *folder_path) {
         strncpy(request_file_path, folder_path, sizeof(request_file_path)-1);  // buffer path to request
         duet_request_macros = true;
     }
+    reppanel_sched_trigger();
 }
 
 /**
@@ -1362,10 +1373,11 @@ void request_fileinfo(char *file_name, wifi_response_buff_t *resp_buff) {
         reprap_wifi_get_fileinfo(resp_buff, file_name);
     } else if (rp_conn_stat == REPPANEL_UART_CONNECTED) {
         request_file_info = true;
-        if (file_name != NULL || strlen(file_name) == 0)
+        if (file_name != NULL && strlen(file_name) > 0)
             strncpy(request_file_path, file_name, sizeof(request_file_path)-1);
         else
             strcpy(request_file_path, "");
+        reppanel_sched_trigger();
     }
 }
 
@@ -1375,6 +1387,7 @@ void request_fileinfo(char *file_name, wifi_response_buff_t *resp_buff) {
 void trigger_request_fileinfo_curr_job() {
     request_file_info = true;
     strcpy(request_file_path, "");
+    reppanel_sched_trigger();
 }
 
 /**
@@ -1383,6 +1396,7 @@ void trigger_request_fileinfo_curr_job() {
 void trigger_request_fileinfo(char *filepath) {
     request_file_info = true;
     strncpy(request_file_path, filepath, sizeof(request_file_path) - 1);
+    reppanel_sched_trigger();
 }
 
 /**
@@ -1409,6 +1423,7 @@ void request_jobs(char *folder_path) {
         strncpy(request_file_path, folder_path, sizeof(request_file_path)-1);  // buffer path to request
         duet_request_jobs = true;   // set flag so task knows what to do in next iteration
     }
+    reppanel_sched_trigger();
 }
 
 void request_rrf_status(uart_response_buff_t *receive_buff, wifi_response_buff_t *resp_buff, int type, char *key,
@@ -1421,42 +1436,103 @@ void request_rrf_status(uart_response_buff_t *receive_buff, wifi_response_buff_t
     }
 }
 
-void request_rrf3_extended_info(uart_response_buff_t *uart_receive_buff, wifi_response_buff_t *wifi_resp_buff) {
-    if (reprap_model.reprap_seqs_changed.tools_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "tools", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.sensors_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "sensors", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.state_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "state", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.network_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "network", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.move_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "move", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.job_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "job", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.inputs_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "inputs", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.heat_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "heat", "d99vn");
-    }
-    if (reprap_model.reprap_seqs_changed.global_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "global", "d99vn");
+/**
+ * Request the remaining pages of the current jobs/macros listing. Only a few per call so status updates keep coming
+ */
+static void request_filelist_pages(uart_response_buff_t *receive_buff, wifi_response_buff_t *resp_buff) {
+    static char page_dir[MAX_LEN_DIRNAME];
+    int first = 0;
+    for (int i = 0; i < FILELIST_PAGES_PER_TICK; i++) {
+        if (!reppanel_filelist_next_page(page_dir, sizeof(page_dir), &first)) return;
+        if (rp_conn_stat == REPPANEL_UART_CONNECTED) {
+            reprap_uart_get_filelist(receive_buff, page_dir, first);
+        } else if (rp_conn_stat == REPPANEL_WIFI_CONNECTED) {
+            reprap_wifi_get_filelist(resp_buff, page_dir, first);
+        }
     }
-    if (reprap_model.reprap_seqs_changed.fans_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "fans", "d99vn");
+}
+
+/**
+ * Fetch the next chunks of a thumbnail in between status updates
+ */
+static void request_thumbnail_chunks(uart_response_buff_t *receive_buff, wifi_response_buff_t *resp_buff) {
+    static char thumbnail_file[sizeof(request_file_path)];
+    uint32_t offset = 0;
+    for (int i = 0; i < THUMBNAIL_CHUNKS_PER_TICK; i++) {
+        if (!reppanel_thumbnail_next_chunk(thumbnail_file, sizeof(thumbnail_file), &offset)) return;
+        bool ok = false;
+        if (rp_conn_stat == REPPANEL_UART_CONNECTED) {
+            ok = reprap_uart_get_thumbnail(receive_buff, thumbnail_file, offset);
+        } else if (rp_conn_stat == REPPANEL_WIFI_CONNECTED) {
+            ok = reprap_wifi_get_thumbnail(resp_buff, thumbnail_file, offset);
+        }
+        if (!ok) reppanel_thumbnail_chunk_failed();
     }
-    if (reprap_model.reprap_seqs_changed.network_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "network", "d99vn");
+}
+
+static uint16_t rrf3_pending_seqs() {
+    reprap_seqs_changed_t *changed = &reprap_work.model.reprap_seqs_changed;
+    uint16_t pending = 0;
+    if (changed->directories_changed) pending |= RRF3_SEQ_DIR;
+    if (changed->fans_changed) pending |= RRF3_SEQ_FANS;
+    if (changed->global_changed) pending |= RRF3_SEQ_GLOBAL;
+    if (changed->heat_changed) pending |= RRF3_SEQ_HEAT;
+    if (changed->inputs_changed) pending |= RRF3_SEQ_INPUTS;
+    if (changed->job_changed) pending |= RRF3_SEQ_JOB;
+    if (changed->move_changed) pending |= RRF3_SEQ_MOVE;
+    if (changed->network_changed) pending |= RRF3_SEQ_NETWORK;
+    if (changed->sensors_changed) pending |= RRF3_SEQ_SENSORS;
+    if (changed->state_changed) pending |= RRF3_SEQ_STATE;
+    if (changed->tools_changed) pending |= RRF3_SEQ_TOOLS;
+    return pending;
+}
+
+/**
+ * Update all object model keys whose sequence number changed. Keys that changed together are merged into a single
+ * request for the whole model if the response can be streamed (WiFi). Otherwise at most
+ * RRF3_MAX_REQUESTS_PER_TICK keys are requested per call. The rest stays flagged and is requested next time
+ */
+void request_rrf3_extended_info(uart_response_buff_t *uart_receive_buff, wifi_response_buff_t *wifi_resp_buff) {
+    static const struct {
+        const char *key;
+        uint16_t seq;
+    } rrf3_keys[] = {
+            {"tools",       RRF3_SEQ_TOOLS},
+            {"sensors",     RRF3_SEQ_SENSORS},
+            {"state",       RRF3_SEQ_STATE},
+            {"network",     RRF3_SEQ_NETWORK},
+            {"move",        RRF3_SEQ_MOVE},
+            {"job",         RRF3_SEQ_JOB},
+            {"inputs",      RRF3_SEQ_INPUTS},
+            {"heat",        RRF3_SEQ_HEAT},
+            {"global",      RRF3_SEQ_GLOBAL},
+            {"fans",        RRF3_SEQ_FANS},
+            {"directories", RRF3_SEQ_DIR},
+    };
+    static const int num_keys = sizeof(rrf3_keys) / sizeof(rrf3_keys[0]);
+    static int next_key = 0;    // round robin so no key starves when the budget is used up
+
+    uint16_t pending = rrf3_pending_seqs();
+    int num_pending = 0;
+    for (int i = 0; i < num_keys; i++) {
+        if (pending & rrf3_keys[i].seq) num_pending++;
+    }
+    if (num_pending == 0) return;
+    // SBC always returns the whole model
+    if (rp_conn_stat != REPPANEL_UART_CONNECTED && (duet_sbc_mode || num_pending >= RRF3_FULL_MODEL_MIN_KEYS)) {
+        ESP_LOGD(TAG, "%i keys changed. Requesting whole object model", num_pending);
+        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "", "d99vn");
+        return;
     }
-    if (reprap_model.reprap_seqs_changed.directories_changed) {
-        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, "directories", "d99vn");
+    TickType_t start = xTaskGetTickCount();
+    int num_requests = 0;
+    for (int n = 0; n < num_keys && num_requests < RRF3_MAX_REQUESTS_PER_TICK; n++) {
+        int i = (next_key + n) % num_keys;
+        if (!(pending & rrf3_keys[i].seq)) continue;
+        if (num_requests > 0 && (xTaskGetTickCount() - start) >= pdMS_TO_TICKS(SCHED_STATUS_FAST_MS)) break;
+        request_rrf_status(uart_receive_buff, wifi_resp_buff, 2, (char *) rrf3_keys[i].key, "d99vn");
+        num_requests++;
+        next_key = (i + 1) % num_keys;
     }
 }
 
@@ -1478,21 +1554,40 @@ bool update_printer_addr() {
     return true;    // no resolving required. User entered IP directly
 }
 
+#ifdef CONFIG_REPPANEL_DUET_SBC_PUSH
+static rrf3_stream_parser_t sbc_parser;     // keeps heater & fan values in between object model patches
+
 /**
- * Called every 750ms
+ * Duet 3 + SBC: Apply the object model updates DSF pushed since the last call. Subscribes to them if not done yet
+ * @return true if DSF keeps the local model up to date & the status does not need to be polled
+ */
+static bool receive_sbc_updates() {
+    if (!duet_sbc_mode || reppanel_sbc_ws_failed()) {
+        reppanel_sbc_ws_stop();     // poll till the next attempt
+        if (!duet_sbc_mode) return false;
+    }
+    if (!reppanel_sbc_ws_running() && reppanel_sched_due(SCHED_JOB_SBC_SUBSCRIBE))
+        reppanel_sbc_ws_start(rep_addr_resolved, reprap_work.model.session_key);
+    while (reppanel_sbc_ws_receive(&sbc_parser, &reprap_work)) {
+        status_request_err_cnt = 0;
+        rp_conn_stat = REPPANEL_WIFI_CONNECTED;
+        process_reprap3_status(&sbc_parser);
+    }
+    return reppanel_sbc_ws_subscribed();
+}
+#endif
+
+/**
+ * Polls the printer. Polling rate adapts to the printer state. See reppanel_scheduler.h
  * @param task
  */
 void request_reprap_status_updates(void *params) {
-    TickType_t xLastWakeTime;
-    const TickType_t xFrequency = (500 / portTICK_PERIOD_MS);
-    xLastWakeTime = xTaskGetTickCount();
-    int i = 0, b = 0;
     UBaseType_t uxHighWaterMark;
 #if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
-    uart_response_buff_t *uart_receive_buff = heap_caps_malloc(MALLOC_CAP_SPIRAM, sizeof(uart_response_buff_t));
+    uart_response_buff_t *uart_receive_buff = heap_caps_malloc(sizeof(uart_response_buff_t), MALLOC_CAP_SPIRAM);
     if (uart_receive_buff == NULL) {
         ESP_LOGE(TAG, "Failed to allocate UART buffer in SPI-RAM");
-        uart_response_buff_t m_uart_receive_buff;
+        static uart_response_buff_t m_uart_receive_buff;
         uart_receive_buff = &m_uart_receive_buff;
     }
 #else
@@ -1500,31 +1595,35 @@ void request_reprap_status_updates(void *params) {
     uart_response_buff_t *uart_receive_buff = &m_uart_receive_buff;
 #endif
 #ifdef CONFIG_REPPANEL_ESP32_WIFI_ENABLED
-#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
-    wifi_response_buff_t *resp_buff_status_update_task = heap_caps_malloc(MALLOC_CAP_SPIRAM, sizeof(wifi_response_buff_t));
-    if (resp_buff_status_update_task == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate wifi response buffer in SPI-RAM");
-        wifi_response_buff_t m_resp_buff_status_update_task;
-        resp_buff_status_update_task = &m_resp_buff_status_update_task;
-    }
-#else
-    wifi_response_buff_t m_resp_buff_status_update_task;
+    wifi_response_buff_t m_resp_buff_status_update_task;    // buffer itself is allocated in SPI-RAM if available
     wifi_response_buff_t *resp_buff_status_update_task = &m_resp_buff_status_update_task;
+    http_pool_buff_init(resp_buff_status_update_task);
 #endif
-#endif
-    while (strlen(rep_addr) < 1) {  // wait till request addr is set
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
+    while (strlen(rep_addr) < 1 || !uart_inited) {  // wait till request addr is set and GUI task set up UART
+        vTaskDelay(pdMS_TO_TICKS(SCHED_STATUS_FAST_MS));
     }
+    reppanel_uart_probe_baud_rate();
+    reppanel_uart_txn_init(process_uart_text);
     strncpy(rep_addr_resolved, rep_addr, sizeof(rep_addr_resolved)-1);
     bool init_printer_addr_updated = false;
+    reppanel_sched_init();
     while (1) {
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        reppanel_sched_wait();
         uxHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-        ESP_LOGI(TAG, "%i high water mark free bytes", uxHighWaterMark);
+        ESP_LOGD(TAG, "%i high water mark free bytes", uxHighWaterMark);
+        if (reppanel_uart_baud_rate_pending()) {
+            reppanel_uart_txn_cancel_all();     // responses in flight were requested at the old rate
+            reppanel_uart_probe_baud_rate();
+        }
+#ifdef CONFIG_REPPANEL_ESP32_WIFI_ENABLED
+        send_queued_gcodes(uart_receive_buff, resp_buff_status_update_task);
+#else
+        send_queued_gcodes(uart_receive_buff, NULL);
+#endif
         if (rp_conn_stat == REPPANEL_UART_CONNECTED) {
             if (!got_duet_settings) {
                 reprap_uart_check_objmodel_support(uart_receive_buff);
-                if (reprap_model.api_level < 1) {  // RRF2
+                if (reprap_work.model.api_level < 1) {  // RRF2
 #ifdef CONFIG_REPPANEL_RRF2_SUPPORT
                     reprap_uart_download(uart_receive_buff, "0:/sys/dwc2settings.json");   // get dummy values
 #endif
@@ -1538,28 +1637,36 @@ void request_reprap_status_updates(void *params) {
                     request_rrf_status(uart_receive_buff, NULL, 2, "tools", "d99vn");
                 }
             }
-            if (!got_filaments) reprap_uart_get_filelist(uart_receive_buff, "0:/filaments");
+            if (!got_filaments) {
+                int first = 0;
+                do {
+                    first = reprap_uart_get_filelist(uart_receive_buff, "0:/filaments", first);
+                } while (first > 0);
+            }
             if (request_file_info) reprap_uart_get_file_info(uart_receive_buff);
-            if (duet_request_jobs) {
-                reprap_uart_get_filelist(uart_receive_buff, request_file_path);
+            if (duet_request_jobs || duet_request_macros) {
                 duet_request_jobs = false;
-            }
-            if (duet_request_macros) {
-                reprap_uart_get_filelist(uart_receive_buff, request_file_path);
                 duet_request_macros = false;
+                if (!show_cached_filelist(request_file_path))
+                    reprap_uart_get_filelist(uart_receive_buff, request_file_path, 0);
+            } else {
+                request_filelist_pages(uart_receive_buff, NULL);
             }
+            request_thumbnail_chunks(uart_receive_buff, NULL);
             if (!got_extended_status) request_rrf_status(uart_receive_buff, NULL, 3, "", "d99fn");
-            if (!job_running)
-                request_rrf_status(uart_receive_buff, NULL, 2, "", "d99fn");
-            else
-                request_rrf_status(uart_receive_buff, NULL, 4, "", "d99fn");
-            if (reprap_model.api_level > 0) {
-                request_rrf3_extended_info(uart_receive_buff, NULL);
+            if (reppanel_sched_due(SCHED_JOB_STATUS)) {
+                if (!reprap_work.job_running)
+                    request_rrf_status(uart_receive_buff, NULL, 2, "", "d99fn");
+                else
+                    request_rrf_status(uart_receive_buff, NULL, 4, "", "d99fn");
+                if (reprap_work.model.api_level > 0) {
+                    request_rrf3_extended_info(uart_receive_buff, NULL);
+                }
             }
-            if (i == 20) {
+            if (reppanel_sched_due(SCHED_JOB_EXTENDED_STATUS)) {
                 request_rrf_status(uart_receive_buff, NULL, 3, "", "d99fn");
-                i = 0;
-            } else { i++; }
+            }
+            reppanel_uart_txn_wait_all(uart_receive_buff);
         }
 #if defined(CONFIG_REPPANEL_ESP32_WIFI_ENABLED)
         else if (rp_conn_stat == REPPANEL_WIFI_CONNECTED ||
@@ -1567,7 +1674,7 @@ void request_reprap_status_updates(void *params) {
             if (init_printer_addr_updated) {
                 if (!got_duet_settings) {
                     wifi_duet_authorise(resp_buff_status_update_task);
-                    if (reprap_model.api_level < 1) {  // RRF2
+                    if (reprap_work.model.api_level < 1) {  // RRF2
 #ifdef CONFIG_REPPANEL_RRF2_SUPPORT
                         reprap_wifi_download(resp_buff_status_update_task, "0%3A%2Fsys%2Fdwc2settings.json");
 #endif
@@ -1581,8 +1688,13 @@ void request_reprap_status_updates(void *params) {
                         request_rrf_status(NULL, resp_buff_status_update_task, 2, "tools", "d99vn");
                     }
                 }
-                if (!got_filaments) reprap_wifi_get_filelist(resp_buff_status_update_task, "0:/filaments&first=0");
-                if (reprap_model.api_level < 1) {  // RRF2
+                if (!got_filaments) {
+                    int first = 0;
+                    do {
+                        first = reprap_wifi_get_filelist(resp_buff_status_update_task, "0:/filaments", first);
+                    } while (first > 0);
+                }
+                if (reprap_work.model.api_level < 1) {  // RRF2
                     if (!got_extended_status)
                         request_rrf_status(NULL, resp_buff_status_update_task, 2, "", "d99fn");
                 }
@@ -1590,57 +1702,65 @@ void request_reprap_status_updates(void *params) {
                     reprap_wifi_get_fileinfo(resp_buff_status_update_task, request_file_path);
                     request_file_info = false;
                 }
-                // for synchron request of jobs
-                if (duet_request_jobs) {
-                    reprap_wifi_get_filelist(resp_buff_status_update_task, request_file_path);
+                // for synchron request of jobs & macros. First page only
+                if (duet_request_jobs || duet_request_macros) {
                     duet_request_jobs = false;
-                }
-                // for synchron request of macros
-                if (duet_request_macros) {
-                    reprap_wifi_get_filelist(resp_buff_status_update_task, request_file_path);
                     duet_request_macros = false;
+                    if (!show_cached_filelist(request_file_path))
+                        reprap_wifi_get_filelist(resp_buff_status_update_task, request_file_path, 0);
+                } else {
+                    request_filelist_pages(NULL, resp_buff_status_update_task);
                 }
-                if (!job_running)
-                    request_rrf_status(NULL, resp_buff_status_update_task, 0, "", "d99fn");
-                else {
-                    request_rrf_status(NULL, resp_buff_status_update_task, 3, "", "d99fn");
-                    if (reprap_model.api_level < 1) { // RRF2 quick and dirty fix
-                        request_fileinfo(NULL, resp_buff_status_update_task);
+                request_thumbnail_chunks(NULL, resp_buff_status_update_task);
+#ifdef CONFIG_REPPANEL_DUET_SBC_PUSH
+                bool status_pushed = receive_sbc_updates();
+#else
+                bool status_pushed = false;
+#endif
+                if (!status_pushed && reppanel_sched_due(SCHED_JOB_STATUS)) {
+                    if (!reprap_work.job_running)
+                        request_rrf_status(NULL, resp_buff_status_update_task, 0, "", "d99fn");
+                    else {
+                        request_rrf_status(NULL, resp_buff_status_update_task, 3, "", "d99fn");
+                        if (reprap_work.model.api_level < 1) { // RRF2 quick and dirty fix
+                            request_fileinfo(NULL, resp_buff_status_update_task);
+                        }
+                    }
+//                    if (reprap_work.model.reprap_seqs_changed.reply_changed) {
+//                        reprap_wifi_get_rreply(&resp_buff_status_update_task);
+//                    }
+                    if (reprap_work.model.api_level >= 1) {
+                        request_rrf3_extended_info(NULL, resp_buff_status_update_task);
                     }
-                }
-//                if (reprap_model.reprap_seqs_changed.reply_changed) {
-//                    reprap_wifi_get_rreply(&resp_buff_status_update_task);
-//                }
-                if (reprap_model.api_level >= 1) {
-                    request_rrf3_extended_info(NULL, resp_buff_status_update_task);
                 }
 
-                if (i == 20) {
+                if (reppanel_sched_due(SCHED_JOB_UART_PROBE)) {
                     // Check if we got a UART connection
                     if (reppanel_is_uart_connected()) {
                         rp_conn_stat = REPPANEL_UART_CONNECTED;
-                        memset(resp_buff_status_update_task, 0, JSON_BUFF_SIZE);
+                        http_pool_buff_free(resp_buff_status_update_task);
+#ifdef CONFIG_REPPANEL_DUET_SBC_PUSH
+                        reppanel_sbc_ws_stop();
+#endif
                         if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 10) == pdTRUE) {
                             update_rep_panel_conn_status();
                             xSemaphoreGive(xGuiSemaphore);
                         }
                     }
-                    i = 0;
-                } else { i++; }
-                if (b == 100) {
+                }
+                if (reppanel_sched_due(SCHED_JOB_ADDR_REFRESH)) {
                     update_printer_addr();  // in case address has changed
-                    b = 0;
-                } else { b++; }
-            } else {
+                }
+            } else if (reppanel_sched_due(SCHED_JOB_STATUS)) {
                 init_printer_addr_updated = update_printer_addr();  // initial resolving
             }
         }
 #endif
-        else {
+        else if (reppanel_sched_due(SCHED_JOB_STATUS)) {
             if (reppanel_is_uart_connected()) {
                 rp_conn_stat = REPPANEL_UART_CONNECTED;
 #if defined(CONFIG_REPPANEL_ESP32_WIFI_ENABLED)
-                memset(resp_buff_status_update_task, 0, JSON_BUFF_SIZE);
+                http_pool_buff_free(resp_buff_status_update_task);
 #endif
                 if (xGuiSemaphore != NULL && xSemaphoreTake(xGuiSemaphore, (TickType_t) 10) == pdTRUE) {
                     update_rep_panel_conn_status();
@@ -6,12 +6,13 @@
 #define REPPANEL_ESP32_REPPANEL_REQUEST_H
 
 #define MAX_REQ_ADDR_LENGTH     (256 + 512)
-#define JSON_BUFF_SIZE          (1024 * 5)        // d2wc settings is > 2800 bytes
+#define JSON_BUFF_SIZE          (1024 * 5)        // initial size of WiFi response buffers. d2wc settings is > 2800 bytes
 #define UART_RESP_BUFF_SIZE     (1024 * 5)
 
 typedef struct {
-    char buffer[JSON_BUFF_SIZE];
+    char *buffer;       // grows with the response. See http_pool_buff_init() & http_pool_buff_free()
     int buf_pos;
+    int buf_size;
 } wifi_response_buff_t;
 
 typedef struct {
@@ -27,9 +28,11 @@ void reprap_wifi_get_config();
 
 void reprap_wifi_get_fileinfo(wifi_response_buff_t *resp_data, char *filename);
 
-void reprap_wifi_get_filelist(wifi_response_buff_t *resp_buffer, char *directory);
+int reprap_wifi_get_filelist(wifi_response_buff_t *resp_buffer, char *directory, int first);
 
-bool reprap_wifi_send_gcode(char *gcode);
+bool reprap_wifi_get_thumbnail(wifi_response_buff_t *resp_data, char *file, uint32_t offset);
+
+bool reprap_wifi_send_gcode(wifi_response_buff_t *resp_buffer, char *gcode);
 
 void request_macros(char *folder_path);
 
@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Duet 3 + SBC: /machine/status returns the whole object model on every request. Instead of polling it, RepPanel
+// subscribes to the WebSocket of DSF at /machine. DSF sends the whole object model first. Once we replied "OK\n" it
+// sends a JSON merge patch holding the values that changed since, as soon as something changes.
+// The WebSocket client passes the data to the request task through a stream buffer. The request task feeds it to the
+// streaming parser while it arrives, so neither the model nor a patch is ever held in RAM at once & reprap_work is only
+// written by the request task. A lost connection is not re-established here. The request task polls till the next
+// reppanel_sbc_ws_start() & gets the whole model again then.
+// Only used by the request task.
+//
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <esp_log.h>
+#include <esp_idf_version.h>
+#include <esp_websocket_client.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+
+#include "reppanel_sbc_ws.h"
+#include "reppanel_request.h"
+#include "reppanel_scheduler.h"
+#include "reppanel_helper.h"
+
+#ifdef CONFIG_REPPANEL_DUET_SBC_PUSH
+
+#define TAG "SbcWebSocket"
+
+#define WS_OPCODE_CONT  0x00
+#define WS_OPCODE_TEXT  0x01
+
+static esp_websocket_client_handle_t ws_client = NULL;
+static StreamBufferHandle_t ws_stream = NULL;
+static volatile bool ws_failed = false;     // connection lost or data dropped. Set by the WebSocket task
+static volatile bool ws_stopping = false;
+static bool ws_in_message = false;          // parser was started on the current message
+static bool ws_got_model = false;           // whole object model was received. All further messages are patches
+
+/**
+ * Runs in the task of the WebSocket client
+ */
+static void sbc_ws_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data) {
+    esp_websocket_event_data_t *data = (esp_websocket_event_data_t *) event_data;
+    switch (event_id) {
+        case WEBSOCKET_EVENT_CONNECTED:
+            ESP_LOGI(TAG, "Subscribed to object model updates");
+            break;
+        case WEBSOCKET_EVENT_DISCONNECTED:
+        case WEBSOCKET_EVENT_ERROR:
+            if (!ws_stopping) ESP_LOGW(TAG, "Lost connection to DSF");
+            ws_failed = true;
+            reppanel_sched_trigger();   // request task falls back to polling
+            break;
+        case WEBSOCKET_EVENT_DATA:
+            if (data->op_code != WS_OPCODE_TEXT && data->op_code != WS_OPCODE_CONT) break;    // ping, pong, close
+            if (data->data_len < 1 || ws_failed || ws_stopping) break;
+            if (xStreamBufferSend(ws_stream, data->data_ptr, data->data_len, pdMS_TO_TICKS(SBC_WS_SEND_TIMEOUT_MS))
+                != data->data_len) {
+                ESP_LOGW(TAG, "Request task did not take the object model update in time");
+                ws_failed = true;
+            }
+            reppanel_sched_trigger();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Connect to the WebSocket of DSF. Returns right away, the connection is set up by the WebSocket client
+ * @param addr Address of the SBC e.g. http://192.168.1.5
+ * @param session_key Key returned by /machine/connect. Empty string if there is none
+ * @return false if the client could not be started
+ */
+bool reppanel_sbc_ws_start(const char *addr, const char *session_key) {
+    if (ws_client != NULL) return true;
+    if (ws_stream == NULL) {
+        ws_stream = xStreamBufferCreate(SBC_WS_STREAM_SIZE, 1);
+        if (ws_stream == NULL) {
+            ESP_LOGE(TAG, "Failed to create stream buffer");
+            return false;
+        }
+    }
+    const char *scheme = "ws://";
+    const char *host = addr;
+    if (strncmp(addr, "http://", 7) == 0) {
+        host = addr + 7;
+    } else if (strncmp(addr, "https://", 8) == 0) {
+        host = addr + 8;
+        scheme = "wss://";
+    }
+    char uri[MAX_REQ_ADDR_LENGTH];
+    char encoded_key[strlen(session_key) * 3 + 1];
+    url_encode((unsigned char *) session_key, encoded_key);
+    if (snprintf(uri, sizeof(uri), "%s%s/machine%s%s", scheme, host, session_key[0] != '\0' ? "?sessionKey=" : "",
+                 encoded_key) >= sizeof(uri)) {
+        ESP_LOGE(TAG, "Printer address too long");
+        return false;
+    }
+    esp_websocket_client_config_t config = {
+            .uri = uri,
+            .buffer_size = SBC_WS_BUFF_SIZE,
+            .disable_auto_reconnect = true,
+    };
+    ws_failed = false;
+    ws_stopping = false;
+    ws_in_message = false;
+    ws_got_model = false;
+    ESP_LOGI(TAG, "Connecting to %s", uri);
+    ws_client = esp_websocket_client_init(&config);
+    if (ws_client == NULL) {
+        ESP_LOGE(TAG, "Failed to init WebSocket client");
+        return false;
+    }
+    esp_websocket_register_events(ws_client, WEBSOCKET_EVENT_ANY, sbc_ws_event_handler, NULL);
+    if (esp_websocket_client_start(ws_client) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start WebSocket client");
+        esp_websocket_client_destroy(ws_client);
+        ws_client = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Close the connection. Received data that was not parsed yet is dropped
+ */
+void reppanel_sbc_ws_stop() {
+    if (ws_client == NULL) return;
+    ws_stopping = true;
+    char discard[64];
+    while (xStreamBufferReceive(ws_stream, discard, sizeof(discard), 0) > 0);   // WebSocket task may wait for room
+    esp_websocket_client_destroy(ws_client);
+    ws_client = NULL;
+    xStreamBufferReset(ws_stream);
+}
+
+/**
+ * @return true if the client was started & not stopped yet. Connection might still be set up or already lost
+ */
+bool reppanel_sbc_ws_running() {
+    return ws_client != NULL;
+}
+
+/**
+ * @return true if the connection was lost or an update could not be parsed. Call reppanel_sbc_ws_stop()
+ */
+bool reppanel_sbc_ws_failed() {
+    return ws_client != NULL && ws_failed;
+}
+
+/**
+ * @return true if the whole object model was received & DSF keeps sending the changes
+ */
+bool reppanel_sbc_ws_subscribed() {
+    return ws_client != NULL && !ws_failed && ws_got_model && esp_websocket_client_is_connected(ws_client);
+}
+
+/**
+ * Parse the data received so far. Call from request task till it returns false
+ * @param parser Must not be used for anything else. Keeps values in between patches
+ * @param target Printer state to update. Usually reprap_work
+ * @return true if a message was complete. Apply it with rrf3_stream_end()
+ */
+bool reppanel_sbc_ws_receive(rrf3_stream_parser_t *parser, reprap_snapshot_t *target) {
+    static char chunk[SBC_WS_BUFF_SIZE];    // too large for the stack of the request task
+    if (ws_client == NULL || ws_failed) return false;
+    size_t len;
+    while ((len = xStreamBufferReceive(ws_stream, chunk, sizeof(chunk), 0)) > 0) {
+        if (!ws_in_message) {
+            if (ws_got_model)
+                rrf3_stream_begin_patch(parser, target);
+            else
+                rrf3_stream_begin(parser, target);
+            ws_in_message = true;
+        }
+        // DSF sends the next message after our "OK". So a chunk never holds the start of the next message
+        if (!rrf3_stream_feed(parser, chunk, (int) len)) {
+            ESP_LOGE(TAG, "Malformed object model update");
+            ws_failed = true;
+            return false;
+        }
+        if (rrf3_stream_complete(parser)) {
+            ws_in_message = false;
+            ws_got_model = true;
+#if ESP_IDF_VERSION_MAJOR == 4 && ESP_IDF_VERSION_MINOR == 0
+            int sent = esp_websocket_client_send(ws_client, "OK\n", 3, pdMS_TO_TICKS(SBC_WS_SEND_TIMEOUT_MS));
+#else
+            int sent = esp_websocket_client_send_text(ws_client, "OK\n", 3, pdMS_TO_TICKS(SBC_WS_SEND_TIMEOUT_MS));
+#endif
+            if (sent < 0) {
+                ESP_LOGW(TAG, "Failed to request the next object model update");
+                ws_failed = true;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
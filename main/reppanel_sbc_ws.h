@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_SBC_WS_H
+#define REPPANEL_ESP32_REPPANEL_SBC_WS_H
+
+#include <stdbool.h>
+#include "rrf3_stream_parser.h"
+#include "reppanel_snapshot.h"
+
+#define SBC_WS_BUFF_SIZE        1024                    // max. bytes per data event of the WebSocket client
+#define SBC_WS_STREAM_SIZE      (4 * SBC_WS_BUFF_SIZE)  // received data the request task did not parse yet
+#define SBC_WS_SEND_TIMEOUT_MS  5000    // WebSocket task waits this long for the request task to take the data
+
+bool reppanel_sbc_ws_start(const char *addr, const char *session_key);
+
+void reppanel_sbc_ws_stop();
+
+bool reppanel_sbc_ws_running();
+
+bool reppanel_sbc_ws_failed();
+
+bool reppanel_sbc_ws_subscribed();
+
+bool reppanel_sbc_ws_receive(rrf3_stream_parser_t *parser, reprap_snapshot_t *target);
+
+#endif //REPPANEL_ESP32_REPPANEL_SBC_WS_H
@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "reppanel.h"
+#include "rrf_objects.h"
+#include "reppanel_snapshot.h"
+#include "screen_saver.h"
+#include "reppanel_scheduler.h"
+
+static TaskHandle_t sched_task = NULL;
+static TickType_t sched_deadlines[SCHED_JOB_COUNT];
+static volatile TickType_t sched_boost_until = 0;
+
+static bool sched_tick_reached(TickType_t now, TickType_t tick) {
+    return (int32_t) (now - tick) >= 0;     // survives tick count overflow
+}
+
+static bool heater_ramping(int state, double current, double active, double standby) {
+    if (state == HEATER_ACTIVE) return fabs(active - current) > SCHED_HEATER_RAMPING_DELTA;
+    if (state == HEATER_STDBY) return fabs(standby - current) > SCHED_HEATER_RAMPING_DELTA;
+    return false;
+}
+
+static bool heaters_ramping() {
+    reprap_bed_t *bed = &reprap_work.bed;
+    if (heater_ramping(reprap_work.heater_states[0], bed->current_temp, bed->active_temp, bed->standby_temp))
+        return true;
+    for (int i = 0; i < reprap_work.model.num_tools && (i + 1) < MAX_NUM_TOOLS; i++) {
+        reprap_tool_t *tool = &reprap_work.tools[i];
+        if (heater_ramping(reprap_work.heater_states[i + 1], tool->current_temp, tool->active_temp,
+                           tool->standby_temp))
+            return true;
+    }
+    return false;
+}
+
+static TickType_t sched_status_period(TickType_t now) {
+    if (!sched_tick_reached(now, sched_boost_until)) return pdMS_TO_TICKS(SCHED_STATUS_FAST_MS);
+    if (screen_saver_active) return pdMS_TO_TICKS(SCHED_STATUS_SLEEP_MS);
+    if (reprap_work.job_running || heaters_ramping()) return pdMS_TO_TICKS(SCHED_STATUS_FAST_MS);
+    return pdMS_TO_TICKS(SCHED_STATUS_IDLE_MS);
+}
+
+static TickType_t sched_period(reppanel_sched_job_t job, TickType_t now) {
+    switch (job) {
+        case SCHED_JOB_STATUS:
+            return sched_status_period(now);
+        case SCHED_JOB_EXTENDED_STATUS:
+            return pdMS_TO_TICKS(SCHED_EXTENDED_STATUS_MS);
+        case SCHED_JOB_UART_PROBE:
+            return pdMS_TO_TICKS(SCHED_UART_PROBE_MS);
+        case SCHED_JOB_SBC_SUBSCRIBE:
+            return pdMS_TO_TICKS(SCHED_SBC_SUBSCRIBE_MS);
+        case SCHED_JOB_ADDR_REFRESH:
+        default:
+            return pdMS_TO_TICKS(SCHED_ADDR_REFRESH_MS);
+    }
+}
+
+/**
+ * Must be called by the task that polls the printer. Status is due right away, all other jobs after one period
+ */
+void reppanel_sched_init() {
+    TickType_t now = xTaskGetTickCount();
+    for (int i = 0; i < SCHED_JOB_COUNT; i++) {
+        sched_deadlines[i] = now + sched_period(i, now);
+    }
+    sched_deadlines[SCHED_JOB_STATUS] = now;
+    sched_boost_until = now;
+    sched_task = xTaskGetCurrentTaskHandle();
+}
+
+/**
+ * Block until the next job is due or reppanel_sched_trigger() was called.
+ * The status job must be checked every cycle. Overdue jobs that the caller currently does not check do not wake us
+ */
+void reppanel_sched_wait() {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t next = sched_deadlines[SCHED_JOB_STATUS];
+    for (int i = 0; i < SCHED_JOB_COUNT; i++) {
+        if (!sched_tick_reached(now, sched_deadlines[i]) && !sched_tick_reached(sched_deadlines[i], next))
+            next = sched_deadlines[i];
+    }
+    TickType_t wait = sched_tick_reached(now, next) ? 0 : next - now;
+    if (ulTaskNotifyTake(pdTRUE, wait) > 0) {
+        sched_deadlines[SCHED_JOB_STATUS] = xTaskGetTickCount();
+    }
+}
+
+/**
+ * Check if a job needs to run. Schedules the next run if so
+ * @return true if the job is due
+ */
+bool reppanel_sched_due(reppanel_sched_job_t job) {
+    TickType_t now = xTaskGetTickCount();
+    if (!sched_tick_reached(now, sched_deadlines[job])) return false;
+    sched_deadlines[job] = now + sched_period(job, now);
+    return true;
+}
+
+/**
+ * Poll the printer right away and keep polling fast for a while. Call after a G-Code was sent or a request
+ * was queued. Can be called from any task
+ */
+void reppanel_sched_trigger() {
+    sched_boost_until = xTaskGetTickCount() + pdMS_TO_TICKS(SCHED_BOOST_MS);
+    if (sched_task != NULL) xTaskNotifyGive(sched_task);
+}
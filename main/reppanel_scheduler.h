@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_SCHEDULER_H
+#define REPPANEL_ESP32_REPPANEL_SCHEDULER_H
+
+#include <stdbool.h>
+
+#define SCHED_STATUS_FAST_MS        500     // printing, heaters ramping or right after user input
+#define SCHED_STATUS_IDLE_MS        2000
+#define SCHED_STATUS_SLEEP_MS       5000    // screen saver is active
+#define SCHED_BOOST_MS              5000    // keep polling fast this long after a G-Code was sent
+#define SCHED_EXTENDED_STATUS_MS    10000
+#define SCHED_UART_PROBE_MS         10000   // check for a UART connection while connected via WiFi
+#define SCHED_ADDR_REFRESH_MS       50000   // resolve mDNS address of printer again
+#define SCHED_SBC_SUBSCRIBE_MS      10000   // Duet 3 + SBC: retry subscribing to object model updates
+#define SCHED_HEATER_RAMPING_DELTA  2.0     // [°C] heater counts as ramping if further away from its active temp
+
+typedef enum {
+    SCHED_JOB_STATUS,
+    SCHED_JOB_EXTENDED_STATUS,
+    SCHED_JOB_UART_PROBE,
+    SCHED_JOB_ADDR_REFRESH,
+    SCHED_JOB_SBC_SUBSCRIBE,
+    SCHED_JOB_COUNT
+} reppanel_sched_job_t;
+
+void reppanel_sched_init();
+
+void reppanel_sched_wait();
+
+bool reppanel_sched_due(reppanel_sched_job_t job);
+
+void reppanel_sched_trigger();
+
+#endif //REPPANEL_ESP32_REPPANEL_SCHEDULER_H
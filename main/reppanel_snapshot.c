@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Hands the printer state from the request task to the GUI task without tearing. The request task parses into
+// reprap_work and publishes a copy of it. The GUI task copies the latest published state into the globals it reads
+// (reprap_model, reprap_tools, ...). Three buffers are rotated so neither side ever waits for the other:
+// one is written by the request task, one is read by the GUI task and one holds the latest published state.
+//
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "reppanel_snapshot.h"
+#include "reppanel_temp_history.h"
+
+#define TAG             "Snapshot"
+#define SNAPSHOT_FRESH  0x80    // set in snap_ready if the GUI did not pick up the buffer yet
+#define SNAPSHOT_BUFFS  3
+
+reprap_snapshot_t reprap_work;
+
+static reprap_snapshot_t *snap_buffs = NULL;   // SNAPSHOT_BUFFS buffers. SPI-RAM if available
+static uint8_t snap_write = 0;      // owned by request task
+static uint8_t snap_read = 1;       // owned by GUI task
+static uint8_t snap_ready = 2;      // exchanged by both. Index of latest published buffer | SNAPSHOT_FRESH
+
+/**
+ * Call once before the request task is started
+ */
+void reppanel_snapshot_init() {
+    memset(&reprap_work, 0, sizeof(reprap_snapshot_t));
+    reprap_work.chamber.heater_indx = -1;
+    reprap_work.model.reprap_state.msg_box_seq = -1;
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+    if (snap_buffs == NULL)
+        snap_buffs = heap_caps_malloc(SNAPSHOT_BUFFS * sizeof(reprap_snapshot_t), MALLOC_CAP_SPIRAM);
+    if (snap_buffs == NULL) ESP_LOGW(TAG, "Failed to allocate snapshots in SPI-RAM");
+#endif
+    if (snap_buffs == NULL) snap_buffs = malloc(SNAPSHOT_BUFFS * sizeof(reprap_snapshot_t));
+    configASSERT(snap_buffs);
+    memset(snap_buffs, 0, SNAPSHOT_BUFFS * sizeof(reprap_snapshot_t));
+}
+
+/**
+ * Make the current state of reprap_work available to the GUI. Call from the request task after a response was
+ * parsed completely. Never blocks
+ */
+void reppanel_snapshot_publish() {
+    reprap_work.version++;
+    memcpy(&snap_buffs[snap_write], &reprap_work, sizeof(reprap_snapshot_t));
+    snap_write = __atomic_exchange_n(&snap_ready, snap_write | SNAPSHOT_FRESH, __ATOMIC_ACQ_REL) & ~SNAPSHOT_FRESH;
+}
+
+/**
+ * Temperatures are displayed with one decimal. Smaller changes do not need a redraw
+ */
+static bool temp_changed(double shown, double received) {
+    return lround(shown * 10) != lround(received * 10);
+}
+
+static bool heater_temps_changed(double shown_current, double shown_active, double shown_standby, double current,
+                                 double active, double standby) {
+    return temp_changed(shown_current, current) || temp_changed(shown_active, active) ||
+           temp_changed(shown_standby, standby);
+}
+
+/**
+ * Compare the new state against the one currently shown by the UI
+ * @return SNAPSHOT_DIRTY_* flags
+ */
+static uint16_t snapshot_diff(const reprap_snapshot_t *snap) {
+    uint16_t dirty = 0;
+    if (strncmp(reprap_model.reprap_state.status, snap->model.reprap_state.status, REPRAP_MAX_STATUS_LEN) != 0)
+        dirty |= SNAPSHOT_DIRTY_STATUS;
+    if (heater_temps_changed(reprap_bed.current_temp, reprap_bed.active_temp, reprap_bed.standby_temp,
+                             snap->bed.current_temp, snap->bed.active_temp, snap->bed.standby_temp))
+        dirty |= SNAPSHOT_DIRTY_BED_TEMPS;
+    if (reprap_model.num_tools != snap->model.num_tools) dirty |= SNAPSHOT_DIRTY_TOOLS;
+    for (int i = 0; i < snap->model.num_tools && i < MAX_NUM_TOOLS; i++) {
+        const reprap_tool_t *shown = &reprap_tools[i];
+        const reprap_tool_t *tool = &snap->tools[i];
+        if (heater_temps_changed(shown->current_temp, shown->active_temp, shown->standby_temp, tool->current_temp,
+                                 tool->active_temp, tool->standby_temp))
+            dirty |= SNAPSHOT_DIRTY_TOOL_TEMPS;
+        if (shown->number != tool->number || strncmp(shown->name, tool->name, MAX_TOOL_NAME_LEN) != 0)
+            dirty |= SNAPSHOT_DIRTY_TOOLS;
+    }
+    if (reprap_model.num_heaters != snap->model.num_heaters ||
+        memcmp(heater_states, snap->heater_states, sizeof(heater_states)) != 0)
+        dirty |= SNAPSHOT_DIRTY_HEATERS;
+    if (memcmp(&reprap_axes, &snap->axes, sizeof(reprap_axes_t)) != 0) dirty |= SNAPSHOT_DIRTY_AXES;
+    if (reprap_params.power != snap->params.power || reprap_params.fan != snap->params.fan)
+        dirty |= SNAPSHOT_DIRTY_PARAMS;
+    if (reprap_job_percent != snap->job_percent || job_running != snap->job_running ||
+        job_paused != snap->job_paused ||
+        memcmp(&reprap_model.reprap_job, &snap->model.reprap_job, sizeof(reprap_job_t)) != 0)
+        dirty |= SNAPSHOT_DIRTY_JOB;
+    // sticky: compared against the last box shown, so a box is not lost when the GUI skips a published buffer
+    if (snap->model.reprap_state.msg_seq != reprap_model.reprap_state.msg_seq) dirty |= SNAPSHOT_DIRTY_MSG;
+    return dirty;
+}
+
+/**
+ * Copy the latest published state into the globals read by the UI. Call from the GUI task while holding xGuiSemaphore
+ * @return SNAPSHOT_DIRTY_* flags of everything that changed. 0 if there is no new state or nothing changed
+ */
+uint16_t reppanel_snapshot_apply() {
+    if (!(__atomic_load_n(&snap_ready, __ATOMIC_ACQUIRE) & SNAPSHOT_FRESH)) return 0;
+    snap_read = __atomic_exchange_n(&snap_ready, snap_read, __ATOMIC_ACQ_REL) & ~SNAPSHOT_FRESH;
+    const reprap_snapshot_t *snap = &snap_buffs[snap_read];
+    uint16_t dirty = snapshot_diff(snap);
+    // memcpy keeps padding bytes identical so the memcmp() in snapshot_diff() only sees real changes
+    memcpy(&reprap_model, &snap->model, sizeof(reprap_model_t));
+    memcpy(reprap_tools, snap->tools, sizeof(reprap_tools));
+    memcpy(&reprap_bed, &snap->bed, sizeof(reprap_bed_t));
+    memcpy(&reprap_chamber, &snap->chamber, sizeof(reprap_chamber_t));
+    memcpy(&reprap_axes, &snap->axes, sizeof(reprap_axes_t));
+    memcpy(&reprap_params, &snap->params, sizeof(reprap_params_t));
+    memcpy(heater_states, snap->heater_states, sizeof(heater_states));
+    reprap_mcu_temp = snap->mcu_temp;
+    reprap_job_percent = snap->job_percent;
+    job_running = snap->job_running;
+    job_paused = snap->job_paused;
+    if (reppanel_temp_history_record(snap, xTaskGetTickCount())) dirty |= SNAPSHOT_DIRTY_TEMP_HISTORY;
+    return dirty;
+}
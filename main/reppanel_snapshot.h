@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_SNAPSHOT_H
+#define REPPANEL_ESP32_REPPANEL_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "reppanel.h"
+#include "rrf_objects.h"
+
+// Returned by reppanel_snapshot_apply(). Parts of the printer state that changed since the UI was last updated
+#define SNAPSHOT_DIRTY_STATUS       (1 << 0)    // printer status string
+#define SNAPSHOT_DIRTY_BED_TEMPS    (1 << 1)    // current, active & standby temp of bed
+#define SNAPSHOT_DIRTY_TOOL_TEMPS   (1 << 2)    // current, active & standby temp of any tool
+#define SNAPSHOT_DIRTY_TOOLS        (1 << 3)    // number of tools, tool names & numbers
+#define SNAPSHOT_DIRTY_HEATERS      (1 << 4)    // heater states
+#define SNAPSHOT_DIRTY_AXES         (1 << 5)    // position & homed state
+#define SNAPSHOT_DIRTY_PARAMS       (1 << 6)    // fan & ATX power
+#define SNAPSHOT_DIRTY_JOB          (1 << 7)    // job progress, times & file
+#define SNAPSHOT_DIRTY_MSG          (1 << 8)    // new message box
+#define SNAPSHOT_DIRTY_TEMP_HISTORY (1 << 9)    // samples were added to the temperature history
+
+// Complete printer state as received from the printer
+typedef struct {
+    uint32_t version;                   // incremented with every published snapshot
+    reprap_model_t model;
+    reprap_tool_t tools[MAX_NUM_TOOLS];
+    reprap_bed_t bed;
+    reprap_chamber_t chamber;
+    reprap_axes_t axes;
+    reprap_params_t params;
+    int heater_states[MAX_NUM_TOOLS];   // pos 0 is bed heater
+    double mcu_temp;
+    float job_percent;
+    bool job_running;
+    bool job_paused;
+} reprap_snapshot_t;
+
+// Working copy of the request task. Parsers write here. Never touch it from the GUI task
+extern reprap_snapshot_t reprap_work;
+
+void reppanel_snapshot_init();
+
+void reppanel_snapshot_publish();
+
+uint16_t reppanel_snapshot_apply();
+
+#endif //REPPANEL_ESP32_REPPANEL_SNAPSHOT_H
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Temperature history of bed, chamber & tools. Recorded by the GUI task whenever it picks up a new snapshot, so the
+// history is only ever touched by the GUI task. One sample every TEMP_HISTORY_SAMPLE_MS is stored as int16 tenths of a
+// degree in a ring buffer per heater. If no snapshot arrived for longer, the missed samples repeat the next value.
+// Min & max of the whole history are kept in monotonic queues of ring positions and the average as a running sum,
+// so neither needs a pass over the samples.
+//
+
+#include <string.h>
+#include <math.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#include "reppanel_temp_history.h"
+
+#define TAG "TempHistory"
+
+typedef struct {
+    int16_t samples[TEMP_HISTORY_LEN];  // [0.1°]
+    uint16_t min_q[TEMP_HISTORY_LEN];   // positions of samples with ascending values. Front is the minimum
+    uint16_t max_q[TEMP_HISTORY_LEN];   // positions of samples with descending values. Front is the maximum
+    uint16_t next;                      // position of the next sample
+    uint16_t count;
+    uint16_t min_front, min_len;
+    uint16_t max_front, max_len;
+    int32_t sum;
+} temp_history_t;
+
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+static temp_history_t *histories = NULL;   // TEMP_HISTORY_NUM rings. Too large for internal RAM, allocated in SPI-RAM
+#else
+static temp_history_t m_histories[TEMP_HISTORY_NUM];
+static temp_history_t *histories = m_histories;
+#endif
+static TickType_t last_sample;
+static bool recording = false;
+
+/**
+ * Call once before the GUI task is started. Without memory for the history nothing is recorded
+ */
+void reppanel_temp_history_init() {
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+    if (histories == NULL) histories = heap_caps_malloc(TEMP_HISTORY_NUM * sizeof(temp_history_t), MALLOC_CAP_SPIRAM);
+    if (histories == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate temperature history in SPI-RAM");
+        return;
+    }
+#endif
+    memset(histories, 0, TEMP_HISTORY_NUM * sizeof(temp_history_t));
+    recording = false;
+}
+
+static int16_t temp_to_deci(double temp) {
+    long deci = lround(temp * 10);
+    if (deci > INT16_MAX) return INT16_MAX;
+    if (deci < -INT16_MAX) return -INT16_MAX;
+    return (int16_t) deci;
+}
+
+static uint16_t ring_pos(uint16_t front, uint16_t offset) {
+    return (front + offset) % TEMP_HISTORY_LEN;
+}
+
+static void temp_history_push(temp_history_t *h, int16_t value) {
+    if (h->count == TEMP_HISTORY_LEN) {     // oldest sample is overwritten
+        h->sum -= h->samples[h->next];
+        if (h->min_len > 0 && h->min_q[h->min_front] == h->next) {
+            h->min_front = ring_pos(h->min_front, 1);
+            h->min_len--;
+        }
+        if (h->max_len > 0 && h->max_q[h->max_front] == h->next) {
+            h->max_front = ring_pos(h->max_front, 1);
+            h->max_len--;
+        }
+    } else {
+        h->count++;
+    }
+    h->samples[h->next] = value;
+    h->sum += value;
+    while (h->min_len > 0 && h->samples[h->min_q[ring_pos(h->min_front, h->min_len - 1)]] >= value) h->min_len--;
+    h->min_q[ring_pos(h->min_front, h->min_len++)] = h->next;
+    while (h->max_len > 0 && h->samples[h->max_q[ring_pos(h->max_front, h->max_len - 1)]] <= value) h->max_len--;
+    h->max_q[ring_pos(h->max_front, h->max_len++)] = h->next;
+    h->next = ring_pos(h->next, 1);
+}
+
+static void temp_history_add(int heater, double temp, uint32_t num_samples) {
+    int16_t value = temp_to_deci(temp);
+    for (uint32_t i = 0; i < num_samples; i++) temp_history_push(&histories[heater], value);
+}
+
+/**
+ * Add the temperatures of a snapshot once the next sample is due. Call from the GUI task
+ * @param now Current tick count
+ * @return true if samples were added
+ */
+bool reppanel_temp_history_record(const reprap_snapshot_t *snap, TickType_t now) {
+    if (histories == NULL) return false;
+    uint32_t num_samples = 1;
+    if (!recording) {
+        recording = true;
+        last_sample = now;
+    } else {
+        num_samples = (now - last_sample) / pdMS_TO_TICKS(TEMP_HISTORY_SAMPLE_MS);
+        if (num_samples == 0) return false;
+        last_sample += num_samples * pdMS_TO_TICKS(TEMP_HISTORY_SAMPLE_MS);
+        if (num_samples > TEMP_HISTORY_LEN) num_samples = TEMP_HISTORY_LEN;
+    }
+    if (snap->bed.heater_indx >= 0) temp_history_add(TEMP_HISTORY_BED, snap->bed.current_temp, num_samples);
+    if (snap->chamber.heater_indx >= 0)
+        temp_history_add(TEMP_HISTORY_CHAMBER, snap->chamber.current_temp, num_samples);
+    for (int i = 0; i < snap->model.num_tools && i < MAX_NUM_TOOLS; i++) {
+        if (snap->tools[i].heater_indx >= 0)
+            temp_history_add(TEMP_HISTORY_TOOL(i), snap->tools[i].current_temp, num_samples);
+    }
+    return true;
+}
+
+/**
+ * Min, max & average of the whole history
+ * @param heater TEMP_HISTORY_BED, TEMP_HISTORY_CHAMBER or TEMP_HISTORY_TOOL(indx)
+ * @return false if there are no samples of that heater
+ */
+bool reppanel_temp_history_stats(int heater, temp_history_stats_t *stats) {
+    if (histories == NULL || heater < 0 || heater >= TEMP_HISTORY_NUM || histories[heater].count == 0) return false;
+    const temp_history_t *h = &histories[heater];
+    stats->min = h->samples[h->min_q[h->min_front]] / 10.0;
+    stats->max = h->samples[h->max_q[h->max_front]] / 10.0;
+    stats->avg = (double) h->sum / h->count / 10.0;
+    stats->duration = h->count * (TEMP_HISTORY_SAMPLE_MS / 1000);
+    return true;
+}
+
+/**
+ * Downsample the whole history. Every point is the average of an equal share of the samples
+ * @param heater TEMP_HISTORY_BED, TEMP_HISTORY_CHAMBER or TEMP_HISTORY_TOOL(indx)
+ * @param points Receives the points [0.1°], oldest first
+ * @return Number of points written. Less than num_points if there are fewer samples
+ */
+int reppanel_temp_history_view(int heater, int16_t *points, int num_points) {
+    if (histories == NULL || heater < 0 || heater >= TEMP_HISTORY_NUM || num_points < 1) return 0;
+    const temp_history_t *h = &histories[heater];
+    if (h->count < num_points) num_points = h->count;
+    uint16_t oldest = ring_pos(h->next, TEMP_HISTORY_LEN - h->count);
+    uint32_t first = 0;
+    for (int i = 0; i < num_points; i++) {
+        uint32_t end = (uint32_t) h->count * (i + 1) / num_points;
+        int32_t sum = 0;
+        for (uint32_t j = first; j < end; j++) sum += h->samples[ring_pos(oldest, j)];
+        points[i] = (int16_t) (sum / (int32_t) (end - first));
+        first = end;
+    }
+    return num_points;
+}
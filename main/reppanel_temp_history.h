@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_TEMP_HISTORY_H
+#define REPPANEL_ESP32_REPPANEL_TEMP_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "reppanel_snapshot.h"
+
+#define TEMP_HISTORY_SAMPLE_MS      2000
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+#define TEMP_HISTORY_LEN            3600    // samples per heater. 2h. Allocated in SPI-RAM
+#else
+#define TEMP_HISTORY_LEN            150     // 5min
+#endif
+
+// Heaters with a history
+#define TEMP_HISTORY_BED            0
+#define TEMP_HISTORY_CHAMBER        1
+#define TEMP_HISTORY_TOOL(indx)     (2 + (indx))
+#define TEMP_HISTORY_NUM            (2 + MAX_NUM_TOOLS)
+
+typedef struct {
+    double min;
+    double max;
+    double avg;
+    uint32_t duration;      // [s] covered by the history
+} temp_history_stats_t;
+
+void reppanel_temp_history_init();
+
+bool reppanel_temp_history_record(const reprap_snapshot_t *snap, TickType_t now);
+
+bool reppanel_temp_history_stats(int heater, temp_history_stats_t *stats);
+
+int reppanel_temp_history_view(int heater, int16_t *points, int num_points);
+
+#endif //REPPANEL_ESP32_REPPANEL_TEMP_HISTORY_H
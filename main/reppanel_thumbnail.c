@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// The file info names the thumbnails a slicer embedded in a G-code file. RRF3.4+ returns their base64 data in chunks
+// (rr_thumbnail, M31.1). Chunks are base64 decoded as they arrive, so only the QOI data of one thumbnail is buffered.
+// Decoding the QOI image is left to the LVGL image decoder (reppanel_img_decoder.c) which decodes line by line while
+// drawing. Complete thumbnails are converted & kept in the flash cache (reppanel_thumbnail_cache.c), so they are not
+// fetched again.
+// The thumbnail being fetched is only touched by the request task. Once complete it is swapped with the shown one while
+// holding xGuiSemaphore.
+//
+
+#include <string.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <lvgl/lvgl.h>
+
+#include "reppanel_thumbnail.h"
+#include "reppanel_img_decoder.h"
+#include "reppanel_thumbnail_cache.h"
+#include "reppanel_helper.h"
+
+#define TAG "Thumbnail"
+
+typedef struct {
+    reppanel_thumbnail_key_t key;
+    uint8_t *data;                  // QOI image or cache file
+    uint32_t len;
+    uint32_t capacity;
+    lv_img_dsc_t dsc;               // image source pointing into data
+} thumbnail_buff_t;
+
+static thumbnail_buff_t pending;    // thumbnail being fetched
+static uint32_t pending_next;       // file offset of the next chunk. 0 if nothing is fetched
+static int pending_retries;
+static uint32_t b64_bits;           // chunks may end within a group of four base64 characters
+static int b64_num_bits;
+static thumbnail_buff_t shown;
+
+static void *thumbnail_realloc(void *ptr, size_t size) {
+    void *resized = NULL;
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+    resized = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+#endif
+    if (resized == NULL) resized = realloc(ptr, size);
+    if (resized == NULL) ESP_LOGW(TAG, "Could not allocate %u bytes for thumbnail", (unsigned) size);
+    return resized;
+}
+
+static bool thumbnail_reserve(thumbnail_buff_t *buff, uint32_t capacity) {
+    if (capacity <= buff->capacity) return true;
+    uint8_t *data = thumbnail_realloc(buff->data, capacity);
+    if (data == NULL) return false;
+    buff->data = data;
+    buff->capacity = capacity;
+    return true;
+}
+
+static bool thumbnail_matches(const thumbnail_buff_t *buff, const reppanel_thumbnail_key_t *key) {
+    return buff->key.info.offset == key->info.offset && buff->key.info.size == key->info.size &&
+           buff->key.file_size == key->file_size && buff->key.modified == key->modified &&
+           strcmp(buff->key.file, key->file) == 0;
+}
+
+static int base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;  // padding & line breaks
+}
+
+static bool thumbnail_append_base64(const char *data) {
+    for (; *data != '\0'; data++) {
+        int value = base64_value(*data);
+        if (value < 0) continue;
+        b64_bits = (b64_bits << 6) | value;
+        b64_num_bits += 6;
+        if (b64_num_bits >= 8) {
+            b64_num_bits -= 8;
+            if (pending.len >= pending.capacity) return false;
+            pending.data[pending.len++] = (b64_bits >> b64_num_bits) & 0xFF;
+        }
+    }
+    return true;
+}
+
+/**
+ * Get a thumbnail from the cache or start fetching it. Does nothing if it is already shown or being fetched
+ * @param file Path of the G-code file on the printer
+ * @param file_size Size of the G-code file
+ * @param modified Modification date of the G-code file. 0 if unknown
+ * @param info Thumbnail picked from the file info
+ * @return true if the thumbnail was read from the cache. Show it using reppanel_thumbnail_publish(). Otherwise it is
+ * fetched if needed. See reppanel_thumbnail_next_chunk()
+ */
+bool reppanel_thumbnail_request(const char *file, uint32_t file_size, time_t modified, const reprap_thumbnail_t *info) {
+#ifndef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+    return false;
+#endif
+    if (info->size == 0 || info->offset == 0) return false;
+    static reppanel_thumbnail_key_t key;
+    memset(&key, 0, sizeof(key));
+    strlcpy(key.file, file, sizeof(key.file));
+    key.file_size = file_size;
+    key.modified = modified;
+    key.info = *info;
+    if (thumbnail_matches(&shown, &key) || (pending_next > 0 && thumbnail_matches(&pending, &key)))
+        return false;
+    pending_next = 0;
+    pending.len = 0;
+    int32_t cached_size = reppanel_thumbnail_cache_find(&key);
+    if (cached_size > 0 && thumbnail_reserve(&pending, cached_size) &&
+        reppanel_thumbnail_cache_load(&key, pending.data, cached_size, &pending.dsc)) {
+        pending.key = key;
+        pending.len = cached_size;
+        ESP_LOGI(TAG, "Using cached %ix%i thumbnail of %s", info->width, info->height, file);
+        return true;
+    }
+    if (!thumbnail_reserve(&pending, info->size / 4 * 3 + 3)) return false;
+    pending.key = key;
+    pending_next = info->offset;
+    pending_retries = 0;
+    b64_bits = 0;
+    b64_num_bits = 0;
+    ESP_LOGI(TAG, "Fetching %ix%i thumbnail of %s", info->width, info->height, file);
+    return false;
+}
+
+/**
+ * Get the chunk to request next
+ * @param file Receives the path of the G-code file
+ * @param offset Receives the offset to request
+ * @return false if there is nothing to fetch
+ */
+bool reppanel_thumbnail_next_chunk(char *file, size_t file_len, uint32_t *offset) {
+    if (pending_next == 0) return false;
+    strlcpy(file, pending.key.file, file_len);
+    *offset = pending_next;
+    return true;
+}
+
+/**
+ * Add a chunk of thumbnail data as returned by the Duet
+ * @param offset Offset the chunk was requested for
+ * @param data base64 encoded data
+ * @param next Offset of the next chunk. 0 if this was the last one
+ * @return true once the thumbnail is complete & a valid QOI image. Show it using reppanel_thumbnail_publish()
+ */
+bool reppanel_thumbnail_add_chunk(uint32_t offset, const char *data, uint32_t next) {
+    if (pending_next == 0 || offset != pending_next) {
+        ESP_LOGW(TAG, "Dropping unexpected chunk at offset %u", (unsigned) offset);
+        return false;
+    }
+    if (!thumbnail_append_base64(data) || (next != 0 && next <= offset)) {
+        ESP_LOGW(TAG, "Invalid thumbnail data in %s", pending.key.file);
+        pending_next = 0;
+        pending.len = 0;
+        return false;
+    }
+    pending_retries = 0;
+    pending_next = next;
+    if (next != 0) return false;
+    qoi_stream_t header;
+    if (!qoi_stream_init(&header, pending.data, pending.len) || header.width != pending.key.info.width ||
+        header.height != pending.key.info.height) {
+        ESP_LOGW(TAG, "Thumbnail of %s is no valid QOI image", pending.key.file);
+        pending.len = 0;
+        return false;
+    }
+    pending.dsc.header.always_zero = 0;
+    pending.dsc.header.cf = header.channels == 4 ? LV_IMG_CF_RAW_ALPHA : LV_IMG_CF_RAW;
+    pending.dsc.header.w = header.width;
+    pending.dsc.header.h = header.height;
+    pending.dsc.data = pending.data;
+    pending.dsc.data_size = pending.len;
+    reppanel_thumbnail_cache_store(&pending.key, pending.data, pending.len);
+    return true;
+}
+
+void reppanel_thumbnail_chunk_failed() {
+    if (pending_next == 0) return;
+    if (++pending_retries >= THUMBNAIL_MAX_RETRIES) {
+        ESP_LOGW(TAG, "Giving up on thumbnail of %s", pending.key.file);
+        pending_next = 0;
+        pending.len = 0;
+    }
+}
+
+/**
+ * Show the completed or cached thumbnail instead of the current one. Call while holding xGuiSemaphore
+ * @return false if there is no completed thumbnail
+ */
+bool reppanel_thumbnail_publish() {
+    if (pending.len == 0 || pending_next != 0) return false;
+    thumbnail_buff_t previous = shown;
+    shown = pending;
+    pending = previous;
+    pending.len = 0;
+    lv_img_cache_invalidate_src(&shown.dsc);
+    return true;
+}
+
+/**
+ * Image source for lv_img_set_src(). Call from GUI task
+ * @param file Path of the G-code file. Paths relative to 0:/gcodes match as well
+ * @return NULL if there is no thumbnail of that file
+ */
+const void *reppanel_thumbnail_src(const char *file) {
+    if (shown.len == 0 || file == NULL || strlen(file) == 0 || !ends_with(shown.key.file, (char *) file)) return NULL;
+    return &shown.dsc;
+}
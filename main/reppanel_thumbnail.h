@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_THUMBNAIL_H
+#define REPPANEL_ESP32_REPPANEL_THUMBNAIL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include "rrf_objects.h"
+
+#define THUMBNAIL_MAX_WIDTH         160
+#define THUMBNAIL_MAX_HEIGHT        120
+#define THUMBNAIL_MAX_RETRIES       3       // give up on a thumbnail if a chunk fails that often
+#define THUMBNAIL_CHUNKS_PER_TICK   4       // chunks requested per iteration of the request task
+#if defined(CONFIG_SPIRAM_USE_CAPS_ALLOC) || defined(CONFIG_SPIRAM_USE_MALLOC)
+#define THUMBNAIL_MAX_DATA_SIZE     (1024 * 64)     // base64 encoded size of the largest thumbnail we fetch
+#else
+#define THUMBNAIL_MAX_DATA_SIZE     (1024 * 16)
+#endif
+
+// Identifies a thumbnail. A G-code file that was uploaded again has a different size or modification date
+typedef struct {
+    char file[MAX_LEN_DIRNAME + MAX_LEN_FILENAME + 1];
+    uint32_t file_size;
+    time_t modified;                // 0 if unknown
+    reprap_thumbnail_t info;
+} reppanel_thumbnail_key_t;
+
+bool reppanel_thumbnail_request(const char *file, uint32_t file_size, time_t modified, const reprap_thumbnail_t *info);
+
+bool reppanel_thumbnail_next_chunk(char *file, size_t file_len, uint32_t *offset);
+
+bool reppanel_thumbnail_add_chunk(uint32_t offset, const char *data, uint32_t next);
+
+void reppanel_thumbnail_chunk_failed();
+
+bool reppanel_thumbnail_publish();
+
+const void *reppanel_thumbnail_src(const char *file);
+
+#endif //REPPANEL_ESP32_REPPANEL_THUMBNAIL_H
@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Thumbnails fetched once are kept on the wear levelled FAT partition "thumbs". The file name is a hash of the G-code
+// file path, its size & modification date, so a G-code file that was uploaded again gets a new entry. Entries hold the
+// image already converted to lv_color_t (LV_IMG_CF_TRUE_COLOR, LV_IMG_CF_TRUE_COLOR_ALPHA). Showing a cached thumbnail
+// takes a single read of the file and LVGL draws it without any decoding.
+// Once the cache holds THUMBNAIL_CACHE_MAX_ENTRIES the entry written first is deleted. Only used by the request task.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <esp_log.h>
+
+#include "reppanel_thumbnail_cache.h"
+#include "reppanel_img_decoder.h"
+
+#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+#include <esp_vfs_fat.h>
+#endif
+
+#define TAG "ThumbnailCache"
+
+#define THUMBNAIL_CACHE_MAGIC       0x31435452      // "RTC1"
+#define THUMBNAIL_CACHE_PATH_LEN    (sizeof(THUMBNAIL_CACHE_PATH) + sizeof(((struct dirent *) 0)->d_name))
+
+// Start of every cache file. The converted image follows
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;                   // order the files were written in. The lowest is deleted first
+    reppanel_thumbnail_key_t key;   // tells apart keys with the same hash
+    lv_img_header_t img;
+} thumbnail_cache_header_t;
+
+static bool cache_mounted = false;
+static uint32_t cache_seq;          // of the next file written
+static int cache_entries;
+
+static uint32_t fnv1a_hash(uint32_t hash, const void *data, size_t len) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void cache_file_path(const reppanel_thumbnail_key_t *key, char *path, size_t path_len) {
+    int64_t modified = key->modified;
+    uint32_t hash = fnv1a_hash(2166136261u, key->file, strlen(key->file));
+    hash = fnv1a_hash(hash, &key->file_size, sizeof(key->file_size));
+    hash = fnv1a_hash(hash, &modified, sizeof(modified));
+    hash = fnv1a_hash(hash, &key->info.offset, sizeof(key->info.offset));
+    hash = fnv1a_hash(hash, &key->info.size, sizeof(key->info.size));
+    snprintf(path, path_len, THUMBNAIL_CACHE_PATH "/%08X.BIN", (unsigned) hash);
+}
+
+static bool cache_key_equal(const reppanel_thumbnail_key_t *a, const reppanel_thumbnail_key_t *b) {
+    return a->file_size == b->file_size && a->modified == b->modified && a->info.offset == b->info.offset &&
+           a->info.size == b->info.size && strcmp(a->file, b->file) == 0;
+}
+
+static uint32_t cache_px_size(const lv_img_header_t *img) {
+    return sizeof(lv_color_t) + (img->cf == LV_IMG_CF_TRUE_COLOR_ALPHA ? 1 : 0);
+}
+
+/**
+ * Count the entries & find the one written first
+ * @param oldest Receives the path of the oldest entry. Empty if there is none. May be NULL
+ */
+static int cache_scan(char *oldest, size_t oldest_len) {
+    static thumbnail_cache_header_t header;
+    char path[THUMBNAIL_CACHE_PATH_LEN];
+    uint32_t oldest_seq = UINT32_MAX;
+    int count = 0;
+    if (oldest != NULL) oldest[0] = '\0';
+    DIR *dir = opendir(THUMBNAIL_CACHE_PATH);
+    if (dir == NULL) return 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        snprintf(path, sizeof(path), THUMBNAIL_CACHE_PATH "/%s", entry->d_name);
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) continue;
+        bool valid = fread(&header, sizeof(header), 1, f) == 1 && header.magic == THUMBNAIL_CACHE_MAGIC;
+        fclose(f);
+        if (!valid) {
+            unlink(path);
+            continue;
+        }
+        count++;
+        if (header.seq >= cache_seq) cache_seq = header.seq + 1;
+        if (oldest != NULL && header.seq < oldest_seq) {
+            oldest_seq = header.seq;
+            strlcpy(oldest, path, oldest_len);
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static void cache_delete_oldest() {
+    char oldest[THUMBNAIL_CACHE_PATH_LEN];
+    cache_entries = cache_scan(oldest, sizeof(oldest));
+    if (strlen(oldest) == 0) return;
+    ESP_LOGI(TAG, "Deleting %s", oldest);
+    if (unlink(oldest) == 0) cache_entries--;
+}
+
+/**
+ * Mount the cache partition. Thumbnails are not cached in case the partition table has no "thumbs" partition
+ */
+void reppanel_thumbnail_cache_init() {
+#ifdef CONFIG_REPPANEL_ENABLE_QOI_THUMBNAIL_SUPPORT
+    static wl_handle_t wl_handle = WL_INVALID_HANDLE;
+    const esp_vfs_fat_mount_config_t mount_config = {
+            .format_if_mount_failed = true,
+            .max_files = 2,
+            .allocation_unit_size = CONFIG_WL_SECTOR_SIZE
+    };
+    esp_err_t err = esp_vfs_fat_spiflash_mount(THUMBNAIL_CACHE_PATH, THUMBNAIL_CACHE_PARTITION, &mount_config,
+                                               &wl_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Thumbnails are not cached. Could not mount partition %s: %s", THUMBNAIL_CACHE_PARTITION,
+                 esp_err_to_name(err));
+        return;
+    }
+    cache_mounted = true;
+    cache_entries = cache_scan(NULL, 0);
+    ESP_LOGI(TAG, "%i cached thumbnails", cache_entries);
+#endif
+}
+
+/**
+ * @return Size of the cache file holding the thumbnail. -1 if it is not cached
+ */
+int32_t reppanel_thumbnail_cache_find(const reppanel_thumbnail_key_t *key) {
+    if (!cache_mounted) return -1;
+    char path[THUMBNAIL_CACHE_PATH_LEN];
+    cache_file_path(key, path, sizeof(path));
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size <= (off_t) sizeof(thumbnail_cache_header_t)) return -1;
+    return (int32_t) st.st_size;
+}
+
+/**
+ * Read a cached thumbnail
+ * @param buff Receives the whole cache file. Must be aligned like the result of malloc()
+ * @param size Size as returned by reppanel_thumbnail_cache_find()
+ * @param dsc Set up to draw the image from buff
+ * @return false if the thumbnail is not cached
+ */
+bool reppanel_thumbnail_cache_load(const reppanel_thumbnail_key_t *key, uint8_t *buff, uint32_t size,
+                                   lv_img_dsc_t *dsc) {
+    if (!cache_mounted) return false;
+    char path[THUMBNAIL_CACHE_PATH_LEN];
+    cache_file_path(key, path, sizeof(path));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    size_t read = fread(buff, 1, size, f);
+    fclose(f);
+    const thumbnail_cache_header_t *header = (const thumbnail_cache_header_t *) buff;
+    if (read < sizeof(thumbnail_cache_header_t) || header->magic != THUMBNAIL_CACHE_MAGIC ||
+        !cache_key_equal(&header->key, key))
+        return false;
+    uint32_t data_size = header->img.w * header->img.h * cache_px_size(&header->img);
+    if (read != sizeof(thumbnail_cache_header_t) + data_size) {
+        ESP_LOGW(TAG, "Deleting incomplete %s", path);
+        unlink(path);
+        return false;
+    }
+    dsc->header = header->img;
+    dsc->data = buff + sizeof(thumbnail_cache_header_t);
+    dsc->data_size = data_size;
+    return true;
+}
+
+/**
+ * Convert a thumbnail to lv_color_t & cache it. Replaces an entry with the same hash
+ * @param qoi Thumbnail as fetched from the Duet
+ */
+void reppanel_thumbnail_cache_store(const reppanel_thumbnail_key_t *key, const uint8_t *qoi, uint32_t len) {
+    static qoi_stream_t stream;
+    static thumbnail_cache_header_t header;
+    static uint8_t line[THUMBNAIL_MAX_WIDTH * (sizeof(lv_color_t) + 1)];
+    if (!cache_mounted) return;
+    if (!qoi_stream_init(&stream, qoi, len) || stream.width != key->info.width || stream.height != key->info.height ||
+        stream.width > THUMBNAIL_MAX_WIDTH)
+        return;
+    memset(&header, 0, sizeof(header));
+    header.magic = THUMBNAIL_CACHE_MAGIC;
+    header.key = *key;
+    header.img.cf = stream.channels == 4 ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+    header.img.w = stream.width;
+    header.img.h = stream.height;
+
+    char path[THUMBNAIL_CACHE_PATH_LEN];
+    cache_file_path(key, path, sizeof(path));
+    struct stat st;
+    bool replaces = stat(path, &st) == 0;
+    while (!replaces && cache_entries >= THUMBNAIL_CACHE_MAX_ENTRIES) {
+        int entries = cache_entries;
+        cache_delete_oldest();
+        if (cache_entries >= entries) break;
+    }
+    header.seq = cache_seq++;
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Could not create %s", path);
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    uint32_t px_size = cache_px_size(&header.img);
+    uint8_t rgba[4];
+    for (uint32_t y = 0; ok && y < stream.height; y++) {
+        for (uint32_t x = 0; ok && x < stream.width; x++) {
+            ok = qoi_stream_read(&stream, rgba);
+            lv_color_t color = lv_color_make(rgba[0], rgba[1], rgba[2]);
+            memcpy(&line[x * px_size], &color, sizeof(lv_color_t));
+            if (px_size > sizeof(lv_color_t)) line[x * px_size + sizeof(lv_color_t)] = rgba[3];
+        }
+        ok = ok && fwrite(line, px_size, stream.width, f) == stream.width;
+    }
+    if (fclose(f) != 0) ok = false;
+    if (!ok) {
+        ESP_LOGW(TAG, "Could not cache thumbnail of %s", key->file);
+        unlink(path);
+        cache_delete_oldest();     // most likely the partition is full
+        return;
+    }
+    if (!replaces) cache_entries++;
+    ESP_LOGI(TAG, "Cached %ux%u thumbnail of %s", (unsigned) stream.width, (unsigned) stream.height, key->file);
+}
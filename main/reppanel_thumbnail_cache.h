@@ -0,0 +1,27 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_THUMBNAIL_CACHE_H
+#define REPPANEL_ESP32_REPPANEL_THUMBNAIL_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lvgl/lvgl.h>
+#include "reppanel_thumbnail.h"
+
+#define THUMBNAIL_CACHE_PARTITION   "thumbs"
+#define THUMBNAIL_CACHE_PATH        "/thumbs"
+#define THUMBNAIL_CACHE_MAX_ENTRIES 14      // a 160x120 RGB565 + alpha thumbnail takes 15 of the 4k sectors
+
+void reppanel_thumbnail_cache_init();
+
+int32_t reppanel_thumbnail_cache_find(const reppanel_thumbnail_key_t *key);
+
+bool reppanel_thumbnail_cache_load(const reppanel_thumbnail_key_t *key, uint8_t *buff, uint32_t size,
+                                   lv_img_dsc_t *dsc);
+
+void reppanel_thumbnail_cache_store(const reppanel_thumbnail_key_t *key, const uint8_t *qoi, uint32_t len);
+
+#endif //REPPANEL_ESP32_REPPANEL_THUMBNAIL_CACHE_H
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Requests to the Duet via UART do not wait for their response before the next one is sent. Up to
+// UART_TXN_MAX_IN_FLIGHT requests are kept in flight. Every received line is classified (object model, M408 status,
+// file list, file info, thumbnail chunk or text) and handed to the oldest request in flight expecting that kind of
+// response. Requests in front of it lost their response & are failed. Text nobody waits for (replies to G-Codes,
+// messages) goes to the text handler, so a G-Code written in between never desyncs the requests.
+// All bytes written count against UART_TXN_MAX_BYTES. Bytes of G-Codes without a response of their own are released
+// with the response to the next request, as the Duet handles lines in order.
+// Only used by the request task.
+//
+
+#include <string.h>
+#include <esp_log.h>
+
+#include "reppanel_uart_txn.h"
+#include "esp32_uart.h"
+
+#define TAG "UARTTxn"
+
+#define UART_TXN_MAX_UNMATCHED  8       // lines in a row nobody waits for till the oldest request is failed
+
+typedef struct {
+    uart_resp_type_t expect;
+    uart_txn_cb_t cb;
+    void *ctx;
+    int len;                    // bytes sent incl. the G-Codes without response written right before
+} uart_txn_t;
+
+static uart_txn_t in_flight[UART_TXN_MAX_IN_FLIGHT];   // oldest first
+static int num_in_flight = 0;
+static int bytes_in_flight = 0;
+static int bytes_unconfirmed = 0;   // G-Codes without response written after the newest request
+static int num_unmatched = 0;
+static uart_txn_cb_t text_handler = NULL;
+
+/**
+ * @param text_cb Gets text no request is waiting for. May be NULL
+ */
+void reppanel_uart_txn_init(uart_txn_cb_t text_cb) {
+    text_handler = text_cb;
+    num_in_flight = 0;
+    bytes_in_flight = 0;
+    bytes_unconfirmed = 0;
+    num_unmatched = 0;
+}
+
+static bool starts_with(const char *str, const char *prefix) {
+    return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+static uart_resp_type_t uart_txn_classify(const char *line) {
+    if (line[0] != '{' || starts_with(line, "{\"resp\":")) return UART_RESP_TEXT;
+    if (starts_with(line, "{\"key\":")) return UART_RESP_OBJECT_MODEL;
+    if (starts_with(line, "{\"status\":")) return UART_RESP_STATUS;
+    if (starts_with(line, "{\"dir\":")) return UART_RESP_FILELIST;
+    if (starts_with(line, "{\"fileName\":"))
+        return strstr(line, "\"data\":") != NULL ? UART_RESP_THUMBNAIL : UART_RESP_FILEINFO;
+    return UART_RESP_NONE;
+}
+
+/**
+ * M20 & M36 report errors the same way, e.g. {"err":2}. An error goes to the oldest of both requests
+ */
+static bool uart_txn_matches(const uart_txn_t *txn, uart_resp_type_t type, const char *line) {
+    if (starts_with(line, "{\"err\":"))
+        return txn->expect == UART_RESP_FILELIST || txn->expect == UART_RESP_FILEINFO;
+    return txn->expect == type;
+}
+
+static uart_txn_t uart_txn_pop() {
+    uart_txn_t txn = in_flight[0];
+    memmove(&in_flight[0], &in_flight[1], (num_in_flight - 1) * sizeof(uart_txn_t));
+    num_in_flight--;
+    bytes_in_flight -= txn.len;
+    return txn;
+}
+
+/**
+ * Remove the oldest requests in flight & let them know their response is missing
+ */
+static void uart_txn_fail(int num) {
+    for (int i = 0; i < num && num_in_flight > 0; i++) {
+        uart_txn_t txn = uart_txn_pop();
+        if (txn.cb != NULL) txn.cb(NULL, txn.ctx);
+    }
+}
+
+/**
+ * Read one line & hand it to the request waiting for it
+ * @return false if nothing was received in time
+ */
+static bool uart_txn_read(uart_response_buff_t *receive_buff) {
+    if (!reppanel_read_response(receive_buff)) {
+        uart_txn_fail(num_in_flight);
+        return false;
+    }
+    char *line = (char *) receive_buff->buffer;
+    uart_resp_type_t type = uart_txn_classify(line);
+    for (int i = 0; i < num_in_flight; i++) {
+        if (!uart_txn_matches(&in_flight[i], type, line)) continue;
+        if (i > 0) ESP_LOGW(TAG, "%i responses got lost", i);
+        uart_txn_fail(i);
+        uart_txn_t txn = uart_txn_pop();
+        num_unmatched = 0;
+        if (txn.cb != NULL) txn.cb(line, txn.ctx);
+        return true;
+    }
+    if (type == UART_RESP_TEXT) {
+        if (text_handler != NULL) text_handler(line, NULL);
+    } else {
+        ESP_LOGW(TAG, "Dropping response nobody waits for: %.40s", line);
+    }
+    if (num_in_flight > 0 && ++num_unmatched >= UART_TXN_MAX_UNMATCHED) {
+        ESP_LOGW(TAG, "No response to the oldest request");
+        uart_txn_fail(1);
+        num_unmatched = 0;
+    }
+    return true;
+}
+
+/**
+ * Send a request. Only blocks if too many requests or bytes are in flight already. Handles responses that are read
+ * meanwhile. With no request in flight there is nothing to wait for, so the G-Code is written right away
+ * @param expect Kind of response. UART_RESP_NONE to not wait for one
+ * @param cb Called with the response. May be NULL
+ */
+void reppanel_uart_txn_submit(uart_response_buff_t *receive_buff, const char *gcode, uart_resp_type_t expect,
+                              uart_txn_cb_t cb, void *ctx) {
+    int len = strlen(gcode) + 2;   // line end
+    while ((expect != UART_RESP_NONE && num_in_flight == UART_TXN_MAX_IN_FLIGHT) ||
+           (num_in_flight > 0 && bytes_in_flight + bytes_unconfirmed + len > UART_TXN_MAX_BYTES)) {
+        uart_txn_read(receive_buff);
+    }
+    if (expect == UART_RESP_NONE) {
+        bytes_unconfirmed += len;
+    } else {
+        len += bytes_unconfirmed;
+        bytes_unconfirmed = 0;
+        in_flight[num_in_flight++] = (uart_txn_t) {.expect = expect, .cb = cb, .ctx = ctx, .len = len};
+        bytes_in_flight += len;
+    }
+    reppanel_write_uart((char *) gcode, strlen(gcode));
+    ESP_LOGD(TAG, "Sent %s. %i in flight", gcode, num_in_flight);
+}
+
+/**
+ * Block till all requests in flight got their response or timed out
+ */
+void reppanel_uart_txn_wait_all(uart_response_buff_t *receive_buff) {
+    while (num_in_flight > 0) uart_txn_read(receive_buff);
+}
+
+/**
+ * Forget all requests in flight, e.g. before the connection is checked again. Their callbacks get NULL
+ */
+void reppanel_uart_txn_cancel_all() {
+    uart_txn_fail(num_in_flight);
+    bytes_unconfirmed = 0;
+}
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_UART_TXN_H
+#define REPPANEL_ESP32_REPPANEL_UART_TXN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "reppanel_request.h"
+
+#define UART_TXN_MAX_IN_FLIGHT  3       // requests sent before the response to the first one is read
+#define UART_TXN_MAX_BYTES      192     // of all requests in flight. Stays below the input buffer of the Duet
+
+typedef enum {
+    UART_RESP_NONE,             // G-Code without a response of its own
+    UART_RESP_OBJECT_MODEL,     // M409
+    UART_RESP_STATUS,           // M408
+    UART_RESP_FILELIST,         // M20 S2/S3
+    UART_RESP_FILEINFO,         // M36
+    UART_RESP_THUMBNAIL,        // M31.1
+    UART_RESP_TEXT,             // replies to G-Codes & messages the Duet sends on its own
+} uart_resp_type_t;
+
+/**
+ * Handles a response. Called by the request task
+ * @param line Response. NULL if it got lost or the Duet did not respond in time
+ */
+typedef void (*uart_txn_cb_t)(char *line, void *ctx);
+
+void reppanel_uart_txn_init(uart_txn_cb_t text_cb);
+
+void reppanel_uart_txn_submit(uart_response_buff_t *receive_buff, const char *gcode, uart_resp_type_t expect,
+                              uart_txn_cb_t cb, void *ctx);
+
+void reppanel_uart_txn_wait_all(uart_response_buff_t *receive_buff);
+
+void reppanel_uart_txn_cancel_all();
+
+#endif //REPPANEL_ESP32_REPPANEL_UART_TXN_H
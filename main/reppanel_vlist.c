@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// lv_list creates a button, a label and an image per entry. That does not scale to directories with hundreds of
+// files. This list only owns enough rows to fill its height. The scrollable part is sized for all entries and the rows
+// are moved to & re-bound to the entries that scrolled into view. Rows form a ring, so a row that stays visible is
+// not touched when scrolling.
+//
+
+#include <stdio.h>
+#include <lvgl/lvgl.h>
+#include <esp_log.h>
+
+#include "reppanel.h"
+#include "reppanel_vlist.h"
+
+#define TAG "VList"
+
+static lv_signal_cb_t ancestor_scrl_signal = NULL;
+
+static void vlist_bind(reppanel_vlist_t *vlist) {
+    if (vlist->row_cnt == 0) return;
+    lv_obj_t *scrl = lv_page_get_scrl(vlist->list);
+    int first = -lv_obj_get_y(scrl) / vlist->row_height;
+    if (first < 0) first = 0;
+    for (int i = first; i < first + vlist->row_cnt; i++) {
+        int row = i % vlist->row_cnt;
+        if (vlist->bound[row] == i) continue;
+        vlist->bound[row] = i;
+        if (i >= vlist->count) {
+            lv_obj_set_hidden(vlist->rows[row], true);
+            continue;
+        }
+        const char *symbol = "";
+        const char *text = "";
+        vlist->row_cb(i, &symbol, &text);
+        char row_txt[MAX_LEN_FILENAME + 8];
+        snprintf(row_txt, sizeof(row_txt), "%s  %s", symbol, text);
+        lv_label_set_text(vlist->labels[row], row_txt);
+        lv_obj_set_y(vlist->rows[row], i * vlist->row_height);
+        lv_obj_set_hidden(vlist->rows[row], false);
+    }
+}
+
+static lv_res_t vlist_scrl_signal(lv_obj_t *scrl, lv_signal_t sign, void *param) {
+    lv_res_t res = ancestor_scrl_signal(scrl, sign, param);
+    if (res != LV_RES_OK) return res;
+    if (sign == LV_SIGNAL_CORD_CHG) {
+        reppanel_vlist_t *vlist = (reppanel_vlist_t *) lv_obj_get_user_data(scrl);
+        if (vlist != NULL) vlist_bind(vlist);
+    }
+    return res;
+}
+
+static void vlist_row_event(lv_obj_t *row, lv_event_t event) {
+    reppanel_vlist_t *vlist = (reppanel_vlist_t *) lv_obj_get_user_data(lv_obj_get_parent(row));
+    if (vlist == NULL) return;
+    for (int i = 0; i < vlist->row_cnt; i++) {
+        if (vlist->rows[i] == row) {
+            if (vlist->bound[i] >= 0 && vlist->bound[i] < vlist->count) vlist->event_cb(vlist->bound[i], event);
+            return;
+        }
+    }
+}
+
+static lv_obj_t *vlist_add_row(reppanel_vlist_t *vlist, lv_obj_t *scrl, int row) {
+    lv_obj_t *btn = lv_btn_create(scrl, NULL);
+    lv_btn_set_style(btn, LV_BTN_STYLE_REL, lv_list_get_style(vlist->list, LV_LIST_STYLE_BTN_REL));
+    lv_btn_set_style(btn, LV_BTN_STYLE_PR, lv_list_get_style(vlist->list, LV_LIST_STYLE_BTN_PR));
+    lv_btn_set_style(btn, LV_BTN_STYLE_TGL_REL, lv_list_get_style(vlist->list, LV_LIST_STYLE_BTN_TGL_REL));
+    lv_btn_set_style(btn, LV_BTN_STYLE_TGL_PR, lv_list_get_style(vlist->list, LV_LIST_STYLE_BTN_TGL_PR));
+    lv_btn_set_style(btn, LV_BTN_STYLE_INA, lv_list_get_style(vlist->list, LV_LIST_STYLE_BTN_INA));
+    lv_btn_set_layout(btn, LV_LAYOUT_ROW_M);
+    lv_btn_set_fit2(btn, LV_FIT_NONE, LV_FIT_TIGHT);
+    lv_obj_set_width(btn, lv_page_get_fit_width(vlist->list));
+    lv_page_glue_obj(btn, true);    // dragging a row scrolls the list
+    lv_obj_set_event_cb(btn, vlist_row_event);
+    vlist->labels[row] = lv_label_create(btn, NULL);
+    lv_label_set_long_mode(vlist->labels[row], LV_LABEL_LONG_DOT);
+    lv_label_set_text(vlist->labels[row], LV_SYMBOL_FILE);
+    const lv_style_t *style = lv_btn_get_style(btn, LV_BTN_STYLE_REL);
+    lv_obj_set_width(vlist->labels[row],
+                     lv_obj_get_width(btn) - style->body.padding.left - style->body.padding.right);
+    lv_obj_set_hidden(btn, true);
+    vlist->bound[row] = -1;
+    return btn;
+}
+
+/**
+ * Create the list and its rows
+ * @param vlist Keeps the state of the list. Must stay valid as long as the list exists
+ * @param row_cb Provides the text of a row
+ * @param event_cb Called with the entry index for every event of a row
+ */
+void reppanel_vlist_create(reppanel_vlist_t *vlist, lv_obj_t *parent, lv_coord_t width, lv_coord_t height,
+                           reppanel_vlist_row_cb_t row_cb, reppanel_vlist_event_cb_t event_cb) {
+    vlist->count = 0;
+    vlist->row_cnt = 0;
+    vlist->row_cb = row_cb;
+    vlist->event_cb = event_cb;
+    vlist->list = lv_list_create(parent, NULL);     // for the looks of a list. No lv_list buttons are added
+    lv_obj_set_size(vlist->list, width, height);
+    lv_page_set_scrl_layout(vlist->list, LV_LAYOUT_OFF);
+    lv_page_set_scrl_fit2(vlist->list, LV_FIT_NONE, LV_FIT_NONE);
+    lv_obj_t *scrl = lv_page_get_scrl(vlist->list);
+    lv_obj_set_size(scrl, lv_page_get_fit_width(vlist->list), lv_page_get_fit_height(vlist->list));
+
+    vlist->rows[0] = vlist_add_row(vlist, scrl, 0);
+    vlist->row_height = lv_obj_get_height(vlist->rows[0]);
+    if (vlist->row_height < 1) vlist->row_height = 1;
+    int row_cnt = lv_page_get_fit_height(vlist->list) / vlist->row_height + 2;
+    if (row_cnt > VLIST_MAX_ROWS) {
+        ESP_LOGW(TAG, "List needs %i rows. Increase VLIST_MAX_ROWS", row_cnt);
+        row_cnt = VLIST_MAX_ROWS;
+    }
+    for (int i = 1; i < row_cnt; i++) vlist->rows[i] = vlist_add_row(vlist, scrl, i);
+    vlist->row_cnt = row_cnt;
+
+    if (ancestor_scrl_signal == NULL) ancestor_scrl_signal = lv_obj_get_signal_cb(scrl);
+    lv_obj_set_user_data(scrl, (lv_obj_user_data_t) vlist);
+    lv_obj_set_signal_cb(scrl, vlist_scrl_signal);
+}
+
+/**
+ * Set the number of entries. Rows that show an entry keep their text. See reppanel_vlist_refresh()
+ * Row positions are lv_coord_t (16 bit). Entries beyond reppanel_vlist_max_count() are not shown
+ */
+void reppanel_vlist_set_count(reppanel_vlist_t *vlist, int count) {
+    if (count > reppanel_vlist_max_count(vlist)) {
+        ESP_LOGW(TAG, "Only showing %i of %i entries", reppanel_vlist_max_count(vlist), count);
+        count = reppanel_vlist_max_count(vlist);
+    }
+    int old_count = vlist->count;
+    vlist->count = count;
+    lv_coord_t height = count * vlist->row_height;
+    if (height < lv_page_get_fit_height(vlist->list)) height = lv_page_get_fit_height(vlist->list);
+    for (int i = 0; i < vlist->row_cnt; i++) {
+        // rows past the old end are hidden & must be bound again once the list grew
+        if (vlist->bound[i] >= count || vlist->bound[i] >= old_count) vlist->bound[i] = -1;
+    }
+    lv_page_set_scrl_height(vlist->list, height);
+    vlist_bind(vlist);
+}
+
+/**
+ * @return Number of entries whose rows can still be positioned. Roughly 1000 for rows of 30 px
+ */
+int reppanel_vlist_max_count(const reppanel_vlist_t *vlist) {
+    return LV_COORD_MAX / vlist->row_height;
+}
+
+/**
+ * Bind all visible rows again. Call after the entries changed
+ */
+void reppanel_vlist_refresh(reppanel_vlist_t *vlist) {
+    for (int i = 0; i < vlist->row_cnt; i++) vlist->bound[i] = -1;
+    vlist_bind(vlist);
+}
+
+void reppanel_vlist_scroll_top(reppanel_vlist_t *vlist) {
+    lv_obj_set_y(lv_page_get_scrl(vlist->list), 0);
+    vlist_bind(vlist);
+}
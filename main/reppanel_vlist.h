@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_REPPANEL_VLIST_H
+#define REPPANEL_ESP32_REPPANEL_VLIST_H
+
+#include <lvgl/lvgl.h>
+
+#define VLIST_MAX_ROWS      16      // row objects per list. Must cover the visible height plus two rows
+
+/**
+ * Called when a row is bound to an entry
+ * @param index Entry to show
+ * @param symbol Receives the LV_SYMBOL_* shown in front of the text
+ * @param text Receives the text of the row. Copied by the list
+ */
+typedef void (*reppanel_vlist_row_cb_t)(int index, const char **symbol, const char **text);
+
+typedef void (*reppanel_vlist_event_cb_t)(int index, lv_event_t event);
+
+// List that only creates objects for the visible rows. Rows are re-bound to other entries while scrolling.
+// The scrollable part spans all entries in lv_coord_t (16 bit), so a list shows at most LV_COORD_MAX / row_height
+// entries. See reppanel_vlist_max_count()
+typedef struct {
+    lv_obj_t *list;
+    lv_obj_t *rows[VLIST_MAX_ROWS];
+    lv_obj_t *labels[VLIST_MAX_ROWS];
+    int bound[VLIST_MAX_ROWS];      // entry shown by the row. -1 if none
+    int row_cnt;
+    int count;                      // number of entries
+    lv_coord_t row_height;
+    reppanel_vlist_row_cb_t row_cb;
+    reppanel_vlist_event_cb_t event_cb;
+} reppanel_vlist_t;
+
+void reppanel_vlist_create(reppanel_vlist_t *vlist, lv_obj_t *parent, lv_coord_t width, lv_coord_t height,
+                           reppanel_vlist_row_cb_t row_cb, reppanel_vlist_event_cb_t event_cb);
+
+void reppanel_vlist_set_count(reppanel_vlist_t *vlist, int count);
+
+int reppanel_vlist_max_count(const reppanel_vlist_t *vlist);
+
+void reppanel_vlist_refresh(reppanel_vlist_t *vlist);
+
+void reppanel_vlist_scroll_top(reppanel_vlist_t *vlist);
+
+#endif //REPPANEL_ESP32_REPPANEL_VLIST_H
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Generated by tools/gen_rrf3_key_hash.py from rrf3_key_names[] in rrf3_stream_parser.c - do not edit
+//
+
+#ifndef REPPANEL_ESP32_RRF3_KEY_HASH_H
+#define REPPANEL_ESP32_RRF3_KEY_HASH_H
+
+#include <stdint.h>
+#include "rrf3_stream_parser.h"
+
+#define RRF3_KEY_HASH_SEED  1747u
+#define RRF3_KEY_HASH_MASK  255u
+
+static inline uint32_t rrf3_key_hash(const char *name) {
+    uint32_t h = RRF3_KEY_HASH_SEED;
+    for (; *name != '\0'; name++) h = (h ^ (uint8_t) *name) * 16777619u;
+    return h ^ (h >> 16);
+}
+
+// Hash slot to key. Every known key has a slot of its own. Candidates still need to be compared
+static const uint8_t rrf3_key_hash_table[RRF3_KEY_HASH_MASK + 1] = {
+        RRF3_KEY_LAYER, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_MODE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_CURRENT, RRF3_KEY_RESULT, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_SIMULATION,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_AXIS_CONTROLS, RRF3_KEY_NONE,
+        RRF3_KEY_FILE_POSITION, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_STANDBY, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_HEAT, RRF3_KEY_KEY, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_INPUTS, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_FILAMENT,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_BABYSTEP, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_RAW_EXTRUSION,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_FILE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_DIRECTORIES, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_MIN, RRF3_KEY_TIMEOUT, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_TIMES_LEFT, RRF3_KEY_NONE, RRF3_KEY_NUMBER, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_SENSORS, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_MCU_TEMP, RRF3_KEY_FANS, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_DURATION, RRF3_KEY_BED_HEATERS, RRF3_KEY_PRINT_TIME,
+        RRF3_KEY_NONE, RRF3_KEY_TITLE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_SIZE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_AXES, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_LETTER, RRF3_KEY_NONE, RRF3_KEY_NETWORK,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_MESSAGE,
+        RRF3_KEY_HEATERS, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_FIRST_LAYER_HEIGHT, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_ACTUAL_VALUE,
+        RRF3_KEY_NONE, RRF3_KEY_MACHINE_POSITION, RRF3_KEY_FILE_NAME, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_HOMED, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_CHAMBER_HEATERS, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_MAX, RRF3_KEY_HEIGHT,
+        RRF3_KEY_NONE, RRF3_KEY_LAYER_HEIGHT, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_STATE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_JOB,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NAME, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_ACTIVE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_REPLY, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_BOARDS, RRF3_KEY_MOVE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NUM_LAYERS, RRF3_KEY_NONE, RRF3_KEY_MESSAGE_BOX,
+        RRF3_KEY_SEQ, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_GLOBAL,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_FLAGS, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_TOOLS, RRF3_KEY_NONE, RRF3_KEY_NONE,
+        RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_NONE, RRF3_KEY_SLICER,
+        RRF3_KEY_NONE, RRF3_KEY_SEQS, RRF3_KEY_STATUS, RRF3_KEY_SIMULATED_TIME,
+};
+
+#endif //REPPANEL_ESP32_RRF3_KEY_HASH_H
@@ -0,0 +1,692 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Incremental parser for RRF3 object model responses (rr_model, M409 & SBC /machine/status).
+// Data can be fed in chunks of any size as it arrives. Values are written straight into the target snapshot without
+// building a JSON tree first. Values depending on other objects of the same response (heaters, fans) are buffered and
+// applied by rrf3_stream_end().
+// Object model patches pushed by DSF only hold the values that changed. Unchanged array elements are sent as {}.
+// In patch mode the heater & fan buffers are kept from the previous message, so only the sent values change.
+//
+
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <esp_log.h>
+#include "rrf3_stream_parser.h"
+#include "rrf3_key_hash.h"
+#include "reppanel.h"
+
+#define TAG "RRF3StreamParser"
+
+#define K(n)    (path[n].is_array ? RRF3_KEY_NONE : path[n].key)    // key of path element n
+#define I(n)    (path[n].is_array ? path[n].index : -1)             // array index of path element n
+
+enum {
+    LEX_VALUE,
+    LEX_VALUE_OR_END,
+    LEX_KEY,
+    LEX_KEY_OR_END,
+    LEX_COLON,
+    LEX_COMMA_OR_END,
+    LEX_STRING,
+    LEX_STRING_ESC,
+    LEX_STRING_UNICODE,
+    LEX_NUMBER,
+    LEX_LITERAL,
+    LEX_DONE
+};
+
+static const char *rrf3_key_names[RRF3_KEY_COUNT] = {
+        [RRF3_KEY_NONE] = "",
+        [RRF3_KEY_KEY] = "key",
+        [RRF3_KEY_FLAGS] = "flags",
+        [RRF3_KEY_RESULT] = "result",
+        [RRF3_KEY_BOARDS] = "boards",
+        [RRF3_KEY_DIRECTORIES] = "directories",
+        [RRF3_KEY_FANS] = "fans",
+        [RRF3_KEY_GLOBAL] = "global",
+        [RRF3_KEY_HEAT] = "heat",
+        [RRF3_KEY_INPUTS] = "inputs",
+        [RRF3_KEY_JOB] = "job",
+        [RRF3_KEY_MOVE] = "move",
+        [RRF3_KEY_NETWORK] = "network",
+        [RRF3_KEY_REPLY] = "reply",
+        [RRF3_KEY_SENSORS] = "sensors",
+        [RRF3_KEY_SEQS] = "seqs",
+        [RRF3_KEY_STATE] = "state",
+        [RRF3_KEY_TOOLS] = "tools",
+        [RRF3_KEY_MCU_TEMP] = "mcuTemp",
+        [RRF3_KEY_CURRENT] = "current",
+        [RRF3_KEY_ACTUAL_VALUE] = "actualValue",
+        [RRF3_KEY_BED_HEATERS] = "bedHeaters",
+        [RRF3_KEY_CHAMBER_HEATERS] = "chamberHeaters",
+        [RRF3_KEY_HEATERS] = "heaters",
+        [RRF3_KEY_ACTIVE] = "active",
+        [RRF3_KEY_STANDBY] = "standby",
+        [RRF3_KEY_NAME] = "name",
+        [RRF3_KEY_NUMBER] = "number",
+        [RRF3_KEY_DURATION] = "duration",
+        [RRF3_KEY_LAYER] = "layer",
+        [RRF3_KEY_FILE_POSITION] = "filePosition",
+        [RRF3_KEY_RAW_EXTRUSION] = "rawExtrusion",
+        [RRF3_KEY_TIMES_LEFT] = "timesLeft",
+        [RRF3_KEY_SIMULATION] = "simulation",
+        [RRF3_KEY_SLICER] = "slicer",
+        [RRF3_KEY_FILE] = "file",
+        [RRF3_KEY_SIZE] = "size",
+        [RRF3_KEY_NUM_LAYERS] = "numLayers",
+        [RRF3_KEY_HEIGHT] = "height",
+        [RRF3_KEY_FIRST_LAYER_HEIGHT] = "firstLayerHeight",
+        [RRF3_KEY_LAYER_HEIGHT] = "layerHeight",
+        [RRF3_KEY_FILE_NAME] = "fileName",
+        [RRF3_KEY_SIMULATED_TIME] = "simulatedTime",
+        [RRF3_KEY_PRINT_TIME] = "printTime",
+        [RRF3_KEY_FILAMENT] = "filament",
+        [RRF3_KEY_AXES] = "axes",
+        [RRF3_KEY_MACHINE_POSITION] = "machinePosition",
+        [RRF3_KEY_HOMED] = "homed",
+        [RRF3_KEY_LETTER] = "letter",
+        [RRF3_KEY_MIN] = "min",
+        [RRF3_KEY_MAX] = "max",
+        [RRF3_KEY_BABYSTEP] = "babystep",
+        [RRF3_KEY_STATUS] = "status",
+        [RRF3_KEY_MESSAGE_BOX] = "messageBox",
+        [RRF3_KEY_TITLE] = "title",
+        [RRF3_KEY_MESSAGE] = "message",
+        [RRF3_KEY_AXIS_CONTROLS] = "axisControls",
+        [RRF3_KEY_MODE] = "mode",
+        [RRF3_KEY_TIMEOUT] = "timeout",
+        [RRF3_KEY_SEQ] = "seq",
+};
+
+/**
+ * One hash and one compare per key. See tools/gen_rrf3_key_hash.py
+ */
+static uint8_t rrf3_lookup_key(const char *name) {
+    uint8_t key = rrf3_key_hash_table[rrf3_key_hash(name) & RRF3_KEY_HASH_MASK];
+    return strcmp(rrf3_key_names[key], name) == 0 ? key : RRF3_KEY_NONE;
+}
+
+static uint16_t rrf3_key_to_seq(uint8_t key) {
+    switch (key) {
+        case RRF3_KEY_BOARDS: return RRF3_SEQ_BOARDS;
+        case RRF3_KEY_DIRECTORIES: return RRF3_SEQ_DIR;
+        case RRF3_KEY_FANS: return RRF3_SEQ_FANS;
+        case RRF3_KEY_GLOBAL: return RRF3_SEQ_GLOBAL;
+        case RRF3_KEY_HEAT: return RRF3_SEQ_HEAT;
+        case RRF3_KEY_INPUTS: return RRF3_SEQ_INPUTS;
+        case RRF3_KEY_JOB: return RRF3_SEQ_JOB;
+        case RRF3_KEY_MOVE: return RRF3_SEQ_MOVE;
+        case RRF3_KEY_NETWORK: return RRF3_SEQ_NETWORK;
+        case RRF3_KEY_SENSORS: return RRF3_SEQ_SENSORS;
+        case RRF3_KEY_STATE: return RRF3_SEQ_STATE;
+        case RRF3_KEY_TOOLS: return RRF3_SEQ_TOOLS;
+        default: return 0;
+    }
+}
+
+static int rrf3_decode_heater_state(const char *state) {
+    switch (state[0]) {
+        case 'o': return HEATER_OFF;
+        case 'a': return HEATER_ACTIVE;
+        case 's': return HEATER_STDBY;
+        default: return HEATER_FAULT;
+    }
+}
+
+static void rrf3_update_seq(reprap_model_t *model, uint8_t key, uint16_t seq) {
+#define RRF3_UPDATE_SEQ(name) \
+    if (model->reprap_seqs.name != seq) { \
+        model->reprap_seqs.name = seq; \
+        model->reprap_seqs_changed.name##_changed = 1; \
+    }
+    switch (key) {
+        case RRF3_KEY_BOARDS: RRF3_UPDATE_SEQ(boards) break;
+        case RRF3_KEY_DIRECTORIES: RRF3_UPDATE_SEQ(directories) break;
+        case RRF3_KEY_FANS: RRF3_UPDATE_SEQ(fans) break;
+        case RRF3_KEY_GLOBAL: RRF3_UPDATE_SEQ(global) break;
+        case RRF3_KEY_HEAT: RRF3_UPDATE_SEQ(heat) break;
+        case RRF3_KEY_INPUTS: RRF3_UPDATE_SEQ(inputs) break;
+        case RRF3_KEY_JOB: RRF3_UPDATE_SEQ(job) break;
+        case RRF3_KEY_MOVE: RRF3_UPDATE_SEQ(move) break;
+        case RRF3_KEY_NETWORK: RRF3_UPDATE_SEQ(network) break;
+        case RRF3_KEY_REPLY: RRF3_UPDATE_SEQ(reply) break;
+        case RRF3_KEY_SENSORS: RRF3_UPDATE_SEQ(sensors) break;
+        case RRF3_KEY_STATE: RRF3_UPDATE_SEQ(state) break;
+        case RRF3_KEY_TOOLS: RRF3_UPDATE_SEQ(tools) break;
+        default: break;
+    }
+#undef RRF3_UPDATE_SEQ
+}
+
+/**
+ * job.file.* - same information as returned by rr_fileinfo
+ */
+static void rrf3_handle_job_file(rrf3_stream_parser_t *p, uint8_t key, rrf3_tok_t tok, double num) {
+    reprap_job_t *job = &p->target->model.reprap_job;
+    if (tok == RRF3_TOK_STRING) {
+        if (key == RRF3_KEY_FILE_NAME && p->token_len > 9)
+            strlcpy(job->file.fileName, &p->token[9], MAX_LEN_FILENAME);
+        return;
+    }
+    if (tok == RRF3_TOK_NULL && key == RRF3_KEY_SIMULATED_TIME) {
+        job->file.simulatedTime = 0;
+        return;
+    }
+    if (tok != RRF3_TOK_NUMBER) return;
+    switch (key) {
+        case RRF3_KEY_SIZE: job->file.size = (uint32_t) num; break;
+        case RRF3_KEY_NUM_LAYERS: job->file.numLayers = (uint16_t) num; break;
+        case RRF3_KEY_HEIGHT: job->file.height = (float) num; break;
+        case RRF3_KEY_FIRST_LAYER_HEIGHT: job->file.firstLayerHeight = num; break;
+        case RRF3_KEY_LAYER_HEIGHT: job->file.layerHeight = num; break;
+        case RRF3_KEY_SIMULATED_TIME: job->file.simulatedTime = (uint32_t) num; break;
+        case RRF3_KEY_PRINT_TIME: job->file.printTime = (uint32_t) num; break;
+        default: break;
+    }
+}
+
+/**
+ * Called for every scalar value of the response
+ * @param path Path to the value starting at the top level object model key e.g. heat.heaters[1].current
+ * @param len Number of elements in path
+ */
+static void rrf3_handle_value(rrf3_stream_parser_t *p, const rrf3_stream_level_t *path, int len, rrf3_tok_t tok) {
+    reprap_snapshot_t *snap = p->target;
+    double num = (tok == RRF3_TOK_NUMBER) ? strtod(p->token, NULL) : 0;
+    int i;
+    switch (K(0)) {
+        case RRF3_KEY_BOARDS:       // boards[0].mcuTemp.current
+            if (len == 4 && I(1) == 0 && K(2) == RRF3_KEY_MCU_TEMP && K(3) == RRF3_KEY_CURRENT &&
+                tok == RRF3_TOK_NUMBER)
+                snap->mcu_temp = num;
+            break;
+        case RRF3_KEY_FANS:         // fans[i].actualValue
+            i = I(1);
+            if (len == 3 && i >= 0 && i < RRF3_STREAM_MAX_FANS && K(2) == RRF3_KEY_ACTUAL_VALUE &&
+                tok == RRF3_TOK_NUMBER)
+                p->fans[i] = num;
+            break;
+        case RRF3_KEY_HEAT:
+            if (len == 3 && K(1) == RRF3_KEY_BED_HEATERS && I(2) == 0 && tok == RRF3_TOK_NUMBER) {
+                snap->bed.heater_indx = (int) num;     // only support one heater per bed
+            } else if (len == 3 && K(1) == RRF3_KEY_CHAMBER_HEATERS && I(2) == 0 && tok == RRF3_TOK_NUMBER) {
+                snap->chamber.heater_indx = (int) num;     // -1 if there is no chamber heater
+            } else if (len == 4 && K(1) == RRF3_KEY_HEATERS) {
+                i = I(2);
+                if (i < 0 || i >= RRF3_STREAM_MAX_HEATERS) break;
+                if (K(3) == RRF3_KEY_STATE && tok == RRF3_TOK_STRING) {
+                    p->heaters[i].state = rrf3_decode_heater_state(p->token);
+                } else if (tok == RRF3_TOK_NUMBER) {
+                    if (K(3) == RRF3_KEY_CURRENT) p->heaters[i].current = num;
+                    else if (K(3) == RRF3_KEY_ACTIVE) p->heaters[i].active = num;
+                    else if (K(3) == RRF3_KEY_STANDBY) p->heaters[i].standby = num;
+                }
+            }
+            break;
+        case RRF3_KEY_TOOLS:
+            i = I(1);
+            if (len < 3 || i < 0 || i >= MAX_NUM_TOOLS) break;
+            if (len == 3 && K(2) == RRF3_KEY_NAME && tok == RRF3_TOK_STRING) {
+                strlcpy(snap->tools[i].name, p->token, MAX_TOOL_NAME_LEN);
+            } else if (len == 3 && K(2) == RRF3_KEY_NUMBER && tok == RRF3_TOK_NUMBER) {
+                snap->tools[i].number = (int) num;
+            } else if (len == 4 && I(3) == 0 && tok == RRF3_TOK_NUMBER) {   // only first heater/fan per tool
+                if (K(2) == RRF3_KEY_HEATERS) snap->tools[i].heater_indx = (int) num;
+                else if (K(2) == RRF3_KEY_ACTIVE) snap->tools[i].active_temp = num;
+                else if (K(2) == RRF3_KEY_STANDBY) snap->tools[i].standby_temp = num;
+                else if (K(2) == RRF3_KEY_FANS) snap->tools[i].fans = (int) num;
+            }
+            break;
+        case RRF3_KEY_JOB:
+            if (len == 2 && (tok == RRF3_TOK_NUMBER || tok == RRF3_TOK_NULL)) {
+                switch (K(1)) {
+                    case RRF3_KEY_DURATION: snap->model.reprap_job.duration = (uint32_t) num; break;
+                    case RRF3_KEY_LAYER: snap->model.reprap_job.layer = (uint16_t) num; break;
+                    case RRF3_KEY_FILE_POSITION: snap->model.reprap_job.filePosition = (uint32_t) num; break;
+                    case RRF3_KEY_RAW_EXTRUSION: snap->model.reprap_job.rawExtrusion = num; break;
+                    default: break;
+                }
+            } else if (len == 3 && K(1) == RRF3_KEY_TIMES_LEFT && (tok == RRF3_TOK_NUMBER || tok == RRF3_TOK_NULL)) {
+                if (K(2) == RRF3_KEY_SIMULATION) snap->model.reprap_job.timesLeft.simulation = (uint32_t) num;
+                else if (K(2) == RRF3_KEY_SLICER) snap->model.reprap_job.timesLeft.slicer = (uint32_t) num;
+                else if (K(2) == RRF3_KEY_FILE) snap->model.reprap_job.timesLeft.file = (uint32_t) num;
+            } else if (len == 3 && K(1) == RRF3_KEY_FILE) {
+                rrf3_handle_job_file(p, K(2), tok, num);
+            } else if (len == 4 && K(1) == RRF3_KEY_FILE && K(2) == RRF3_KEY_FILAMENT && tok == RRF3_TOK_NUMBER) {
+                snap->model.reprap_job.file.overall_filament_usage += num;
+            }
+            break;
+        case RRF3_KEY_MOVE:         // move.axes[i].*
+            i = I(2);
+            if (len != 4 || K(1) != RRF3_KEY_AXES || i < 0 || i >= REPPANEL_RRF_MAX_AXES) break;
+            switch (K(3)) {
+                case RRF3_KEY_MACHINE_POSITION:
+                    if (tok == RRF3_TOK_NUMBER) snap->axes.axes[i] = num;
+                    break;
+                case RRF3_KEY_HOMED:
+                    snap->axes.homed[i] = (tok == RRF3_TOK_TRUE);
+                    break;
+                case RRF3_KEY_LETTER:
+                    if (tok == RRF3_TOK_STRING) snap->axes.letter[i] = p->token[0];
+                    break;
+                case RRF3_KEY_MIN:
+                    if (tok == RRF3_TOK_NUMBER) snap->axes.min[i] = num;
+                    break;
+                case RRF3_KEY_MAX:
+                    if (tok == RRF3_TOK_NUMBER) snap->axes.max[i] = num;
+                    break;
+                case RRF3_KEY_BABYSTEP:
+                    if (tok == RRF3_TOK_NUMBER) snap->axes.babystep[i] = num;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case RRF3_KEY_STATE:
+            if (len == 2 && K(1) == RRF3_KEY_STATUS && tok == RRF3_TOK_STRING) {
+                strlcpy(snap->model.reprap_state.status, p->token, REPRAP_MAX_STATUS_LEN);
+            } else if (len == 2 && K(1) == RRF3_KEY_MESSAGE_BOX && tok == RRF3_TOK_NULL) {
+                // box was closed. The next one is new even if it looks the same
+                reprap_state_t *state = &snap->model.reprap_state;
+                state->msg_box_title[0] = '\0';
+                state->msg_box_msg[0] = '\0';
+                state->msg_box_seq = -1;
+            } else if (len == 3 && K(1) == RRF3_KEY_MESSAGE_BOX) {
+                reprap_state_t *state = &snap->model.reprap_state;
+                if (K(2) == RRF3_KEY_TITLE && tok == RRF3_TOK_STRING) {
+                    if (strncmp(state->msg_box_title, p->token, REPRAP_MAX_LEN_MSG_TITLE - 1) != 0)
+                        p->msg_box_changed = true;
+                    strlcpy(state->msg_box_title, p->token, REPRAP_MAX_LEN_MSG_TITLE);
+                } else if (K(2) == RRF3_KEY_MESSAGE && tok == RRF3_TOK_STRING) {
+                    if (strncmp(state->msg_box_msg, p->token, REPRAP_MAX_DISPLAY_MSG_LEN - 1) != 0)
+                        p->msg_box_changed = true;
+                    strlcpy(state->msg_box_msg, p->token, REPRAP_MAX_DISPLAY_MSG_LEN);
+                } else if (tok == RRF3_TOK_NUMBER) {
+                    if (K(2) == RRF3_KEY_AXIS_CONTROLS) state->show_axis_controls = ((int) num) != 0;
+                    else if (K(2) == RRF3_KEY_TIMEOUT) state->timeout = (uint16_t) num;
+                    else if (K(2) == RRF3_KEY_SEQ) p->msg_box_seq = (int32_t) num;
+                    else if (K(2) == RRF3_KEY_MODE) {
+                        if (state->mode != (uint8_t) num) p->msg_box_changed = true;
+                        state->mode = (uint8_t) num;
+                    }
+                }
+            }
+            break;
+        case RRF3_KEY_SEQS:
+            if (len == 2 && tok == RRF3_TOK_NUMBER) rrf3_update_seq(&snap->model, K(1), (uint16_t) num);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Called when an object or array starts
+ * @param path Path to the container starting at the top level object model key
+ */
+static void rrf3_handle_begin(rrf3_stream_parser_t *p, const rrf3_stream_level_t *path, int len, bool is_array) {
+    reprap_snapshot_t *snap = p->target;
+    if (len == 2 && K(0) == RRF3_KEY_HEAT && K(1) == RRF3_KEY_HEATERS && is_array) {
+        if (!p->patch) memset(p->heaters, 0, sizeof(p->heaters));
+    } else if (len == 3 && K(0) == RRF3_KEY_JOB && K(1) == RRF3_KEY_FILE && K(2) == RRF3_KEY_FILAMENT) {
+        snap->model.reprap_job.file.overall_filament_usage = 0;
+    } else if (len == 2 && K(0) == RRF3_KEY_STATE && K(1) == RRF3_KEY_MESSAGE_BOX && !is_array) {
+        p->msg_box_changed = false;
+        p->msg_box_seq = -1;
+    }
+}
+
+/**
+ * Called when an object or array is closed
+ * @param count Number of elements in case of an array
+ */
+static void rrf3_handle_end(rrf3_stream_parser_t *p, const rrf3_stream_level_t *path, int len, bool is_array,
+                            int count) {
+    reprap_snapshot_t *snap = p->target;
+    if (len == 1 && K(0) == RRF3_KEY_FANS && is_array) {
+        p->num_fans = count;
+    } else if (len == 2 && K(0) == RRF3_KEY_HEAT && K(1) == RRF3_KEY_HEATERS && is_array) {
+        p->num_heaters = count;
+    } else if (len == 1 && K(0) == RRF3_KEY_TOOLS && is_array) {
+        snap->model.num_tools = count < MAX_NUM_TOOLS ? count : MAX_NUM_TOOLS;
+    } else if (len == 2 && K(0) == RRF3_KEY_STATE && K(1) == RRF3_KEY_MESSAGE_BOX && !is_array) {
+        // RRF sends the open box with every status. Only a new box is shown. Older RRF has no messageBox.seq
+        reprap_state_t *state = &snap->model.reprap_state;
+        bool new_box = p->msg_box_seq >= 0 ? p->msg_box_seq != state->msg_box_seq : p->msg_box_changed;
+        if (p->msg_box_seq >= 0) state->msg_box_seq = p->msg_box_seq;
+        if (new_box) state->msg_seq++;
+    } else if (len == 1 && K(0) == RRF3_KEY_JOB && !is_array) {
+        reprap_job_t *job = &snap->model.reprap_job;
+        if (job->file.overall_filament_usage > 0) {
+            snap->job_percent = (float) ((job->rawExtrusion / job->file.overall_filament_usage) * 100);
+        } else if (job->file.size > 0) {
+            snap->job_percent = ((float) job->filePosition / (float) job->file.size) * 100.0f;
+        }
+    }
+}
+
+static void rrf3_emit_value(rrf3_stream_parser_t *p, rrf3_tok_t tok) {
+    rrf3_stream_level_t *top = &p->stack[p->depth - 1];
+    if (p->depth == 1 && !top->is_array) {      // members of the response root
+        if (top->key == RRF3_KEY_KEY && tok == RRF3_TOK_STRING) {
+            p->root_key = rrf3_lookup_key(p->token);
+            return;
+        } else if (top->key == RRF3_KEY_FLAGS && tok == RRF3_TOK_STRING) {
+            p->verbose = strcmp(p->token, "d99vn") == 0;
+            return;
+        }
+    }
+    int len = p->depth - p->base;
+    if (len < 1) return;
+    const rrf3_stream_level_t *path = &p->stack[p->base];
+    p->seen |= rrf3_key_to_seq(K(0));
+    rrf3_handle_value(p, path, len, tok);
+}
+
+static void rrf3_begin_container(rrf3_stream_parser_t *p, bool is_array) {
+    if (p->depth >= RRF3_STREAM_MAX_DEPTH) {
+        ESP_LOGE(TAG, "Object model nesting too deep");
+        p->error = true;
+        return;
+    }
+    if (p->depth == 1 && !p->stack[0].is_array && p->stack[0].key == RRF3_KEY_RESULT) {
+        // rr_model/M409 response. Make "result" look like the requested key or skip it in case of a full query
+        p->wrapped = true;
+        if (p->root_key != RRF3_KEY_NONE)
+            p->stack[0].key = p->root_key;
+        else
+            p->base = 1;
+    }
+    int len = p->depth - p->base;
+    if (len >= 1) {
+        const rrf3_stream_level_t *path = &p->stack[p->base];
+        p->seen |= rrf3_key_to_seq(K(0));
+        rrf3_handle_begin(p, path, len, is_array);
+    }
+    rrf3_stream_level_t *level = &p->stack[p->depth++];
+    level->key = RRF3_KEY_NONE;
+    level->is_array = is_array;
+    level->index = -1;
+    p->lex_state = is_array ? LEX_VALUE_OR_END : LEX_KEY_OR_END;
+}
+
+static void rrf3_end_container(rrf3_stream_parser_t *p, bool is_array) {
+    if (p->depth < 1 || p->stack[p->depth - 1].is_array != is_array) {
+        p->error = true;
+        return;
+    }
+    rrf3_stream_level_t *level = &p->stack[p->depth - 1];
+    int len = p->depth - 1 - p->base;
+    if (len >= 1) rrf3_handle_end(p, &p->stack[p->base], len, is_array, level->index + 1);
+    p->depth--;
+    p->lex_state = p->depth == 0 ? LEX_DONE : LEX_COMMA_OR_END;
+}
+
+static void rrf3_token_append(rrf3_stream_parser_t *p, char c) {
+    if (p->token_len < RRF3_STREAM_MAX_TOKEN_LEN) {
+        p->token[p->token_len++] = c;
+        p->token[p->token_len] = '\0';
+    } else {
+        p->token_truncated = true;
+    }
+}
+
+static void rrf3_token_append_utf8(rrf3_stream_parser_t *p, uint16_t cp) {
+    if (cp < 0x80) {
+        rrf3_token_append(p, (char) cp);
+    } else if (cp < 0x800) {
+        rrf3_token_append(p, (char) (0xC0 | (cp >> 6)));
+        rrf3_token_append(p, (char) (0x80 | (cp & 0x3F)));
+    } else {
+        rrf3_token_append(p, (char) (0xE0 | (cp >> 12)));
+        rrf3_token_append(p, (char) (0x80 | ((cp >> 6) & 0x3F)));
+        rrf3_token_append(p, (char) (0x80 | (cp & 0x3F)));
+    }
+}
+
+static void rrf3_token_start(rrf3_stream_parser_t *p, uint8_t lex_state) {
+    p->token_len = 0;
+    p->token[0] = '\0';
+    p->token_truncated = false;
+    p->lex_state = lex_state;
+}
+
+/**
+ * Start of a new value within the current container
+ */
+static void rrf3_next_value(rrf3_stream_parser_t *p) {
+    if (p->depth > 0 && p->stack[p->depth - 1].is_array) p->stack[p->depth - 1].index++;
+}
+
+/**
+ * Process one character
+ * @return false if the character did not belong to the current token and must be processed again
+ */
+static bool rrf3_lex(rrf3_stream_parser_t *p, char c) {
+    switch (p->lex_state) {
+        case LEX_STRING:
+            if (c == '"') {
+                if (p->token_is_key) {
+                    p->stack[p->depth - 1].key = p->token_truncated ? RRF3_KEY_NONE : rrf3_lookup_key(p->token);
+                    p->lex_state = LEX_COLON;
+                } else {
+                    p->lex_state = LEX_COMMA_OR_END;
+                    rrf3_emit_value(p, RRF3_TOK_STRING);
+                }
+            } else if (c == '\\') {
+                p->lex_state = LEX_STRING_ESC;
+            } else {
+                rrf3_token_append(p, c);
+            }
+            return true;
+        case LEX_STRING_ESC:
+            p->lex_state = LEX_STRING;
+            switch (c) {
+                case 'n': rrf3_token_append(p, '\n'); break;
+                case 't': rrf3_token_append(p, '\t'); break;
+                case 'r': rrf3_token_append(p, '\r'); break;
+                case 'b': rrf3_token_append(p, '\b'); break;
+                case 'f': rrf3_token_append(p, '\f'); break;
+                case 'u':
+                    p->unicode_digits = 0;
+                    p->unicode_val = 0;
+                    p->lex_state = LEX_STRING_UNICODE;
+                    break;
+                default: rrf3_token_append(p, c); break;     // \" \\ \/
+            }
+            return true;
+        case LEX_STRING_UNICODE:
+            p->unicode_val <<= 4;
+            if (c >= '0' && c <= '9') p->unicode_val |= c - '0';
+            else if (c >= 'a' && c <= 'f') p->unicode_val |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') p->unicode_val |= c - 'A' + 10;
+            else p->error = true;
+            if (++p->unicode_digits == 4) {
+                rrf3_token_append_utf8(p, p->unicode_val);
+                p->lex_state = LEX_STRING;
+            }
+            return true;
+        case LEX_NUMBER:
+            if ((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E') {
+                rrf3_token_append(p, c);
+                return true;
+            }
+            p->lex_state = LEX_COMMA_OR_END;
+            rrf3_emit_value(p, RRF3_TOK_NUMBER);
+            return false;
+        case LEX_LITERAL:
+            if (c >= 'a' && c <= 'z') {
+                rrf3_token_append(p, c);
+                return true;
+            }
+            p->lex_state = LEX_COMMA_OR_END;
+            if (strcmp(p->token, "true") == 0) rrf3_emit_value(p, RRF3_TOK_TRUE);
+            else if (strcmp(p->token, "false") == 0) rrf3_emit_value(p, RRF3_TOK_FALSE);
+            else if (strcmp(p->token, "null") == 0) rrf3_emit_value(p, RRF3_TOK_NULL);
+            else p->error = true;
+            return false;
+        default:
+            break;
+    }
+    if (c == ' ' || c == '\n' || c == '\r' || c == '\t') return true;
+    switch (p->lex_state) {
+        case LEX_VALUE_OR_END:
+            if (c == ']') {
+                rrf3_end_container(p, true);
+                return true;
+            }
+            // fall through
+        case LEX_VALUE:
+            rrf3_next_value(p);
+            if (c == '{') {
+                rrf3_begin_container(p, false);
+            } else if (c == '[') {
+                rrf3_begin_container(p, true);
+            } else if (c == '"') {
+                p->token_is_key = false;
+                rrf3_token_start(p, LEX_STRING);
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                rrf3_token_start(p, LEX_NUMBER);
+                rrf3_token_append(p, c);
+            } else if (c >= 'a' && c <= 'z') {
+                rrf3_token_start(p, LEX_LITERAL);
+                rrf3_token_append(p, c);
+            } else {
+                p->error = true;
+            }
+            return true;
+        case LEX_KEY_OR_END:
+            if (c == '}') {
+                rrf3_end_container(p, false);
+                return true;
+            }
+            // fall through
+        case LEX_KEY:
+            if (c == '"') {
+                p->token_is_key = true;
+                rrf3_token_start(p, LEX_STRING);
+            } else {
+                p->error = true;
+            }
+            return true;
+        case LEX_COLON:
+            if (c == ':') p->lex_state = LEX_VALUE;
+            else p->error = true;
+            return true;
+        case LEX_COMMA_OR_END:
+            if (c == ',') {
+                p->lex_state = p->stack[p->depth - 1].is_array ? LEX_VALUE : LEX_KEY;
+            } else if (c == '}') {
+                rrf3_end_container(p, false);
+            } else if (c == ']') {
+                rrf3_end_container(p, true);
+            } else {
+                p->error = true;
+            }
+            return true;
+        case LEX_DONE:
+        default:
+            return true;    // ignore anything after the response e.g. line endings
+    }
+}
+
+/**
+ * Prepare parser for a new response
+ * @param target Printer state to update. Usually reprap_work
+ */
+void rrf3_stream_begin(rrf3_stream_parser_t *parser, reprap_snapshot_t *target) {
+    memset(parser, 0, sizeof(rrf3_stream_parser_t));
+    parser->target = target;
+    parser->lex_state = LEX_VALUE;
+    parser->num_heaters = -1;
+    parser->num_fans = -1;
+}
+
+/**
+ * Prepare parser for an object model patch. Heater & fan values of the previous messages are kept.
+ * The first message must be parsed with rrf3_stream_begin()
+ * @param target Printer state the previous messages were applied to
+ */
+void rrf3_stream_begin_patch(rrf3_stream_parser_t *parser, reprap_snapshot_t *target) {
+    memset(parser, 0, offsetof(rrf3_stream_parser_t, heaters));
+    parser->target = target;
+    parser->lex_state = LEX_VALUE;
+    parser->patch = true;
+}
+
+/**
+ * Feed the next part of the response
+ * @param data Chunk of the response. Does not need to be NULL terminated
+ * @param len Length of chunk
+ * @return false on malformed JSON. All further data will be ignored
+ */
+bool rrf3_stream_feed(rrf3_stream_parser_t *parser, const char *data, int len) {
+    for (int i = 0; i < len && !parser->error; i++) {
+        while (!rrf3_lex(parser, data[i]) && !parser->error);
+    }
+    return !parser->error;
+}
+
+/**
+ * @return true once the closing bracket of the response was fed
+ */
+bool rrf3_stream_complete(const rrf3_stream_parser_t *parser) {
+    return !parser->error && parser->lex_state == LEX_DONE;
+}
+
+/**
+ * Finish parsing. Applies heater & fan values to bed and tools
+ * @return true if a complete & valid response was parsed
+ */
+bool rrf3_stream_end(rrf3_stream_parser_t *parser) {
+    if (parser->lex_state == LEX_NUMBER) rrf3_lex(parser, ' ');     // response is a plain number
+    if (parser->error || parser->lex_state != LEX_DONE) {
+        ESP_LOGE(TAG, "Incomplete or malformed object model response");
+        return false;
+    }
+    reprap_snapshot_t *snap = parser->target;
+    if (parser->num_heaters >= 0) {
+        snap->model.num_heaters = parser->num_heaters;
+        int indx = snap->bed.heater_indx;
+        if (indx >= 0 && indx < parser->num_heaters && indx < RRF3_STREAM_MAX_HEATERS) {
+            snap->bed.active_temp = parser->heaters[indx].active;
+            snap->bed.standby_temp = parser->heaters[indx].standby;
+            snap->bed.current_temp = parser->heaters[indx].current;
+            snap->heater_states[0] = parser->heaters[indx].state;     // bed heater is always on index 0
+        }
+        for (int i = 0; i < snap->model.num_tools; i++) {
+            indx = snap->tools[i].heater_indx;
+            if (indx < 0 || indx >= parser->num_heaters || indx >= RRF3_STREAM_MAX_HEATERS) continue;
+            snap->tools[i].current_temp = parser->heaters[indx].current;
+            if ((i + 1) < MAX_NUM_TOOLS) snap->heater_states[i + 1] = parser->heaters[indx].state;
+        }
+        indx = snap->chamber.heater_indx;
+        if (indx >= 0 && indx < parser->num_heaters && indx < RRF3_STREAM_MAX_HEATERS)
+            snap->chamber.current_temp = parser->heaters[indx].current;
+    }
+    if (parser->num_fans >= 0) {
+        int indx = snap->tools[0].fans;
+        if (indx >= 0 && indx < parser->num_fans && indx < RRF3_STREAM_MAX_FANS)
+            snap->params.fan = (int16_t) (parser->fans[indx] * 100);
+    }
+    // Local model is in sync again for all objects that were queried verbosely
+    if (parser->verbose || !parser->wrapped) {
+        reprap_seqs_changed_t *changed = &snap->model.reprap_seqs_changed;
+        if (parser->seen & RRF3_SEQ_BOARDS) changed->boards_changed = 0;
+        if (parser->seen & RRF3_SEQ_DIR) changed->directories_changed = 0;
+        if (parser->seen & RRF3_SEQ_FANS) changed->fans_changed = 0;
+        if (parser->seen & RRF3_SEQ_GLOBAL) changed->global_changed = 0;
+        if (parser->seen & RRF3_SEQ_HEAT) changed->heat_changed = 0;
+        if (parser->seen & RRF3_SEQ_INPUTS) changed->inputs_changed = 0;
+        if (parser->seen & RRF3_SEQ_JOB) changed->job_changed = 0;
+        if (parser->seen & RRF3_SEQ_MOVE) changed->move_changed = 0;
+        if (parser->seen & RRF3_SEQ_NETWORK) changed->network_changed = 0;
+        if (parser->seen & RRF3_SEQ_SENSORS) changed->sensors_changed = 0;
+        if (parser->seen & RRF3_SEQ_STATE) changed->state_changed = 0;
+        if (parser->seen & RRF3_SEQ_TOOLS) changed->tools_changed = 0;
+    }
+    return true;
+}
@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+
+#ifndef REPPANEL_ESP32_RRF3_STREAM_PARSER_H
+#define REPPANEL_ESP32_RRF3_STREAM_PARSER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rrf_objects.h"
+#include "reppanel_snapshot.h"
+
+#define RRF3_STREAM_MAX_DEPTH       12
+#define RRF3_STREAM_MAX_TOKEN_LEN   REPRAP_MAX_DISPLAY_MSG_LEN  // longer strings get truncated
+#define RRF3_STREAM_MAX_HEATERS     12
+#define RRF3_STREAM_MAX_FANS        12
+
+// Keys of the object model we are interested in. All other keys are skipped.
+// Run tools/gen_rrf3_key_hash.py after changing the keys
+typedef enum {
+    RRF3_KEY_NONE = 0,
+    RRF3_KEY_KEY,
+    RRF3_KEY_FLAGS,
+    RRF3_KEY_RESULT,
+    RRF3_KEY_BOARDS,
+    RRF3_KEY_DIRECTORIES,
+    RRF3_KEY_FANS,
+    RRF3_KEY_GLOBAL,
+    RRF3_KEY_HEAT,
+    RRF3_KEY_INPUTS,
+    RRF3_KEY_JOB,
+    RRF3_KEY_MOVE,
+    RRF3_KEY_NETWORK,
+    RRF3_KEY_REPLY,
+    RRF3_KEY_SENSORS,
+    RRF3_KEY_SEQS,
+    RRF3_KEY_STATE,
+    RRF3_KEY_TOOLS,
+    RRF3_KEY_MCU_TEMP,
+    RRF3_KEY_CURRENT,
+    RRF3_KEY_ACTUAL_VALUE,
+    RRF3_KEY_BED_HEATERS,
+    RRF3_KEY_CHAMBER_HEATERS,
+    RRF3_KEY_HEATERS,
+    RRF3_KEY_ACTIVE,
+    RRF3_KEY_STANDBY,
+    RRF3_KEY_NAME,
+    RRF3_KEY_NUMBER,
+    RRF3_KEY_DURATION,
+    RRF3_KEY_LAYER,
+    RRF3_KEY_FILE_POSITION,
+    RRF3_KEY_RAW_EXTRUSION,
+    RRF3_KEY_TIMES_LEFT,
+    RRF3_KEY_SIMULATION,
+    RRF3_KEY_SLICER,
+    RRF3_KEY_FILE,
+    RRF3_KEY_SIZE,
+    RRF3_KEY_NUM_LAYERS,
+    RRF3_KEY_HEIGHT,
+    RRF3_KEY_FIRST_LAYER_HEIGHT,
+    RRF3_KEY_LAYER_HEIGHT,
+    RRF3_KEY_FILE_NAME,
+    RRF3_KEY_SIMULATED_TIME,
+    RRF3_KEY_PRINT_TIME,
+    RRF3_KEY_FILAMENT,
+    RRF3_KEY_AXES,
+    RRF3_KEY_MACHINE_POSITION,
+    RRF3_KEY_HOMED,
+    RRF3_KEY_LETTER,
+    RRF3_KEY_MIN,
+    RRF3_KEY_MAX,
+    RRF3_KEY_BABYSTEP,
+    RRF3_KEY_STATUS,
+    RRF3_KEY_MESSAGE_BOX,
+    RRF3_KEY_TITLE,
+    RRF3_KEY_MESSAGE,
+    RRF3_KEY_AXIS_CONTROLS,
+    RRF3_KEY_MODE,
+    RRF3_KEY_TIMEOUT,
+    RRF3_KEY_SEQ,
+    RRF3_KEY_COUNT
+} rrf3_key_t;
+
+typedef enum {
+    RRF3_TOK_STRING,
+    RRF3_TOK_NUMBER,
+    RRF3_TOK_TRUE,
+    RRF3_TOK_FALSE,
+    RRF3_TOK_NULL
+} rrf3_tok_t;
+
+typedef struct {
+    uint8_t key;            // rrf3_key_t of the current member (objects)
+    bool is_array;
+    int16_t index;          // index of the current element (arrays)
+} rrf3_stream_level_t;
+
+typedef struct {
+    reprap_snapshot_t *target;  // printer state the values are written to
+    // tokenizer state
+    uint8_t lex_state;
+    bool token_is_key;
+    bool token_truncated;
+    uint8_t unicode_digits;
+    uint16_t unicode_val;
+    uint16_t token_len;
+    char token[RRF3_STREAM_MAX_TOKEN_LEN + 1];
+    int8_t depth;
+    rrf3_stream_level_t stack[RRF3_STREAM_MAX_DEPTH];
+    int8_t base;            // stack level whose members are the top level object model keys
+    uint8_t root_key;       // "key" of the M409/rr_model response
+    bool wrapped;           // response has a "result" object
+    bool verbose;           // requested with "d99vn" flags
+    bool error;
+    uint16_t seen;          // RRF3_SEQ_* of all received top level objects
+    bool patch;             // JSON merge patch. Missing values did not change
+    bool msg_box_changed;   // title, message or mode of the parsed state.messageBox differ from the shown box
+    int32_t msg_box_seq;    // state.messageBox.seq of the parsed box. -1 if RRF did not send it
+    // data that can only be applied once the whole response is received. Must stay at the end of the struct,
+    // rrf3_stream_begin_patch() keeps it from the previous message
+    struct {
+        double current;
+        double active;
+        double standby;
+        int state;
+    } heaters[RRF3_STREAM_MAX_HEATERS];
+    int num_heaters;        // -1 if not part of the response
+    double fans[RRF3_STREAM_MAX_FANS];
+    int num_fans;           // -1 if not part of the response
+} rrf3_stream_parser_t;
+
+void rrf3_stream_begin(rrf3_stream_parser_t *parser, reprap_snapshot_t *target);
+
+void rrf3_stream_begin_patch(rrf3_stream_parser_t *parser, reprap_snapshot_t *target);
+
+bool rrf3_stream_feed(rrf3_stream_parser_t *parser, const char *data, int len);
+
+bool rrf3_stream_complete(const rrf3_stream_parser_t *parser);
+
+bool rrf3_stream_end(rrf3_stream_parser_t *parser);
+
+#endif //REPPANEL_ESP32_RRF3_STREAM_PARSER_H
@@ -26,6 +26,7 @@
 #define REPRAP_MAX_DISPLAY_MSG_LEN     128
 #define REPRAP_MAX_STATUS_LEN       15
 #define REPRAP_MAX_LEN_MSG_TITLE    32
+#define REPRAP_MAX_SESSION_KEY_LEN  48
 
 typedef struct {
     uint16_t boards;
@@ -68,18 +69,31 @@ typedef struct {
     bool show_axis_controls; // true, false
     uint8_t mode;
     uint16_t timeout;
-    bool new_msg; // true, false
+    uint16_t msg_seq;   // incremented for every new message box. GUI shows the box when it differs from the shown one
+    int32_t msg_box_seq;    // messageBox.seq of the current box. -1 if there is none or RRF does not send it
 } reprap_state_t;
 
+// Slicer thumbnail embedded in a G-code file
+typedef struct {
+    uint32_t offset;        // of the thumbnail data within the file
+    uint32_t size;          // length of the base64 encoded data. 0 if the file has no thumbnail RepPanel can show
+    uint16_t width;
+    uint16_t height;
+} reprap_thumbnail_t;
+
 typedef struct {
     struct {
         uint32_t size;
+        time_t lastModified;            // 0 if unknown
         char fileName[MAX_LEN_FILENAME];
         uint32_t simulatedTime;
         uint32_t printTime;
         uint16_t numLayers;
         float height;
+        double firstLayerHeight;
+        double layerHeight;
         double overall_filament_usage; // [mm] as preported by firmware and slicer
+        reprap_thumbnail_t thumbnail;   // largest QOI thumbnail that fits the display
     } file;
     uint32_t filePosition;
     uint32_t duration;
@@ -95,6 +109,7 @@ typedef struct {
 
 typedef struct {
     uint8_t api_level;
+    char session_key[REPRAP_MAX_SESSION_KEY_LEN];   // empty if the Duet did not hand out one
     uint8_t num_heaters;
     uint8_t num_tools;
     reprap_state_t reprap_state;
@@ -7,6 +7,8 @@
 
 #include <stdbool.h>
 
+extern bool screen_saver_active;
+
 void activate_screen_saver();
 void deactivate_screen_saver();
 
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Wolfgang Christl
+# Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+#
+# Generates main/rrf3_key_hash.h - a perfect hash over the object model keys known to main/rrf3_stream_parser.c.
+# Keys are taken from rrf3_key_names[]. Run again whenever a key is added or renamed:
+#
+#   python3 tools/gen_rrf3_key_hash.py
+#
+
+import os
+import re
+import sys
+
+MAIN_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'main')
+SOURCE = os.path.join(MAIN_DIR, 'rrf3_stream_parser.c')
+HEADER = os.path.join(MAIN_DIR, 'rrf3_key_hash.h')
+TABLE_SIZE = 256        # power of two. Larger tables make finding a seed easier
+MAX_SEED_TRIES = 1000000
+FNV_PRIME = 16777619
+
+
+def key_hash(name, seed):
+    """Must match rrf3_key_hash() in rrf3_key_hash.h"""
+    h = seed
+    for c in name.encode():
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h ^ (h >> 16)
+
+
+def read_keys():
+    with open(SOURCE) as f:
+        source = f.read()
+    table = re.search(r'rrf3_key_names\[RRF3_KEY_COUNT\] = \{(.*?)\};', source, re.S)
+    if table is None:
+        sys.exit('rrf3_key_names[] not found in ' + SOURCE)
+    keys = re.findall(r'\[(RRF3_KEY_\w+)\] = "(\w*)"', table.group(1))
+    return [(symbol, name) for symbol, name in keys if name]
+
+
+def find_seed(names):
+    for seed in range(1, MAX_SEED_TRIES):
+        slots = {key_hash(name, seed) & (TABLE_SIZE - 1) for name in names}
+        if len(slots) == len(names):
+            return seed
+    sys.exit('No perfect hash found. Increase TABLE_SIZE')
+
+
+def main():
+    keys = read_keys()
+    seed = find_seed([name for _, name in keys])
+    table = ['RRF3_KEY_NONE'] * TABLE_SIZE
+    for symbol, name in keys:
+        table[key_hash(name, seed) & (TABLE_SIZE - 1)] = symbol
+    rows = []
+    for i in range(0, TABLE_SIZE, 4):
+        rows.append('        ' + ' '.join(entry + ',' for entry in table[i:i + 4]))
+    with open(HEADER, 'w') as f:
+        f.write('''//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Generated by tools/gen_rrf3_key_hash.py from rrf3_key_names[] in rrf3_stream_parser.c - do not edit
+//
+
+#ifndef REPPANEL_ESP32_RRF3_KEY_HASH_H
+#define REPPANEL_ESP32_RRF3_KEY_HASH_H
+
+#include <stdint.h>
+#include "rrf3_stream_parser.h"
+
+#define RRF3_KEY_HASH_SEED  %uu
+#define RRF3_KEY_HASH_MASK  %iu
+
+static inline uint32_t rrf3_key_hash(const char *name) {
+    uint32_t h = RRF3_KEY_HASH_SEED;
+    for (; *name != '\\0'; name++) h = (h ^ (uint8_t) *name) * %iu;
+    return h ^ (h >> 16);
+}
+
+// Hash slot to key. Every known key has a slot of its own. Candidates still need to be compared
+static const uint8_t rrf3_key_hash_table[RRF3_KEY_HASH_MASK + 1] = {
+%s
+};
+
+#endif //REPPANEL_ESP32_RRF3_KEY_HASH_H
+''' % (seed, TABLE_SIZE - 1, FNV_PRIME, '\n'.join(rows)))
+    print('%i keys, seed %i, written to %s' % (len(keys), seed, os.path.relpath(HEADER)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
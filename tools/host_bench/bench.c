@@ -0,0 +1,259 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Replays the responses in debug_responses through the firmware parsers and reports time, number of allocations and
+// peak heap usage per message. Allocations are counted by wrapping malloc & co. at link time (see CMakeLists.txt)
+//
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <cJSON.h>
+
+#include "reppanel.h"
+#include "reppanel_helper.h"
+#include "reppanel_json_arena.h"
+#include "reppanel_snapshot.h"
+#include "rrf3_object_model_parser.h"
+#include "rrf3_stream_parser.h"
+
+#ifndef HOST_BENCH_RESPONSES_DIR
+#define HOST_BENCH_RESPONSES_DIR    "debug_responses"
+#endif
+#define BENCH_DEFAULT_ITERATIONS    2000
+#define BENCH_DEFAULT_CHUNK_SIZE    512     // default receive buffer of esp_http_client
+#define BENCH_MAX_SERIAL_LINES      64
+#define ALLOC_HEADER_SIZE           16      // keeps the returned pointers aligned like malloc does
+
+// Defined in main/reppanel_request.c but not part of its header
+void process_reprap2_status(char *buff);
+void process_reprap3_status(rrf3_stream_parser_t *parser);
+int process_reprap_filelist(char *buffer);
+
+typedef enum {
+    MSG_RRF2_STATUS,    // rr_status?type=x or M408 response
+    MSG_RRF2_SERIAL,    // serial log. Every line that starts with '{' is a M408 response
+    MSG_RRF3_STATUS,    // rr_model or M409 response. Fed to the stream parser in chunks
+    MSG_FILELIST,       // rr_filelist or M20 S2 response
+    MSG_FILEINFO        // rr_fileinfo or M36 response
+} bench_msg_type_t;
+
+typedef struct {
+    const char *name;
+    const char *file;   // relative to the responses directory
+    bench_msg_type_t type;
+} bench_msg_t;
+
+static const bench_msg_t bench_msgs[] = {
+        {"rrf2 status idle",        "RRF3_0_0/reprap_status_2.json",    MSG_RRF2_STATUS},
+        {"rrf2 status printing",    "RRF3_0_0/printing.json",           MSG_RRF2_STATUS},
+        {"rrf2 status message",     "RRF3_0_0/message_response.json",   MSG_RRF2_STATUS},
+        {"rrf2 serial M408 log",    "RRF3_0_0/duet_serial.txt",         MSG_RRF2_SERIAL},
+        {"rrf3 d99fn",              "RRF3_1_0/d99fn.json",              MSG_RRF3_STATUS},
+        {"rrf3 job",                "RRF3_1_0/job.json",                MSG_RRF3_STATUS},
+        {"rrf3 move",               "RRF3_1_0/move.json",               MSG_RRF3_STATUS},
+        {"rrf3 state",              "RRF3_1_0/state.json",              MSG_RRF3_STATUS},
+        {"filelist macros rrf2",    "RRF3_0_0/macro_response.json",     MSG_FILELIST},
+        {"filelist macros rrf3",    "RRF3_1_0/macro_response.json",     MSG_FILELIST},
+        {"filelist filaments",      "RRF3_0_0/filament_response.json",  MSG_FILELIST},
+        {"fileinfo rrf2",           "RRF3_0_0/file_info.json",          MSG_FILEINFO},
+        {"fileinfo rrf3",           "RRF3_1_0/file_info.json",          MSG_FILEINFO},
+};
+
+static size_t heap_curr = 0;
+static size_t heap_peak = 0;
+static unsigned long alloc_cnt = 0;
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static void heap_track(size_t added) {
+    alloc_cnt++;
+    heap_curr += added;
+    if (heap_curr > heap_peak) heap_peak = heap_curr;
+}
+
+void *__wrap_malloc(size_t size) {
+    uint8_t *block = __real_malloc(size + ALLOC_HEADER_SIZE);
+    if (block == NULL) return NULL;
+    *(size_t *) block = size;
+    heap_track(size);
+    return block + ALLOC_HEADER_SIZE;
+}
+
+void *__wrap_calloc(size_t num, size_t size) {
+    if (size != 0 && num > SIZE_MAX / size) return NULL;
+    void *ptr = __wrap_malloc(num * size);
+    if (ptr != NULL) memset(ptr, 0, num * size);
+    return ptr;
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr == NULL) return;
+    uint8_t *block = (uint8_t *) ptr - ALLOC_HEADER_SIZE;
+    heap_curr -= *(size_t *) block;
+    __real_free(block);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (ptr == NULL) return __wrap_malloc(size);
+    if (size == 0) {
+        __wrap_free(ptr);
+        return NULL;
+    }
+    uint8_t *block = (uint8_t *) ptr - ALLOC_HEADER_SIZE;
+    size_t old_size = *(size_t *) block;
+    block = __real_realloc(block, size + ALLOC_HEADER_SIZE);
+    if (block == NULL) return NULL;
+    *(size_t *) block = size;
+    heap_curr -= old_size;
+    heap_track(size);
+    return block + ALLOC_HEADER_SIZE;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static char *read_file(const char *dir, const char *file, int *len) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Can not open %s\n", path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *len = (int) ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(*len + 1);
+    if (data == NULL || fread(data, 1, *len, f) != (size_t) *len) {
+        fprintf(stderr, "Can not read %s\n", path);
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+    data[*len] = '\0';
+    fclose(f);
+    return data;
+}
+
+/**
+ * Cut the serial log into the M408 responses it contains. Modifies data
+ * @return number of responses found
+ */
+static int split_serial_log(char *data, char **lines) {
+    int cnt = 0;
+    for (char *line = strtok(data, "\r\n"); line != NULL; line = strtok(NULL, "\r\n")) {
+        if (line[0] == '{' && cnt < BENCH_MAX_SERIAL_LINES) lines[cnt++] = line;
+    }
+    return cnt;
+}
+
+static void replay_rrf3(const char *data, int len, int chunk_size) {
+    static rrf3_stream_parser_t parser;
+    rrf3_stream_begin(&parser, &reprap_work);
+    for (int pos = 0; pos < len; pos += chunk_size) {
+        rrf3_stream_feed(&parser, data + pos, len - pos < chunk_size ? len - pos : chunk_size);
+    }
+    process_reprap3_status(&parser);
+}
+
+/**
+ * Run a message through its parser once
+ * @return number of responses that were parsed
+ */
+static int replay(const bench_msg_t *msg, char *data, int len, char **lines, int num_lines, int chunk_size) {
+    switch (msg->type) {
+        case MSG_RRF2_STATUS:
+            process_reprap2_status(data);
+            return 1;
+        case MSG_RRF2_SERIAL:
+            for (int i = 0; i < num_lines; i++) process_reprap2_status(lines[i]);
+            return num_lines;
+        case MSG_RRF3_STATUS:
+            replay_rrf3(data, len, chunk_size);
+            return 1;
+        case MSG_FILELIST:
+            process_reprap_filelist(data);
+            return 1;
+        case MSG_FILEINFO:
+        default:
+            reppanel_parse_rr_fileinfo(data, &reprap_work.model, len + 1);
+            return 1;
+    }
+}
+
+static void bench_msg(const bench_msg_t *msg, const char *dir, int iterations, int chunk_size) {
+    int len = 0;
+    char *data = read_file(dir, msg->file, &len);
+    if (data == NULL) return;
+    char *lines[BENCH_MAX_SERIAL_LINES];
+    int num_lines = 0;
+    if (msg->type == MSG_RRF2_SERIAL) {
+        num_lines = split_serial_log(data, lines);
+        len = 0;
+        for (int i = 0; i < num_lines; i++) len += (int) strlen(lines[i]);
+    }
+    replay(msg, data, len, lines, num_lines, chunk_size);     // warm up caches & lazily allocated buffers
+
+    size_t heap_base = heap_curr;
+    heap_peak = heap_curr;
+    alloc_cnt = 0;
+    long parsed = 0;
+    uint64_t start = now_ns();
+    for (int i = 0; i < iterations; i++) {
+        parsed += replay(msg, data, len, lines, num_lines, chunk_size);
+    }
+    uint64_t duration = now_ns() - start;
+    if (parsed == 0) parsed = 1;
+    int msg_len = msg->type == MSG_RRF2_SERIAL && num_lines > 0 ? len / num_lines : len;
+    double us_per_msg = (double) duration / 1000.0 / parsed;
+    printf("%-24s %8d %10.2f %9.1f %10.1f %12zu\n", msg->name, msg_len, us_per_msg, msg_len / us_per_msg,
+           (double) alloc_cnt / parsed, heap_peak - heap_base);
+    free(data);
+}
+
+static void print_usage(const char *name) {
+    printf("Usage: %s [-n iterations] [-c chunk size] [debug_responses directory]\n", name);
+}
+
+int main(int argc, char **argv) {
+    int iterations = BENCH_DEFAULT_ITERATIONS;
+    int chunk_size = BENCH_DEFAULT_CHUNK_SIZE;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'c':
+                chunk_size = atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (iterations < 1 || chunk_size < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *dir = optind < argc ? argv[optind] : HOST_BENCH_RESPONSES_DIR;
+
+    reppanel_json_arena_init();
+    reppanel_snapshot_init();
+    reprap_work.model = init_reprap_model();
+    init_reprap_buffers();
+
+    printf("%d iterations, RRF3 responses fed in chunks of %d bytes\n\n", iterations, chunk_size);
+    printf("%-24s %8s %10s %9s %10s %12s\n", "message", "bytes", "us/msg", "MB/s", "allocs/msg", "peak heap B");
+    for (unsigned i = 0; i < sizeof(bench_msgs) / sizeof(bench_msgs[0]); i++) {
+        bench_msg(&bench_msgs[i], dir, iterations, chunk_size);
+    }
+    return 0;
+}
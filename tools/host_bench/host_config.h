@@ -0,0 +1,20 @@
+// Replaces the sdkconfig.h generated by ESP-IDF when building tools/host_bench. Included in front of every source
+#ifndef HOST_BENCH_HOST_CONFIG_H
+#define HOST_BENCH_HOST_CONFIG_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>     // ESP-IDF headers pull these in indirectly. The sources rely on it
+#include <esp_attr.h>
+
+#define CONFIG_REPPANEL_RRF2_SUPPORT                1
+#define CONFIG_REPPANEL_ESP32_WIFI_ENABLED          1
+#define CONFIG_REPPANEL_MAX_NUM_ELEM_DIR            32
+#define CONFIG_REPPANEL_MAX_FILENAME_LENGTH         64
+#define CONFIG_REPPANEL_MAX_DIRECTORY_PATH_LENGTH   160
+
+// newlib provides strlcpy, glibc < 2.38 does not
+size_t strlcpy(char *dst, const char *src, size_t size);
+
+#endif //HOST_BENCH_HOST_CONFIG_H
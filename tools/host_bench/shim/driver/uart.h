@@ -0,0 +1,5 @@
+// Host shim of ESP-IDF driver/uart.h for tools/host_bench
+#ifndef HOST_BENCH_UART_H
+#define HOST_BENCH_UART_H
+
+#endif //HOST_BENCH_UART_H
@@ -0,0 +1,8 @@
+// Host shim of ESP-IDF esp_attr.h for tools/host_bench
+#ifndef HOST_BENCH_ESP_ATTR_H
+#define HOST_BENCH_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define EXT_RAM_ATTR
+
+#endif //HOST_BENCH_ESP_ATTR_H
@@ -0,0 +1,15 @@
+// Host shim of ESP-IDF esp_err.h for tools/host_bench
+#ifndef HOST_BENCH_ESP_ERR_H
+#define HOST_BENCH_ESP_ERR_H
+
+typedef int esp_err_t;
+
+#define ESP_OK              0
+#define ESP_FAIL            (-1)
+#define ESP_ERR_NO_MEM      0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_TIMEOUT     0x107
+
+const char *esp_err_to_name(esp_err_t code);
+
+#endif //HOST_BENCH_ESP_ERR_H
@@ -0,0 +1,14 @@
+// Host shim of ESP-IDF esp_heap_caps.h for tools/host_bench
+#ifndef HOST_BENCH_ESP_HEAP_CAPS_H
+#define HOST_BENCH_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_8BIT     (1 << 2)
+
+#define heap_caps_malloc(size, caps)            malloc(size)
+#define heap_caps_realloc(ptr, size, caps)      realloc(ptr, size)
+#define heap_caps_free(ptr)                     free(ptr)
+
+#endif //HOST_BENCH_ESP_HEAP_CAPS_H
@@ -0,0 +1,49 @@
+// Host shim of ESP-IDF esp_http_client.h for tools/host_bench. No requests are made on the host
+#ifndef HOST_BENCH_ESP_HTTP_CLIENT_H
+#define HOST_BENCH_ESP_HTTP_CLIENT_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef enum {
+    HTTP_EVENT_ERROR,
+    HTTP_EVENT_ON_CONNECTED,
+    HTTP_EVENT_HEADER_SENT,
+    HTTP_EVENT_ON_HEADER,
+    HTTP_EVENT_ON_DATA,
+    HTTP_EVENT_ON_FINISH,
+    HTTP_EVENT_DISCONNECTED
+} esp_http_client_event_id_t;
+
+typedef struct {
+    esp_http_client_event_id_t event_id;
+    esp_http_client_handle_t client;
+    void *data;
+    int data_len;
+    void *user_data;
+    char *header_key;
+    char *header_value;
+} esp_http_client_event_t;
+
+typedef esp_err_t (*http_event_handle_cb)(esp_http_client_event_t *evt);
+
+typedef enum {
+    HTTP_METHOD_GET,
+    HTTP_METHOD_POST
+} esp_http_client_method_t;
+
+typedef struct {
+    const char *url;
+    int timeout_ms;
+    http_event_handle_cb event_handler;
+    void *user_data;
+} esp_http_client_config_t;
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+int esp_http_client_get_content_length(esp_http_client_handle_t client);
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method);
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len);
+
+#endif //HOST_BENCH_ESP_HTTP_CLIENT_H
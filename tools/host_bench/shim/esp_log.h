@@ -0,0 +1,17 @@
+// Host shim of ESP-IDF esp_log.h for tools/host_bench. Logging is compiled out so it does not distort the timing
+#ifndef HOST_BENCH_ESP_LOG_H
+#define HOST_BENCH_ESP_LOG_H
+
+#include "esp_err.h"
+
+#include <stdio.h>
+
+// Arguments are still type checked but never evaluated
+#define HOST_BENCH_LOG(tag, format, ...)    do { if (0) printf("%s " format, tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGE(tag, format, ...)          HOST_BENCH_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)          HOST_BENCH_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)          HOST_BENCH_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)          HOST_BENCH_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)          HOST_BENCH_LOG(tag, format, ##__VA_ARGS__)
+
+#endif //HOST_BENCH_ESP_LOG_H
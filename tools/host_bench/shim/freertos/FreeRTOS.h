@@ -0,0 +1,20 @@
+// Host shim of FreeRTOS.h for tools/host_bench. The benchmark is single threaded
+#ifndef HOST_BENCH_FREERTOS_H
+#define HOST_BENCH_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;              // same widths as the Xtensa port
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define portMAX_DELAY       0xffffffff
+#define portTICK_RATE_MS    1
+#define pdMS_TO_TICKS(ms)   ((TickType_t) (ms))
+#define configASSERT(x)     ((void) (x))
+#define tskIDLE_PRIORITY    0
+
+#endif //HOST_BENCH_FREERTOS_H
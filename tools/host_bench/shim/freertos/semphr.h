@@ -0,0 +1,14 @@
+// Host shim of FreeRTOS semphr.h for tools/host_bench
+#ifndef HOST_BENCH_SEMPHR_H
+#define HOST_BENCH_SEMPHR_H
+
+#include "FreeRTOS.h"
+#include "task.h"     // pulled in via queue.h in ESP-IDF
+
+typedef void *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif //HOST_BENCH_SEMPHR_H
@@ -0,0 +1,18 @@
+// Host shim of FreeRTOS task.h for tools/host_bench
+#ifndef HOST_BENCH_TASK_H
+#define HOST_BENCH_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created_task);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif //HOST_BENCH_TASK_H
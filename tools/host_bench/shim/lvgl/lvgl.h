@@ -0,0 +1,62 @@
+// Host shim of LVGL for tools/host_bench. Only the types used by the request & parser headers. Nothing is drawn
+#ifndef HOST_BENCH_LVGL_H
+#define HOST_BENCH_LVGL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct _lv_obj_t lv_obj_t;
+typedef struct _lv_font_t lv_font_t;
+typedef uint8_t lv_event_t;
+typedef void (*lv_event_cb_t)(lv_obj_t *obj, lv_event_t event);
+
+#define LV_IMG_CF_RAW           1
+#define LV_IMG_CF_RAW_ALPHA     2
+#define LV_IMG_CF_TRUE_COLOR        4
+#define LV_IMG_CF_TRUE_COLOR_ALPHA  5
+
+typedef union {
+    struct {
+        uint16_t blue : 5;
+        uint16_t green : 6;
+        uint16_t red : 5;
+    } ch;
+    uint16_t full;
+} lv_color_t;
+
+static inline lv_color_t lv_color_make(uint8_t r8, uint8_t g8, uint8_t b8) {
+    lv_color_t color;
+    color.ch.red = r8 >> 3;
+    color.ch.green = g8 >> 2;
+    color.ch.blue = b8 >> 3;
+    return color;
+}
+
+typedef struct {
+    uint32_t cf : 5;
+    uint32_t always_zero : 3;
+    uint32_t reserved : 2;
+    uint32_t w : 11;
+    uint32_t h : 11;
+} lv_img_header_t;
+
+typedef struct {
+    lv_img_header_t header;
+    uint32_t data_size;
+    const uint8_t *data;
+} lv_img_dsc_t;
+
+#define LV_FIT_TIGHT        1
+#define LV_ALIGN_CENTER     0
+
+#define LV_FONT_DECLARE(font_name) extern lv_font_t font_name;
+
+lv_obj_t *lv_btn_create(lv_obj_t *parent, const lv_obj_t *copy);
+void lv_btn_set_fit(lv_obj_t *btn, uint8_t fit);
+lv_obj_t *lv_label_create(lv_obj_t *parent, const lv_obj_t *copy);
+void lv_label_set_text(lv_obj_t *label, const char *text);
+void lv_obj_set_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb);
+void lv_obj_align(lv_obj_t *obj, const lv_obj_t *base, uint8_t align, int16_t x_mod, int16_t y_mod);
+void lv_img_cache_invalidate_src(const void *src);
+
+#endif //HOST_BENCH_LVGL_H
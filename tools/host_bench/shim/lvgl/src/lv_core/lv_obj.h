@@ -0,0 +1,2 @@
+// Host shim of LVGL for tools/host_bench
+#include <lvgl/lvgl.h>
@@ -0,0 +1,2 @@
+// Host shim of LVGL lv_btn.h for tools/host_bench
+#include <lvgl/lvgl.h>
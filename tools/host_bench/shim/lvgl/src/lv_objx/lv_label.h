@@ -0,0 +1,2 @@
+// Host shim of LVGL lv_label.h for tools/host_bench
+#include <lvgl/lvgl.h>
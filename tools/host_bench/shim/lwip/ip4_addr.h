@@ -0,0 +1,5 @@
+// Host shim of lwip/ip4_addr.h for tools/host_bench
+#ifndef HOST_BENCH_IP4_ADDR_H
+#define HOST_BENCH_IP4_ADDR_H
+
+#endif //HOST_BENCH_IP4_ADDR_H
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2022 Wolfgang Christl
+// Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+//
+// Everything the parsers link against but that is not part of the benchmark: GUI globals & widget updates, UART,
+// HTTP pool, scheduler and FreeRTOS. All of it does nothing. The request code must behave as if it is not connected
+//
+
+#include <esp_http_client.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <lvgl/lvgl.h>
+
+#include "reppanel.h"
+#include "esp32_settings.h"
+#include "esp32_uart.h"
+#include "esp32_wifi.h"
+#include "esp32_http_pool.h"
+#include "reppanel_scheduler.h"
+#include "reppanel_gcode_queue.h"
+#include "reppanel_machine.h"
+#include "reppanel_macros.h"
+#include "reppanel_jobselect.h"
+#include "main.h"
+
+// Defined by the GUI, settings & main sources on the ESP32
+int rp_conn_stat = 0;
+int heater_states[MAX_NUM_TOOLS];
+bool job_running = false;
+float reprap_job_percent;
+reprap_tool_t reprap_tools[MAX_NUM_TOOLS];
+reprap_bed_t reprap_bed;
+reprap_chamber_t reprap_chamber;
+reprap_axes_t reprap_axes;
+reprap_params_t reprap_params;
+reprap_tool_poss_temps_t reprap_tool_poss_temps;
+reprap_bed_poss_temps_t reprap_bed_poss_temps;
+double reprap_extruder_amounts[NUM_TEMPS_BUFF];
+double reprap_extruder_feedrates[NUM_TEMPS_BUFF];
+double reprap_babysteps_amount = 0.05;
+double reprap_move_feedrate = 6000;
+double reprap_mcu_temp = 0;
+char reprap_firmware_name[32];
+char reprap_firmware_version[5];
+char filament_names[MAX_LEN_STR_FILAMENT_LIST];
+char rep_addr[MAX_REP_ADDR_LEN];
+char rep_pass[MAX_REP_PASS_LEN];
+bool uart_inited = false;
+SemaphoreHandle_t xGuiSemaphore = NULL;     // NULL makes the parsers skip all widget updates
+
+void update_rep_panel_conn_status() {}
+
+void show_reprap_dialog(char *title, char *msg, uint8_t mode, bool show_height_adjust) {}
+
+void update_job_list_ui() {}
+
+void update_macro_list_ui() {}
+
+void update_file_info_dialog_ui(reprap_model_t *_reprap_model) {}
+
+void update_file_info_thumbnail_ui() {}
+
+void update_job_thumbnail_ui() {}
+
+lv_obj_t *lv_btn_create(lv_obj_t *parent, const lv_obj_t *copy) { return NULL; }
+
+void lv_btn_set_fit(lv_obj_t *btn, uint8_t fit) {}
+
+lv_obj_t *lv_label_create(lv_obj_t *parent, const lv_obj_t *copy) { return NULL; }
+
+void lv_label_set_text(lv_obj_t *label, const char *text) {}
+
+void lv_obj_set_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb) {}
+
+void lv_obj_align(lv_obj_t *obj, const lv_obj_t *base, uint8_t align, int16_t x_mod, int16_t y_mod) {}
+
+void lv_img_cache_invalidate_src(const void *src) {}
+
+bool reppanel_uart_probe_baud_rate() { return false; }
+
+bool reppanel_uart_baud_rate_pending() { return false; }
+
+void reppanel_write_uart(char *buffer, int buffer_len) {}
+
+void esp32_flush_uart() {}
+
+bool reppanel_is_uart_connected() { return false; }
+
+bool reppanel_read_response(uart_response_buff_t *receive_buff) { return false; }
+
+int resolve_mdns_host(const char *host_name, char *result_ip) { return -1; }
+
+void http_pool_buff_init(wifi_response_buff_t *buff) {
+    memset(buff, 0, sizeof(wifi_response_buff_t));
+}
+
+void http_pool_buff_free(wifi_response_buff_t *buff) {
+    free(buff->buffer);
+    memset(buff, 0, sizeof(wifi_response_buff_t));
+}
+
+void http_pool_set_session_key(const char *session_key) {}
+
+http_pool_conn_t *http_pool_acquire(const char *url, int timeout_ms, wifi_response_buff_t *resp_buff) { return NULL; }
+
+void http_pool_set_consumer(http_pool_conn_t *conn, const http_pool_consumer_t *consumer, void *ctx) {}
+
+esp_err_t http_pool_perform(http_pool_conn_t *conn) { return ESP_FAIL; }
+
+void http_pool_release(http_pool_conn_t *conn, bool keep_alive) {}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) { return -1; }
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method) {
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len) {
+    return ESP_OK;
+}
+
+void reppanel_sched_init() {}
+
+void reppanel_sched_wait() {}
+
+bool reppanel_sched_due(reppanel_sched_job_t job) { return false; }
+
+void reppanel_sched_trigger() {}
+
+bool reppanel_gcode_queue_pop_batch(gcode_batch_t *batch, size_t max_encoded_len) { return false; }
+
+void reppanel_gcode_queue_batch_done(const gcode_batch_t *batch, bool success) {}
+
+bool reppanel_gcode_queue_push(const char *gcode, gcode_done_cb_t done_cb, void *user_data) { return false; }
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return (SemaphoreHandle_t) 1; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) { return pdTRUE; }
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) { return pdTRUE; }
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created_task) { return pdFALSE; }
+
+void vTaskDelete(TaskHandle_t task) {}
+
+void vTaskDelay(TickType_t ticks) {}
+
+TickType_t xTaskGetTickCount(void) { return 0; }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return (TaskHandle_t) 1; }     // the one and only task
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) { return 0; }
+
+size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
@@ -0,0 +1,527 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Wolfgang Christl
+# Licensed under Apache License, Version 2.0 - https://opensource.org/licenses/Apache-2.0
+#
+# Stand-in for a Duet so the network and UART code of RepPanel can be tested without a printer.
+# Answers the HTTP API of standalone RRF (rr_*) and of Duet SBC (/machine/*) as well as M408/M409/M20/M36 on a
+# pseudo terminal. All responses are built from the captures in debug_responses. Latency, packet loss and large
+# directory trees can be injected. In SBC mode object model patches are pushed via the WebSocket at /machine like DSF.
+#
+#   python3 tools/mock_duet/mock_duet.py --port 8080 --serial --latency 40 --jitter 20 --drop 2 --files 2000
+#
+
+import argparse
+import base64
+import copy
+import hashlib
+import json
+import os
+import random
+import re
+import signal
+import socket
+import sys
+import threading
+import time
+import tty
+from collections import Counter
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, unquote, urlparse
+
+FIXTURES_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'debug_responses')
+RRF2_DIR = 'RRF3_0_0'   # captures of the RRF2 compatible API (rr_status, M408)
+RRF3_DIR = 'RRF3_1_0'   # captures of the object model API (rr_model, M409)
+WS_GUID = '258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+WS_PATCH_INTERVAL = 0.5     # [s] object model is checked for changes this often while a WebSocket is subscribed
+
+# Files that can be fetched with rr_download & /machine/file
+DOWNLOADS = {
+    '0:/sys/dwc2settings.json': os.path.join(RRF2_DIR, 'dwc2_config.json'),
+    '0:/sys/dwc-settings.json': os.path.join(RRF3_DIR, 'dwc-settings.json'),
+}
+
+
+def compact(obj):
+    return json.dumps(obj, separators=(',', ':'))
+
+
+def load_json(fixtures, path):
+    with open(os.path.join(fixtures, path)) as f:
+        return json.load(f)
+
+
+def merge_patch(old, new):
+    """JSON merge patch from old to new like DSF sends it. Unchanged elements of object arrays are sent as {}
+    :return: None if nothing changed"""
+    if isinstance(old, dict) and isinstance(new, dict):
+        patch = {key: None for key in old if key not in new}
+        for key, value in new.items():
+            if key not in old:
+                patch[key] = value
+            else:
+                diff = merge_patch(old[key], value)
+                if diff is not None:
+                    patch[key] = diff
+        return patch or None
+    if isinstance(old, list) and isinstance(new, list) and all(isinstance(item, dict) for item in old + new):
+        if old == new:
+            return None
+        return [merge_patch(old[i], item) or {} if i < len(old) else item for i, item in enumerate(new)]
+    return None if old == new else new
+
+
+def load_serial_log(fixtures):
+    """Map every M408 command in the serial capture to the response that followed it"""
+    responses = {}
+    command = None
+    with open(os.path.join(fixtures, RRF2_DIR, 'duet_serial.txt')) as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith('M408'):
+                command = line
+            elif line.startswith('{') and command:
+                responses[command] = json.loads(line)
+                command = None
+    return responses
+
+
+class FileTree:
+    """0:/macros and 0:/filaments from the captures, 0:/gcodes is generated and can be made as large as needed"""
+
+    def __init__(self, fixtures, num_files, num_dirs, depth):
+        self.dirs = {}
+        for path in (os.path.join(RRF3_DIR, 'macro_response.json'), os.path.join(RRF2_DIR, 'filament_response.json')):
+            listing = load_json(fixtures, path)
+            self.dirs[listing['dir'].rstrip('/')] = listing['files']
+        self._generate('0:/gcodes', num_files, num_dirs, depth, time.mktime((2022, 1, 1, 12, 0, 0, 0, 0, -1)))
+
+    def _generate(self, path, num_files, num_dirs, depth, stamp):
+        entries = []
+        if depth > 0:
+            for i in range(num_dirs):
+                name = 'folder_%02d' % i
+                entries.append({'type': 'd', 'name': name, 'size': 0, 'date': self._date(stamp)})
+                self._generate(path + '/' + name, max(1, num_files // 4), num_dirs, depth - 1, stamp - 3600 * i)
+        for i in range(num_files):
+            entries.append({'type': 'f', 'name': 'part_%05d.gcode' % i, 'size': 100000 + 7919 * i,
+                            'date': self._date(stamp - 60 * i)})
+        self.dirs[path] = entries
+
+    @staticmethod
+    def _date(stamp):
+        return time.strftime('%Y-%m-%dT%H:%M:%S', time.localtime(stamp))
+
+    def listing(self, path):
+        return self.dirs.get(path.rstrip('/'))
+
+    def contains(self, path):
+        directory, _, name = path.rpartition('/')
+        entries = self.listing(directory) or []
+        return any(entry['name'] == name and entry['type'] == 'f' for entry in entries)
+
+
+class MockDuet:
+    """Printer state shared by the HTTP server and the serial port"""
+
+    def __init__(self, args):
+        fixtures = args.fixtures
+        self.args = args
+        self.lock = threading.Lock()
+        self.stats = Counter()
+        self.rrf2_status = {2: load_json(fixtures, os.path.join(RRF2_DIR, 'reprap_status_2.json')),
+                            3: load_json(fixtures, os.path.join(RRF2_DIR, 'printing.json'))}
+        self.serial_status = load_serial_log(fixtures)
+        self.model = load_json(fixtures, os.path.join(RRF3_DIR, 'd99fn.json'))['result']
+        for key in ('job', 'move', 'state'):     # more complete than the ones in the d99fn capture
+            self.model[key] = load_json(fixtures, os.path.join(RRF3_DIR, key + '.json'))['result']
+        self.file_info = load_json(fixtures, os.path.join(RRF3_DIR, 'file_info.json'))
+        self.tree = FileTree(fixtures, args.files, args.dirs, args.depth)
+        self.downloads = {name: os.path.join(fixtures, path) for name, path in DOWNLOADS.items()}
+        self.reply = ''
+        self.gcodes = []
+
+    def animate(self):
+        """Let the heaters drift so the panel has something to redraw. Bumps the matching sequence numbers"""
+        if not self.args.animate:
+            return
+        for heater in self.model.get('heat', {}).get('heaters', []):
+            if isinstance(heater.get('current'), (int, float)):
+                heater['current'] = round(heater['current'] + random.uniform(-0.5, 0.5), 1)
+        for status in self.rrf2_status.values():
+            status['temps']['current'] = [round(t + random.uniform(-0.5, 0.5), 1) for t in status['temps']['current']]
+        for status in self.serial_status.values():
+            if 'heaters' in status:
+                status['heaters'] = [round(t + random.uniform(-0.5, 0.5), 1) for t in status['heaters']]
+        seqs = self.model.setdefault('seqs', {})
+        seqs['heat'] = seqs.get('heat', 0) + 1
+        self.model['state']['upTime'] = self.model['state'].get('upTime', 0) + 1
+
+    # Status responses are serialised while holding the lock. animate() changes them in place
+
+    def rrf2(self, status_type):
+        with self.lock:
+            self.animate()
+            return compact(self.rrf2_status.get(status_type, self.rrf2_status[2]))
+
+    def serial_rrf2(self, command):
+        with self.lock:
+            self.animate()
+            if command in self.serial_status:
+                return compact(self.serial_status[command])
+            status_type = int(command[-1]) if command[-1].isdigit() else 2
+            return compact(self.rrf2_status.get(status_type, self.rrf2_status[2]))
+
+    def object_model(self, key, flags, sbc=False):
+        with self.lock:
+            self.animate()
+            if sbc:
+                return compact(self.model)
+            result = self.model
+            for part in key.split('.') if key else []:
+                result = result.get(part) if isinstance(result, dict) else None
+            return compact({'key': key, 'flags': flags, 'result': result})
+
+    def object_model_copy(self):
+        with self.lock:
+            self.animate()
+            return copy.deepcopy(self.model)
+
+    def filelist(self, directory, first):
+        entries = self.tree.listing(directory)
+        if entries is None:
+            return {'err': 2}
+        page = self.args.page_size if self.args.page_size > 0 else len(entries)
+        files = entries[first:first + page]
+        next_item = first + page if first + page < len(entries) else 0
+        return {'dir': directory, 'first': first, 'files': files, 'next': next_item}
+
+    def sbc_directory(self, directory):
+        entries = self.tree.listing(directory)
+        if entries is None:
+            return None
+        return [{'type': entry['type'], 'name': entry['name'], 'size': entry['size'],
+                 'lastModified': entry['date']} for entry in entries]
+
+    def fileinfo(self, name):
+        if name and not self.tree.contains(name):
+            return {'err': 1}
+        info = dict(self.file_info)
+        if name:
+            info['fileName'] = name
+        return info
+
+    def gcode(self, code):
+        with self.lock:
+            self.gcodes.append(code)
+            if code.strip().upper().startswith('M115'):
+                board = self.model.get('boards', [{}])[0]
+                self.reply = 'FIRMWARE_NAME: %s FIRMWARE_VERSION: %s' % (board.get('firmwareName', 'RepRapFirmware'),
+                                                                          board.get('firmwareVersion', '3.3'))
+            seqs = self.model.setdefault('seqs', {})
+            seqs['reply'] = seqs.get('reply', 0) + 1
+
+    def take_reply(self):
+        with self.lock:
+            reply, self.reply = self.reply, ''
+            return reply
+
+    def inject_faults(self):
+        """Sleep for the configured latency
+        :return: False if the request is to be dropped"""
+        args = self.args
+        delay = args.latency + random.uniform(0, args.jitter)
+        if delay > 0:
+            time.sleep(delay / 1000)
+        return random.uniform(0, 100) >= args.drop
+
+
+class DuetHttpHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'     # keep-alive like the Duet, the HTTP pool of the panel relies on it
+    duet = None
+    authorised = set()
+
+    def log_message(self, fmt, *args):
+        if self.duet.args.verbose:
+            super().log_message(fmt, *args)
+
+    def do_GET(self):
+        self._handle()
+
+    def do_POST(self):
+        self._handle()
+
+    def _handle(self):
+        duet = self.duet
+        url = urlparse(self.path)
+        query = {key: values[0] for key, values in parse_qs(url.query, keep_blank_values=True).items()}
+        duet.stats['/'.join(url.path.split('/')[:3])] += 1    # /machine/directory/<path> counts as one endpoint
+        if not duet.inject_faults():
+            duet.stats['dropped'] += 1
+            self.close_connection = True
+            self.connection.shutdown(socket.SHUT_RDWR)     # client sees a reset connection, not an HTTP error
+            return
+        if url.path == '/machine' and self.headers.get('Upgrade', '').lower() == 'websocket':
+            self._handle_websocket()
+        elif url.path.startswith('/machine/'):
+            self._handle_sbc(url.path[len('/machine/'):], query)
+        else:
+            self._handle_standalone(url.path, query)
+
+    def _handle_standalone(self, path, query):
+        duet = self.duet
+        if duet.args.sbc:
+            return self._send(404, 'text/plain', 'Not found')
+        if path == '/rr_connect':
+            if duet.args.password and query.get('password') != duet.args.password:
+                return self._send_json({'err': 1})
+            self.authorised.add(self.client_address[0])
+            response = {'err': 0, 'sessionTimeout': 8000, 'boardType': 'duetwifi102'}
+            if duet.args.rrf == 3:
+                response['apiLevel'] = 1
+            return self._send_json(response)
+        if duet.args.password and self.client_address[0] not in self.authorised:
+            return self._send(401, 'text/plain', '')
+        if path == '/rr_disconnect':
+            self.authorised.discard(self.client_address[0])
+            return self._send_json({'err': 0})
+        if path == '/rr_status':
+            return self._send(200, 'application/json', duet.rrf2(int(query.get('type', 1))))
+        if path == '/rr_model' and duet.args.rrf == 3:
+            return self._send(200, 'application/json', duet.object_model(query.get('key', ''), query.get('flags', '')))
+        if path == '/rr_gcode':
+            duet.gcode(query.get('gcode', ''))
+            return self._send_json({'buff': 255})
+        if path == '/rr_reply':
+            return self._send(200, 'text/plain', duet.take_reply())
+        if path == '/rr_filelist':
+            return self._send_json(duet.filelist(query.get('dir', '0:/gcodes'), int(query.get('first', 0))))
+        if path == '/rr_fileinfo':
+            return self._send_json(duet.fileinfo(query.get('name', '')))
+        if path == '/rr_download':
+            return self._send_download(query.get('name', ''))
+        self._send(404, 'text/plain', 'Not found')
+
+    def _handle_sbc(self, path, query):
+        duet = self.duet
+        if not duet.args.sbc:
+            return self._send(404, 'text/plain', 'Not found')
+        if path == 'connect':
+            if duet.args.password and query.get('password') != duet.args.password:
+                return self._send(403, 'text/plain', '')
+            return self._send_json({'sessionKey': random.randint(1, 1 << 30)})
+        if path == 'disconnect':
+            return self._send(204, 'text/plain', '')
+        if path == 'status':
+            return self._send(200, 'application/json', duet.object_model('', '', sbc=True))
+        if path == 'code':
+            length = int(self.headers.get('Content-Length', 0))
+            duet.gcode(self.rfile.read(length).decode(errors='replace'))
+            return self._send(200, 'text/plain', duet.take_reply())
+        if path.startswith('directory/'):
+            listing = duet.sbc_directory(unquote(path[len('directory/'):]))
+            if listing is None:
+                return self._send(404, 'text/plain', 'Not found')
+            return self._send_json(listing)
+        if path.startswith('fileinfo'):
+            info = duet.fileinfo(unquote(path[len('fileinfo/'):]))
+            if info.get('err'):
+                return self._send(404, 'text/plain', 'Not found')
+            return self._send_json(info)
+        if path.startswith('file/'):
+            return self._send_download(unquote(path[len('file/'):]))
+        self._send(404, 'text/plain', 'Not found')
+
+    def _handle_websocket(self):
+        """DSF object model subscription: whole model first, then a merge patch after every OK from the client"""
+        if not self.duet.args.sbc:
+            return self._send(404, 'text/plain', 'Not found')
+        accept = hashlib.sha1((self.headers.get('Sec-WebSocket-Key', '') + WS_GUID).encode()).digest()
+        self.send_response(101)
+        self.send_header('Upgrade', 'websocket')
+        self.send_header('Connection', 'Upgrade')
+        self.send_header('Sec-WebSocket-Accept', base64.b64encode(accept).decode())
+        self.end_headers()
+        self.close_connection = True
+        model = self.duet.object_model_copy()
+        self._ws_send(compact(model))
+        try:
+            while True:
+                message = self._ws_receive()
+                if message is None:
+                    return
+                if message != 'OK\n':
+                    continue
+                patch = None
+                while patch is None:
+                    time.sleep(WS_PATCH_INTERVAL)
+                    new_model = self.duet.object_model_copy()
+                    patch = merge_patch(model, new_model)
+                model = new_model
+                self.duet.stats['/machine (ws patch)'] += 1
+                self._ws_send(compact(patch))
+        except (ConnectionError, OSError):
+            return
+
+    def _ws_send(self, text, opcode=0x1):
+        data = text.encode()
+        if len(data) < 126:
+            header = bytes([0x80 | opcode, len(data)])
+        elif len(data) < 65536:
+            header = bytes([0x80 | opcode, 126]) + len(data).to_bytes(2, 'big')
+        else:
+            header = bytes([0x80 | opcode, 127]) + len(data).to_bytes(8, 'big')
+        self.wfile.write(header + data)
+        self.wfile.flush()
+
+    def _ws_receive(self):
+        """Read the next text message. Answers pings
+        :return: None once the connection was closed"""
+        while True:
+            header = self.rfile.read(2)
+            if len(header) < 2:
+                return None
+            opcode, length = header[0] & 0x0F, header[1] & 0x7F
+            if length == 126:
+                length = int.from_bytes(self.rfile.read(2), 'big')
+            elif length == 127:
+                length = int.from_bytes(self.rfile.read(8), 'big')
+            mask = self.rfile.read(4) if header[1] & 0x80 else bytes(4)
+            payload = bytes(b ^ mask[i % 4] for i, b in enumerate(self.rfile.read(length)))
+            if opcode == 0x8:
+                return None
+            if opcode == 0x9:
+                self._ws_send(payload.decode(errors='replace'), opcode=0xA)
+            elif opcode in (0x1, 0x2):
+                return payload.decode(errors='replace')
+
+    def _send_download(self, name):
+        path = self.duet.downloads.get(name)
+        if path is None:
+            return self._send(404, 'text/plain', 'Not found')
+        with open(path, 'rb') as f:
+            self._send(200, 'application/octet-stream', f.read())
+
+    def _send_json(self, obj):
+        self._send(200, 'application/json', compact(obj))
+
+    def _send(self, code, content_type, body):
+        if isinstance(body, str):
+            body = body.encode()
+        self.send_response(code)
+        self.send_header('Content-Type', content_type)
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+
+class SerialPort(threading.Thread):
+    """PanelDue port of the Duet on a pseudo terminal. One JSON object per line like the firmware sends it"""
+
+    M409 = re.compile(r'M409(?:\s+K"([^"]*)")?(?:\s+F"([^"]*)")?')
+    M20 = re.compile(r'M20(?:\s+S\d)?\s+P"([^"]*)"(?:\s+R(\d+))?')
+    M36 = re.compile(r'M36\s+"([^"]*)"')
+
+    def __init__(self, duet):
+        super().__init__(daemon=True)
+        self.duet = duet
+        self.master, self.slave = os.openpty()
+        tty.setraw(self.slave)
+        self.name = os.ttyname(self.slave)
+
+    def run(self):
+        pending = b''
+        while True:
+            data = os.read(self.master, 1024)
+            if not data:
+                return
+            pending += data
+            while b'\n' in pending:
+                line, pending = pending.split(b'\n', 1)
+                self._handle(line.decode(errors='replace').strip())
+
+    def _handle(self, line):
+        line = re.sub(r'^N\d+\s+', '', line).split('*')[0].strip()     # line number & checksum if any
+        if not line:
+            return
+        duet = self.duet
+        duet.stats['serial ' + line.split()[0]] += 1
+        if not duet.inject_faults():
+            duet.stats['dropped'] += 1
+            return
+        if line.startswith('M408'):
+            response = duet.serial_rrf2(line)
+        elif line.startswith('M409') and duet.args.rrf == 3:
+            match = self.M409.match(line)
+            response = duet.object_model(match.group(1) or '', match.group(2) or '')
+        elif line.startswith('M20'):
+            match = self.M20.match(line)
+            response = compact(duet.filelist(match.group(1) if match else '0:/gcodes',
+                                             int(match.group(2)) if match and match.group(2) else 0))
+        elif line.startswith('M36'):
+            match = self.M36.match(line)
+            response = compact(duet.fileinfo(match.group(1) if match else ''))
+        else:
+            duet.gcode(line)
+            return
+        self._write(response + '\n')
+
+    def _write(self, text):
+        data = text.encode()
+        baud = self.duet.args.baud
+        for pos in range(0, len(data), 64):
+            os.write(self.master, data[pos:pos + 64])
+            if baud > 0:
+                time.sleep(64 * 10 / baud)    # 8N1 takes 10 bits per byte
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Mock Duet for testing RepPanel without a printer')
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=80)
+    parser.add_argument('--fixtures', default=FIXTURES_DIR, help='directory with the captured responses')
+    parser.add_argument('--rrf', type=int, choices=(2, 3), default=3, help='firmware version to emulate')
+    parser.add_argument('--sbc', action='store_true', help='serve the /machine/* API of a Duet SBC instead of rr_*')
+    parser.add_argument('--password', default='', help='require rr_connect with this password')
+    parser.add_argument('--serial', action='store_true', help='open a pseudo terminal that acts as PanelDue port')
+    parser.add_argument('--baud', type=int, default=57600, help='pace serial responses. 0 to disable')
+    parser.add_argument('--latency', type=float, default=0, help='[ms] added to every response')
+    parser.add_argument('--jitter', type=float, default=0, help='[ms] random extra latency up to this value')
+    parser.add_argument('--drop', type=float, default=0, help='[%%] requests that are dropped without response')
+    parser.add_argument('--files', type=int, default=20, help='number of files in 0:/gcodes')
+    parser.add_argument('--dirs', type=int, default=3, help='number of sub folders per folder in 0:/gcodes')
+    parser.add_argument('--depth', type=int, default=1, help='nesting depth of the folders in 0:/gcodes')
+    parser.add_argument('--page-size', type=int, default=0, help='max. entries per rr_filelist response. 0=all')
+    parser.add_argument('--animate', action='store_true', help='let temperatures drift between requests')
+    parser.add_argument('--verbose', '-v', action='store_true', help='log every HTTP request')
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+    duet = MockDuet(args)
+    DuetHttpHandler.duet = duet
+    server = ThreadingHTTPServer((args.host, args.port), DuetHttpHandler)
+    server.daemon_threads = True
+    print('Mock Duet (RRF%i%s) listening on %s:%i' % (args.rrf, ' SBC' if args.sbc else '', args.host, args.port))
+    if args.serial:
+        serial = SerialPort(duet)
+        serial.start()
+        print('PanelDue port on %s' % serial.name)
+
+    def shutdown(*_):
+        threading.Thread(target=server.shutdown).start()
+
+    signal.signal(signal.SIGTERM, shutdown)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print('\nRequests served:')
+    for name, count in sorted(duet.stats.items()):
+        print('  %-24s %i' % (name, count))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())